@@ -2,6 +2,7 @@
 #include "../vm/asm.h"
 
 #include "../vm/ir/be/int3.h"
+#include "../vm/ir/be/x64.h"
 #include "../vm/ir/build.h"
 #include "../vm/ir/toir.h"
 
@@ -30,13 +31,36 @@ static char *vm_asm_io_read(const char *filename) {
     return ops;
 }
 
+// fnv-1a, keys type profiles to the bytecode they were written for
+static uint64_t vm_asm_hash(const void *ptr, size_t size) {
+    const uint8_t *bytes = ptr;
+    uint64_t hash = 0xCBF29CE484222325llu;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3llu;
+    }
+    return hash;
+}
+
 int main(int argc, char **argv) {
     bool iiiclose = false;
     FILE *iii = NULL;
     const char *iit = NULL;
     const char *dump = NULL;
     const char *filename = NULL;
+    const char *profile = NULL;
     size_t jit = 1;
+    size_t jitx64 = 0;
+    size_t jitpairs = 0;
+    size_t jitcounts = 0;
+    const char *sample = NULL;
+    size_t jitinline = VM_INT_INLINE_BUDGET;
+    size_t jitinlinestats = 0;
+    size_t jitprecompile = 0;
+    size_t jitcompstats = 0;
+    size_t gcslice = VM_CONFIG_GC_SLICE;
+    size_t gcthreads = VM_CONFIG_GC_THREADS;
+    size_t gcstats = 0;
     size_t runs = 1;
     size_t jitdumpir = 0;
     size_t jitdumpopt = 0;
@@ -57,6 +81,18 @@ int main(int argc, char **argv) {
             argc -= 1;
             continue;
         }
+        if (!strcmp(argv[1], "--precompile")) {
+            argv += 1;
+            argc -= 1;
+            jitprecompile = 1;
+            continue;
+        }
+        if (!strcmp(argv[1], "--jit-stats")) {
+            argv += 1;
+            argc -= 1;
+            jitcompstats = 1;
+            continue;
+        }
         if (!strcmp(argv[1], "-n")) {
             argv += 1;
             argc -= 1;
@@ -80,6 +116,32 @@ int main(int argc, char **argv) {
                 jitdumpir = 1;
             } else if (!strcmp(tmp, "dump=opt")) {
                 jitdumpopt = 1;
+            } else if (!strcmp(tmp, "be=x64")) {
+                jitx64 = 1;
+            } else if (!strcmp(tmp, "be=int3")) {
+                jitx64 = 0;
+            } else if (!strcmp(tmp, "pairs")) {
+                jitpairs = 1;
+            } else if (!strcmp(tmp, "counts")) {
+                jitcounts = 2;
+            } else if (!strcmp(tmp, "counts=blocks")) {
+                jitcounts = 1;
+            } else if (!strncmp(tmp, "inline=", 7)) {
+                jitinline = (size_t)strtoul(tmp + 7, NULL, 10);
+            } else if (!strcmp(tmp, "inline-stats")) {
+                jitinlinestats = 1;
+            } else if (!strcmp(tmp, "comp-stats")) {
+                jitcompstats = 1;
+            } else if (!strncmp(tmp, "gc-slice=", 9)) {
+                gcslice = (size_t)strtoul(tmp + 9, NULL, 10);
+            } else if (!strncmp(tmp, "gc-threads=", 11)) {
+                gcthreads = (size_t)strtoul(tmp + 11, NULL, 10);
+            } else if (!strcmp(tmp, "gc-stats")) {
+                gcstats = 1;
+            } else if (!strncmp(tmp, "sample=", 7)) {
+                sample = tmp + 7;
+            } else if (!strncmp(tmp, "profile=", 8)) {
+                profile = tmp + 8;
             } else if (tmp[0] == 'i' && tmp[1] == 't') {
                 iit = argv[1];
                 argv += 1;
@@ -141,28 +203,65 @@ int main(int argc, char **argv) {
             vm_ir_block_t *cur = &blocks[0];
             vm_int_state_t state = (vm_int_state_t){0};
 
-            size_t nregs = 1 << 16;
-            vm_value_t *locals = vm_alloc0(sizeof(vm_value_t) * nregs);
             state.debug_print_instrs = iii;
-            state.framesize = 1;
             state.funcs = NULL;
-            for (size_t j = 0; j < nblocks; j++) {
-                if (blocks[j].id >= 0) {
-                    if (blocks[j].nregs >= state.framesize) {
-                        state.framesize = blocks[j].nregs + 1;
-                    }
-                }
-            }
-            state.locals = locals;
-            state.heads = vm_malloc(sizeof(vm_int_opcode_t *) * (nregs / state.framesize + 1));
+            state.inline_budget = jitinline;
+            state.precompile = jitprecompile != 0;
+            vm_int_stack_init(&state, nblocks, blocks);
             if (iit != NULL) {
                 state.use_spall = true;
                 state.spall_ctx = vm_trace_init(iit, 0.000303);
                 vm_trace_begin(&state.spall_ctx, NULL, vm_trace_time(), "MiniVM Invocation");
             }
-            vm_gc_init(&state.gc, nregs, locals);
-            vm_int_run(&state, cur);
+            if (jitpairs) {
+                vm_int_pairs_init(&state);
+            }
+            if (jitcounts) {
+                vm_int_counts_init(&state, nblocks, jitcounts == 2);
+            }
+            if (sample != NULL && !vm_int_sample_init(&state, sample)) {
+                fprintf(stderr, "cannot sample to %s\n", sample);
+                return 1;
+            }
+            uint64_t hash = vm_asm_hash(buf.ops, sizeof(vm_opcode_t) * buf.nops);
+            // only int3 compiles a profile ahead of time, any backend can write one
+            if (profile != NULL && !jitx64) {
+                vm_int_profile_read(&state, profile, hash, nblocks, blocks);
+            }
+            vm_gc_init(&state.gc, state.framesize * state.stack_frames, state.stack);
+            state.gc.slice = gcslice;
+            state.gc.threads = gcthreads;
+            if (jitx64) {
+                vm_x64_run(&state, cur);
+            } else {
+                vm_int_run(&state, cur);
+            }
+            if (sample != NULL) {
+                vm_int_sample_deinit(&state);
+            }
+            if (gcstats) {
+                vm_gc_stats_print(&state.gc, stderr);
+            }
             vm_gc_deinit(&state.gc);
+            vm_int_stack_deinit(&state);
+            if (profile != NULL) {
+                vm_int_profile_write(profile, hash, nblocks, blocks);
+            }
+            if (jitinlinestats) {
+                fprintf(stderr, "inlined call sites: %zu\n", state.inlined);
+            }
+            if (jitcompstats) {
+                vm_int_comp_stats_print(&state, stderr);
+            }
+            if (jitpairs) {
+                vm_int_pairs_print(&state, stderr, 20);
+                vm_free(state.pair_counts);
+            }
+            if (jitcounts) {
+                vm_int_counts_print(&state, stderr, 20);
+                vm_free(state.op_counts);
+                vm_free(state.block_counts);
+            }
             if (iit != NULL) {
                 vm_trace_end(&state.spall_ctx, NULL, vm_trace_time());
                 vm_trace_quit(&state.spall_ctx);
@@ -0,0 +1,100 @@
+#include "../vm/asm.h"
+#include "../vm/ir/be/c.h"
+#include "../vm/ir/build.h"
+#include "../vm/ir/toir.h"
+
+static char *vm_asm_io_read(const char *filename) {
+    void *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    size_t nalloc = 16;
+    char *ops = vm_malloc(sizeof(char) * nalloc);
+    size_t nops = 0;
+    size_t size;
+    for (;;) {
+        size = fread(&ops[nops], sizeof(char), 1, file);
+        if (size == 0) {
+            break;
+        }
+        nops += 1;
+        if (nops + 4 >= nalloc) {
+            nalloc *= 4;
+            ops = vm_realloc(ops, sizeof(char) * nalloc);
+        }
+    }
+    ops[nops] = '\0';
+    fclose(file);
+    return ops;
+}
+
+int main(int argc, char **argv) {
+    const char *dump = NULL;
+    const char *filename = NULL;
+    size_t jitdumpir = 0;
+    while (true) {
+        if (argc < 2) {
+            if (filename == NULL) {
+                fprintf(stderr, "too few args\n");
+                return 1;
+            } else {
+                break;
+            }
+        }
+        if (!strcmp(argv[1], "-o") || !strcmp(argv[1], "--output")) {
+            argv += 1;
+            argc -= 1;
+            dump = argv[1];
+            argv += 1;
+            argc -= 1;
+            continue;
+        }
+        if (argv[1][0] == '-' && argv[1][1] == 'i') {
+            char *tmp = argv[1] + 2;
+            argv += 1;
+            argc -= 1;
+            if (!strcmp(tmp, "dump=pre")) {
+                jitdumpir = 1;
+            } else {
+                fprintf(stderr, "unknown -i option: -i%s\n", tmp);
+                return 1;
+            }
+            continue;
+        }
+        if (filename != NULL) {
+            fprintf(stderr, "cannot handle multiple files at cli\n");
+            return 1;
+        } else {
+            filename = argv[1];
+            argv += 1;
+            argc -= 1;
+        }
+    }
+    char *src = vm_asm_io_read(filename);
+    if (src == NULL) {
+        fprintf(stderr, "could not read file\n");
+        return 1;
+    }
+    vm_bc_buf_t buf = vm_asm(src);
+    size_t nblocks = buf.nops;
+    vm_ir_block_t *blocks = vm_ir_parse(nblocks, buf.ops);
+    if (jitdumpir) {
+        vm_ir_print_blocks(stderr, nblocks, blocks);
+    }
+    FILE *out = stdout;
+    if (dump != NULL) {
+        out = fopen(dump, "w");
+        if (out == NULL) {
+            fprintf(stderr, "error opening output file\n");
+            return 1;
+        }
+    }
+    vm_ir_be_c(out, nblocks, blocks);
+    if (out != stdout) {
+        fclose(out);
+    }
+    vm_ir_blocks_free(nblocks, blocks);
+    vm_free(buf.ops);
+    vm_free(src);
+    return 0;
+}
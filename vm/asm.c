@@ -70,30 +70,56 @@ size_t vm_asm_read_reg(const char **src) {
     return n;
 }
 
-#define vm_asm_put(type_, value_)             \
-    ({                                        \
-        instrs[head].type = (type_);          \
-        instrs[head].value = (value_);        \
+#define vm_asm_put(type_, value_)                                                  \
+    do {                                                                           \
+        instrs[head].type = (type_);                                               \
+        instrs[head].value = (value_);                                             \
         /*printf("intrs[%i] = {%i, %i}\n", (int) head, (int) type, (int) value);*/ \
-        head += 1; \
-    })
+        head += 1;                                                                 \
+    } while (0)
 #define vm_asm_put_op(op_) vm_asm_put((VM_ASM_INSTR_RAW), (op_))
 #define vm_asm_put_reg(reg_)                 \
-    ({                                       \
+    do {                                     \
         size_t r = reg_;                     \
         if (r > nregs) {                     \
             nregs = r;                       \
         }                                    \
         vm_asm_put((VM_ASM_INSTR_RAW), (r)); \
-    })
+    } while (0)
 #define vm_asm_put_int(int_) vm_asm_put((VM_ASM_INSTR_RAW), (int_))
+// the rest of the line as a call's arg count then its arg registers, with
+// room made for as many as there are
+#define vm_asm_put_args()                                                      \
+    do {                                                                       \
+        size_t nargs = 0;                                                      \
+        size_t aargs = 8;                                                      \
+        size_t *args = vm_malloc(sizeof(size_t) * aargs);                      \
+        vm_asm_strip(src);                                                     \
+        while (**src != '\n' && **src != '\r') {                               \
+            if (nargs == aargs) {                                              \
+                aargs *= 2;                                                    \
+                args = vm_realloc(args, sizeof(size_t) * aargs);               \
+            }                                                                  \
+            args[nargs++] = vm_asm_read_reg(src);                              \
+            vm_asm_strip(src);                                                 \
+        }                                                                      \
+        if (head + nargs + 16 > alloc) {                                       \
+            alloc = (head + nargs) * 4 + 16;                                   \
+            instrs = vm_realloc(instrs, sizeof(vm_asm_instr_t) * alloc);       \
+        }                                                                      \
+        vm_asm_put_int(nargs);                                                 \
+        for (size_t i = 0; i < nargs; i++) {                                   \
+            vm_asm_put_reg(args[i]);                                           \
+        }                                                                      \
+        vm_free(args);                                                         \
+    } while (0)
 #define vm_asm_put_set(name_)                            \
-    ({                                                   \
+    do {                                                 \
         *nsets += 1;                                     \
         vm_asm_put((VM_ASM_INSTR_SET), (size_t)(name_)); \
-    })
+    } while (0)
 #define vm_asm_put_get(name_) vm_asm_put((VM_ASM_INSTR_GET), (size_t)(name_))
-#define vm_asm_put_seti(num_) ({ vm_asm_put((VM_ASM_INSTR_SETI), (num_)); })
+#define vm_asm_put_seti(num_) vm_asm_put((VM_ASM_INSTR_SETI), (num_))
 #define vm_asm_put_geti(num_) vm_asm_put((VM_ASM_INSTR_GETI), (num_))
 
 vm_asm_instr_t *vm_asm_read(const char **src, size_t *nsets, size_t *nlinks) {
@@ -226,68 +252,28 @@ vm_asm_instr_t *vm_asm_read(const char **src, size_t *nsets, size_t *nlinks) {
                     vm_asm_strip(src);
                     vm_asm_put_get(*src);
                     *src += vm_asm_word(*src);
-                    size_t args[8] = {0};
-                    size_t nargs = 0;
-                    vm_asm_strip(src);
-                    while (**src != '\n' && **src != '\r') {
-                        args[nargs++] = vm_asm_read_reg(src);
-                        vm_asm_strip(src);
-                    }
-                    vm_asm_put_int(nargs);
-                    for (size_t i = 0; i < nargs; i++) {
-                        vm_asm_put_reg(args[i]);
-                    }
+                    vm_asm_put_args();
                     continue;
                 }
                 if (vm_asm_starts(opname, "ccall")) {
                     vm_asm_put_op(VM_OPCODE_CCALL);
                     vm_asm_put_reg(regno);
                     vm_asm_put_reg(vm_asm_read_reg(src));
-                    size_t args[8] = {0};
-                    size_t nargs = 0;
-                    vm_asm_strip(src);
-                    while (**src != '\n' && **src != '\r') {
-                        args[nargs++] = vm_asm_read_reg(src);
-                        vm_asm_strip(src);
-                    }
-                    vm_asm_put_int(nargs);
-                    for (size_t i = 0; i < nargs; i++) {
-                        vm_asm_put_reg(args[i]);
-                    }
+                    vm_asm_put_args();
                     continue;
                 }
                 if (vm_asm_starts(opname, "dcall")) {
                     vm_asm_put_op(VM_OPCODE_DCALL);
                     vm_asm_put_reg(regno);
                     vm_asm_put_reg(vm_asm_read_reg(src));
-                    size_t args[8] = {0};
-                    size_t nargs = 0;
-                    vm_asm_strip(src);
-                    while (**src != '\n' && **src != '\r') {
-                        args[nargs++] = vm_asm_read_reg(src);
-                        vm_asm_strip(src);
-                    }
-                    vm_asm_put_int(nargs);
-                    for (size_t i = 0; i < nargs; i++) {
-                        vm_asm_put_reg(args[i]);
-                    }
+                    vm_asm_put_args();
                     continue;
                 }
                 if (vm_asm_starts(opname, "xcall")) {
                     vm_asm_put_op(VM_OPCODE_XCALL);
                     vm_asm_put_reg(regno);
                     vm_asm_put_int(vm_asm_read_int(src));
-                    size_t args[8] = {0};
-                    size_t nargs = 0;
-                    vm_asm_strip(src);
-                    while (**src != '\n' && **src != '\r') {
-                        args[nargs++] = vm_asm_read_reg(src);
-                        vm_asm_strip(src);
-                    }
-                    vm_asm_put_int(nargs);
-                    for (size_t i = 0; i < nargs; i++) {
-                        vm_asm_put_reg(args[i]);
-                    }
+                    vm_asm_put_args();
                     continue;
                 }
                 if (vm_asm_starts(opname, "add")) {
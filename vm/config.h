@@ -13,6 +13,114 @@
 #if !defined(VM_CONFIG_GROW_STACK)
 #define VM_CONFIG_GROW_STACK (1)
 #endif
+
+#if !defined(VM_CONFIG_STACK_LIMIT_FRAMES)
+#define VM_CONFIG_STACK_LIMIT_FRAMES 64
+#endif
+
+#if !defined(VM_CONFIG_X64_CODE_SIZE)
+#define VM_CONFIG_X64_CODE_SIZE (1 << 26)
+#endif
+
+#if !defined(VM_CONFIG_X64_NATIVE_STACK)
+#define VM_CONFIG_X64_NATIVE_STACK ((size_t)1 << 30)
+#endif
+
+#if !defined(VM_CONFIG_X64_NATIVE_MARGIN)
+#define VM_CONFIG_X64_NATIVE_MARGIN ((size_t)1 << 20)
+#endif
+
+#if !defined(VM_CONFIG_GC_NURSERY)
+#define VM_CONFIG_GC_NURSERY (1 << 22)
+#endif
+
+#if !defined(VM_CONFIG_GC_YOUNG_MAX)
+#define VM_CONFIG_GC_YOUNG_MAX 1024
+#endif
+
+#if !defined(VM_CONFIG_GC_SLAB_SLOTS)
+#define VM_CONFIG_GC_SLAB_SLOTS 16
+#endif
+
+#if !defined(VM_CONFIG_GC_SLAB_PAGE)
+#define VM_CONFIG_GC_SLAB_PAGE (1 << 16)
+#endif
+
+#if !defined(VM_CONFIG_GC_SLICE)
+#define VM_CONFIG_GC_SLICE 0
+#endif
+
+#if !defined(VM_CONFIG_GC_THREADS)
+#define VM_CONFIG_GC_THREADS 1
+#endif
+
+#if !defined(VM_CONFIG_GC_PARALLEL_MIN)
+#define VM_CONFIG_GC_PARALLEL_MIN (1 << 16)
+#endif
+
+#if !defined(VM_CONFIG_GC_PREFETCH)
+#define VM_CONFIG_GC_PREFETCH 8
+#endif
+
+#if !defined(VM_CONFIG_SAMPLE_HZ)
+#define VM_CONFIG_SAMPLE_HZ 1000
+#endif
+
+#if !defined(VM_CONFIG_SAMPLE_DEPTH)
+#define VM_CONFIG_SAMPLE_DEPTH 256
+#endif
+
+#if !defined(VM_CONFIG_SAMPLE_SLOTS)
+#define VM_CONFIG_SAMPLE_SLOTS (1 << 22)
+#endif
+
+#if !defined(VM_CONFIG_C_STACK)
+#define VM_CONFIG_C_STACK (1 << 20)
+#endif
+
+#if !defined(VM_CONFIG_C_NATIVE_STACK)
+#define VM_CONFIG_C_NATIVE_STACK ((size_t)1 << 30)
+#endif
+#endif
+
+#if !defined(VM_IR_TAIL_CALLS)
+#define VM_IR_TAIL_CALLS 1
+#endif
+
+#if !defined(VM_INT_MAX_VERSIONS)
+#define VM_INT_MAX_VERSIONS 256
+#endif
+
+#if !defined(VM_INT_INLINE_BUDGET)
+#define VM_INT_INLINE_BUDGET 8
+#endif
+
+#if !defined(VM_INT_LOOP_SPEC)
+#define VM_INT_LOOP_SPEC 1
+#endif
+
+#if !defined(VM_INT_OVERFLOW)
+#define VM_INT_OVERFLOW 1
+#endif
+
+#if !defined(VM_INT_COMPACT)
+#define VM_INT_COMPACT 0
+#endif
+
+#if !defined(VM_INT_TAIL)
+#define VM_INT_TAIL 0
+#endif
+
+#if !defined(VM_INT_SWITCH)
+#define VM_INT_SWITCH 0
+#endif
+
+#if VM_INT_TAIL && VM_INT_SWITCH
+#error "VM_INT_TAIL and VM_INT_SWITCH are different dispatch modes, pick one"
+#endif
+
+#if !defined(VM_INT_FUSE)
+#define VM_INT_FUSE 1
 #endif
 
 #if !defined(VM_INT_DEBUG_OPCODE)
@@ -1,7 +1,19 @@
+// clock_gettime and the worker threads are posix, not c11, so ask for them
+// before any system header is read
+#if !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #include "gc.h"
 
 #include "nanbox.h"
 
+#if !defined(_WIN32) && !defined(VM_WASM)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
 size_t vm_gc_table_size(vm_value_table_t *tab) {
     static const size_t table[] =
         {
@@ -143,112 +155,837 @@ static inline size_t vm_gc_table_modsize(uint8_t index, size_t hash) {
 }
 
 void vm_gc_init(vm_gc_t *gc, size_t nstack, vm_value_t *stack) {
+    *gc = (vm_gc_t){0};
     gc->len = 0;
     gc->alloc = 256;
     gc->vals = vm_malloc(sizeof(vm_value_t) * gc->alloc);
     gc->nstack = nstack;
     gc->stack = stack;
     gc->max = 256;
+    gc->slice = VM_CONFIG_GC_SLICE;
+    gc->threads = VM_CONFIG_GC_THREADS;
+    if (VM_CONFIG_GC_NURSERY != 0) {
+        gc->young_size = VM_CONFIG_GC_NURSERY;
+        gc->young = vm_malloc(gc->young_size);
+    }
 }
 
 void vm_gc_deinit(vm_gc_t *gc) {
+    for (size_t i = 0; i < gc->pages_len; i++) {
+        vm_free(gc->pages[i]);
+    }
+    vm_free(gc->pages);
     vm_free(gc->vals);
+    vm_free(gc->young);
+    vm_free(gc->remembered);
+    vm_free(gc->gray);
+}
+
+static void vm_gc_push(vm_gc_t *gc, vm_value_t value) {
+    if (gc->len + 1 >= gc->alloc) {
+        gc->alloc = gc->len * 2;
+        gc->vals = vm_realloc(gc->vals, sizeof(vm_value_t) * gc->alloc);
+    }
+    gc->vals[gc->len++] = value;
+}
+
+// every old object, collections are paced by this
+static inline size_t vm_gc_count(vm_gc_t *gc) {
+    return gc->len + gc->slab_used;
+}
+
+// a free slot has a zero tag and the next free slot where an array keeps its
+// data and a table its keys. swept is cleared on every page when a sweep
+// starts, slots handed out of a page it has yet to reach start marked
+struct vm_gc_page_t {
+    vm_gc_page_t *avail;
+    uint8_t *free;
+    uint32_t cls;
+    uint32_t size;
+    uint32_t count;
+    uint32_t used;
+    bool listed;
+    bool swept;
+    uint64_t slots[];
+};
+
+#define VM_GC_SLAB_MAX (sizeof(vm_value_array_t) + sizeof(vm_value_t) * VM_CONFIG_GC_SLAB_SLOTS)
+
+#define vm_gc_slot_next(slot_) (*(uint8_t **)((slot_) + sizeof(void *)))
+
+static void vm_gc_page_list(vm_gc_t *gc, vm_gc_page_t *page) {
+    if (page->free != NULL && !page->listed) {
+        page->listed = true;
+        page->avail = gc->avail[page->cls];
+        gc->avail[page->cls] = page;
+    }
+}
+
+static vm_gc_page_t *vm_gc_page_new(vm_gc_t *gc, size_t cls) {
+    size_t size = sizeof(vm_value_array_t) + sizeof(vm_value_t) * cls;
+    size_t count = (VM_CONFIG_GC_SLAB_PAGE - sizeof(vm_gc_page_t)) / size;
+    vm_gc_page_t *page = vm_malloc(sizeof(vm_gc_page_t) + size * count);
+    *page = (vm_gc_page_t){
+        .cls = (uint32_t)cls,
+        .size = (uint32_t)size,
+        .count = (uint32_t)count,
+        // nothing in it to sweep yet
+        .swept = true,
+    };
+    // threaded back to front so slots are handed out in address order
+    uint8_t *slots = (uint8_t *)page->slots;
+    for (size_t i = count; i-- > 0;) {
+        uint8_t *slot = &slots[i * size];
+        slot[0] = VM_TYPE_UNKNOWN;
+        vm_gc_slot_next(slot) = page->free;
+        page->free = slot;
+    }
+    if (gc->pages_len + 1 >= gc->pages_alloc) {
+        gc->pages_alloc = (gc->pages_len + 1) * 2;
+        gc->pages = vm_realloc(gc->pages, sizeof(vm_gc_page_t *) * gc->pages_alloc);
+    }
+    gc->pages[gc->pages_len++] = page;
+    vm_gc_page_list(gc, page);
+    return page;
+}
+
+// room for an old object, malloced and listed in vals if it is too large for
+// a slab. mark is what its mark byte has to start as
+static void *vm_gc_alloc(vm_gc_t *gc, size_t size, uint8_t *mark) {
+    if (size > VM_GC_SLAB_MAX) {
+        void *ptr = vm_malloc(size);
+        vm_gc_push(gc, vm_box_from_pointer(ptr));
+        *mark = gc->phase == VM_GC_MARKING ? VM_GC_MARKED : 0;
+        return ptr;
+    }
+    size_t cls = (size - sizeof(vm_value_array_t) + sizeof(vm_value_t) - 1) / sizeof(vm_value_t);
+    vm_gc_page_t *page = gc->avail[cls];
+    while (page != NULL && page->free == NULL) {
+        page->listed = false;
+        page = page->avail;
+    }
+    gc->avail[cls] = page;
+    if (page == NULL) {
+        page = vm_gc_page_new(gc, cls);
+    }
+    uint8_t *slot = page->free;
+    page->free = vm_gc_slot_next(slot);
+    page->used += 1;
+    gc->slab_used += 1;
+    if (gc->phase == VM_GC_MARKING || (gc->phase == VM_GC_SWEEPING && !page->swept)) {
+        *mark = VM_GC_MARKED;
+    } else {
+        *mark = 0;
+    }
+    return slot;
+}
+
+void vm_gc_remember(vm_gc_t *gc, vm_value_t obj) {
+    // arrays and tables both keep their mark byte second
+    vm_value_array_t *head = vm_value_to_array(obj);
+    if (head->mark & VM_GC_REMEMBERED) {
+        return;
+    }
+    head->mark |= VM_GC_REMEMBERED;
+    if (gc->remembered_len + 1 >= gc->remembered_alloc) {
+        gc->remembered_alloc = (gc->remembered_len + 1) * 2;
+        gc->remembered = vm_realloc(gc->remembered, sizeof(vm_value_t) * gc->remembered_alloc);
+    }
+    gc->remembered[gc->remembered_len++] = obj;
 }
 
-static void vm_gc_mark(vm_value_t value) {
+static void vm_gc_gray(vm_gc_t *gc, vm_value_t value) {
+    if (gc->gray_len + 1 >= gc->gray_alloc) {
+        gc->gray_alloc = (gc->gray_len + 1) * 2;
+        gc->gray = vm_realloc(gc->gray, sizeof(vm_value_t) * gc->gray_alloc);
+    }
+    gc->gray[gc->gray_len++] = value;
+}
+
+void vm_gc_shade(vm_gc_t *gc, vm_value_t val) {
+    uint8_t type = vm_typeof(val);
+    if ((type == VM_TYPE_ARRAY || type == VM_TYPE_TABLE) && !(vm_value_to_array(val)->mark & VM_GC_MARKED)) {
+        vm_gc_gray(gc, val);
+    }
+}
+
+// one per marking thread. the owner pushes and takes at the bottom, the
+// others steal from the top (chase and lev). rings it outgrew are kept until
+// the mark is over, a thief may still be reading one
+typedef struct vm_gc_ring_t vm_gc_ring_t;
+typedef struct vm_gc_deque_t vm_gc_deque_t;
+
+struct vm_gc_ring_t {
+    vm_gc_ring_t *prev;
+    int64_t mask;
+    void *items[];
+};
+
+struct vm_gc_deque_t {
+    int64_t top;
+    int64_t bottom;
+    vm_gc_ring_t *ring;
+} __attribute__((aligned(64)));
+
+static vm_gc_ring_t *vm_gc_ring_new(int64_t size, vm_gc_ring_t *prev) {
+    vm_gc_ring_t *ring = vm_malloc(sizeof(vm_gc_ring_t) + sizeof(void *) * (size_t)size);
+    ring->prev = prev;
+    ring->mask = size - 1;
+    return ring;
+}
+
+static void vm_gc_deque_push(vm_gc_deque_t *dq, void *ptr) {
+    int64_t bottom = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED);
+    int64_t top = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    vm_gc_ring_t *ring = __atomic_load_n(&dq->ring, __ATOMIC_RELAXED);
+    if (bottom - top > ring->mask) {
+        vm_gc_ring_t *next = vm_gc_ring_new((ring->mask + 1) * 2, ring);
+        for (int64_t i = top; i < bottom; i++) {
+            next->items[i & next->mask] = __atomic_load_n(&ring->items[i & ring->mask], __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&dq->ring, next, __ATOMIC_RELEASE);
+        ring = next;
+    }
+    __atomic_store_n(&ring->items[bottom & ring->mask], ptr, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&dq->bottom, bottom + 1, __ATOMIC_RELAXED);
+}
+
+static void *vm_gc_deque_take(vm_gc_deque_t *dq) {
+    int64_t bottom = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+    vm_gc_ring_t *ring = __atomic_load_n(&dq->ring, __ATOMIC_RELAXED);
+    __atomic_store_n(&dq->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&dq->top, __ATOMIC_RELAXED);
+    if (top > bottom) {
+        __atomic_store_n(&dq->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    void *ptr = __atomic_load_n(&ring->items[bottom & ring->mask], __ATOMIC_RELAXED);
+    if (top == bottom) {
+        // the last one, a thief may be after it too
+        if (!__atomic_compare_exchange_n(&dq->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            ptr = NULL;
+        }
+        __atomic_store_n(&dq->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return ptr;
+}
+
+static void *vm_gc_deque_steal(vm_gc_deque_t *dq) {
+    int64_t top = __atomic_load_n(&dq->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t bottom = __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom) {
+        return NULL;
+    }
+    vm_gc_ring_t *ring = __atomic_load_n(&dq->ring, __ATOMIC_ACQUIRE);
+    void *ptr = __atomic_load_n(&ring->items[top & ring->mask], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&dq->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return ptr;
+}
+
+// the full mark leaves young arrays alone, a minor collection would move them
+// out from under the gray stack between two slices. marking threads push onto
+// their own deque instead
+static inline void vm_gc_trace(vm_gc_t *gc, vm_gc_deque_t *dq, vm_value_t value) {
+    if (vm_box_is_pointer(value) && !vm_gc_young(gc, vm_box_to_pointer(value))) {
+        if (dq != NULL) {
+            vm_gc_deque_push(dq, vm_box_to_pointer(value));
+        } else {
+            vm_gc_gray(gc, value);
+        }
+    }
+}
+
+// sets the mark bit, reporting whether it was this call that set it. with
+// more than one thread marking the bit is raced for
+static inline bool vm_gc_claim(uint8_t *mark, bool shared) {
+    if (shared) {
+        if (__atomic_load_n(mark, __ATOMIC_RELAXED) & VM_GC_MARKED) {
+            return false;
+        }
+        return !(__atomic_fetch_or(mark, VM_GC_MARKED, __ATOMIC_RELAXED) & VM_GC_MARKED);
+    }
+    if (*mark & VM_GC_MARKED) {
+        return false;
+    }
+    *mark |= VM_GC_MARKED;
+    return true;
+}
+
+static uint64_t vm_gc_now(void) {
+#if !defined(_WIN32) && !defined(VM_WASM)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+// frames are not cleared when entered, so a register left above high would
+// name whatever was collected under it by the time its frame is live again.
+// only frames since the last collection wrote past its high, up to gc->limit
+static void vm_gc_forget(vm_gc_t *gc, vm_value_t *high) {
+    size_t end = gc->nstack;
+    if (gc->margin != 0) {
+        size_t dirty = (size_t)(gc->limit - gc->stack) + gc->margin;
+        if (dirty < end) {
+            end = dirty;
+        }
+        if (high < gc->limit) {
+            gc->limit = high;
+        }
+    }
+    for (vm_value_t *cur = high; cur < gc->stack + end; cur++) {
+        if (vm_box_is_pointer(*cur)) {
+            *cur = vm_value_nil();
+        }
+    }
+}
+
+// moves a young array out to the old space the first time it is reached,
+// leaving where it went in its data pointer
+static void vm_gc_evacuate(vm_gc_t *gc, vm_value_t *slot) {
+    vm_value_t value = *slot;
+    if (!vm_box_is_pointer(value) || !vm_gc_young(gc, vm_box_to_pointer(value))) {
+        return;
+    }
+    vm_value_array_t *young = vm_value_to_array(value);
+    if (young->mark & VM_GC_FORWARDED) {
+        *slot = vm_value_from_array((vm_value_array_t *)young->data);
+        return;
+    }
+    size_t size = sizeof(vm_value_array_t) + sizeof(vm_value_t) * (size_t)young->len;
+    uint8_t mark;
+    vm_value_array_t *old = vm_gc_alloc(gc, size, &mark);
+    memcpy(old, young, size);
+    old->data = (vm_value_t *)&old[1];
+    // promoted mid mark counts as allocated during it, anything old it holds
+    // was shaded when it was stored
+    old->mark = mark;
+    young->mark = VM_GC_FORWARDED;
+    young->data = (vm_value_t *)old;
+    *slot = vm_value_from_array(old);
+    vm_gc_gray(gc, *slot);
+}
+
+static void vm_gc_evacuate_table(vm_gc_t *gc, vm_value_table_t *tab) {
+    if (tab->hash_alloc != 0) {
+        size_t len = vm_gc_table_size(tab);
+        for (size_t i = 0; i < len; i++) {
+            vm_gc_evacuate(gc, &tab->hash_keys[i]);
+            vm_gc_evacuate(gc, &tab->hash_values[i]);
+        }
+    }
+#if VM_TABLE_OPT
+    for (size_t i = 0; i < tab->arr_len; i++) {
+        vm_gc_evacuate(gc, &tab->arr_data[i]);
+    }
+#endif
+}
+
+// a minor collection copies the young arrays reachable from the stack and
+// from old objects in the remembered set out to the old space, after which
+// nothing points into the nursery and it starts over empty
+static void vm_gc_minor(vm_gc_t *gc, vm_value_t *high) {
+    // an incremental mark may have its own values on the gray stack
+    size_t base = gc->gray_len;
+    for (vm_value_t *cur = gc->stack; cur < high; cur++) {
+        vm_gc_evacuate(gc, cur);
+    }
+    vm_gc_forget(gc, high);
+    for (size_t i = 0; i < gc->remembered_len; i++) {
+        vm_value_t obj = gc->remembered[i];
+        if (vm_typeof(obj) == VM_TYPE_ARRAY) {
+            vm_value_array_t *arr = vm_value_to_array(obj);
+            arr->mark &= ~VM_GC_REMEMBERED;
+            for (size_t j = 0; j < arr->len; j++) {
+                vm_gc_evacuate(gc, &arr->data[j]);
+            }
+        } else {
+            vm_value_table_t *tab = vm_value_to_table(obj);
+            tab->mark &= ~VM_GC_REMEMBERED;
+            vm_gc_evacuate_table(gc, tab);
+        }
+    }
+    gc->remembered_len = 0;
+    while (gc->gray_len != base) {
+        vm_value_array_t *arr = vm_value_to_array(gc->gray[--gc->gray_len]);
+        for (size_t i = 0; i < arr->len; i++) {
+            vm_gc_evacuate(gc, &arr->data[i]);
+        }
+    }
+    gc->young_used = 0;
+    gc->minors += 1;
+}
+
+// returns about how many values it had to look at
+static inline size_t vm_gc_mark_one(vm_gc_t *gc, vm_gc_deque_t *dq, vm_value_t value) {
     uint8_t type = vm_typeof(value);
     if (type == VM_TYPE_ARRAY) {
         vm_value_array_t *val = vm_value_to_array(value);
-        if (val->mark != 0) {
-            return;
+        if (!vm_gc_claim(&val->mark, dq != NULL)) {
+            return 1;
         }
-        val->mark = 1;
         for (size_t i = 0; i < val->len; i++) {
-            vm_gc_mark(val->data[i]);
+            vm_gc_trace(gc, dq, val->data[i]);
         }
+        return 1 + val->len;
     } else if (type == VM_TYPE_TABLE) {
         vm_value_table_t *val = vm_value_to_table(value);
-        if (val->mark != 0) {
-            return;
+        if (!vm_gc_claim(&val->mark, dq != NULL)) {
+            return 1;
         }
-        val->mark = 1;
+        size_t work = 1;
         if (val->hash_alloc != 0) {
             size_t len = vm_gc_table_size(val);
             for (size_t i = 0; i < len; i++) {
-                vm_gc_mark(val->hash_keys[i]);
-                vm_gc_mark(val->hash_values[i]);
+                vm_gc_trace(gc, dq, val->hash_keys[i]);
+                vm_gc_trace(gc, dq, val->hash_values[i]);
             }
+            work += len * 2;
         }
 #if VM_TABLE_OPT
         for (size_t i = 0; i < val->arr_len; i++) {
-            vm_gc_mark(val->arr_data[i]);
+            vm_gc_trace(gc, dq, val->arr_data[i]);
         }
+        work += val->arr_len;
 #endif
+        return work;
     }
+    return 1;
 }
 
-void vm_gc_run(vm_gc_t *restrict gc, vm_value_t *high) {
-#if VM_XGC
-    return;
-#endif
-    if (gc->len < gc->max) {
-        return;
+// marks what is reachable from the gray stack without recursing, so the depth
+// of the heap never touches the c stack. objects pass through a short queue
+// on their way off the stack and their header is prefetched on entry, by the
+// time one is marked its tag and mark byte are likely in cache. stops once
+// about budget values were looked at, returns whether the stack ran dry
+static bool vm_gc_mark(vm_gc_t *gc, size_t budget) {
+    vm_value_t queue[VM_CONFIG_GC_PREFETCH];
+    size_t head = 0;
+    size_t len = 0;
+    size_t work = 0;
+    for (;;) {
+        while (len < VM_CONFIG_GC_PREFETCH && gc->gray_len != 0) {
+            vm_value_t value = gc->gray[--gc->gray_len];
+            __builtin_prefetch(vm_box_to_pointer(value), 1);
+            queue[(head + len) % VM_CONFIG_GC_PREFETCH] = value;
+            len += 1;
+        }
+        if (len == 0) {
+            return true;
+        }
+        if (work >= budget) {
+            for (size_t i = 0; i < len; i++) {
+                vm_gc_gray(gc, queue[(head + i) % VM_CONFIG_GC_PREFETCH]);
+            }
+            return false;
+        }
+        vm_value_t value = queue[head];
+        head = (head + 1) % VM_CONFIG_GC_PREFETCH;
+        len -= 1;
+        work += vm_gc_mark_one(gc, NULL, value);
     }
-    vm_value_t *cur = gc->stack;
-    while (cur < high) {
-        vm_gc_mark(*cur);
-        cur += 1;
+}
+
+static void vm_gc_roots(vm_gc_t *gc, vm_value_t *high) {
+    for (vm_value_t *cur = gc->stack; cur < high; cur++) {
+        vm_gc_trace(gc, NULL, *cur);
     }
-    size_t head = 0;
-    for (size_t i = 0; i < gc->len; i++) {
-        vm_value_t value = gc->vals[i];
+}
+
+static void vm_gc_table_free(vm_value_table_t *tab) {
+#if VM_TABLE_OPT
+    vm_free(tab->arr_data);
+#endif
+    vm_free(tab->hash_keys);
+    vm_free(tab->hash_values);
+}
+
+// compacts the marked values of vals[from, to) down to vals[head], freeing
+// the rest, and returns where the survivors end
+static size_t vm_gc_sweep_range(vm_value_t *vals, size_t head, size_t from, size_t to) {
+    for (size_t i = from; i < to; i++) {
+        vm_value_t value = vals[i];
         uint8_t type = vm_typeof(value);
         if (type == VM_TYPE_ARRAY) {
             vm_value_array_t *val = vm_value_to_array(value);
-            if (val->mark != 0) {
-                val->mark = 0;
-                gc->vals[head++] = value;
+            if (val->mark & VM_GC_MARKED) {
+                val->mark &= ~VM_GC_MARKED;
+                vals[head++] = value;
             } else {
                 // vm_free(val->data);
                 vm_free(val);
             }
         } else {
             vm_value_table_t *val = vm_value_to_table(value);
-            if (val->mark != 0) {
-                val->mark = 0;
-                gc->vals[head++] = value;
+            if (val->mark & VM_GC_MARKED) {
+                val->mark &= ~VM_GC_MARKED;
+                vals[head++] = value;
             } else {
-#if VM_TABLE_OPT
-                vm_free(val->arr_data);
-#endif
-                vm_free(val->hash_keys);
-                vm_free(val->hash_values);
+                vm_gc_table_free(val);
                 vm_free(val);
             }
         }
     }
-    gc->len = head;
-    gc->max = gc->len * 2;
-    size_t min = (size_t)(cur - gc->stack) * 2;
-    if (gc->max < min) {
-        gc->max = min;
+    return head;
+}
+
+// frees every unmarked slot of the page onto its free list in one pass,
+// returns how many that was
+static size_t vm_gc_sweep_page(vm_gc_page_t *page) {
+    uint8_t *slots = (uint8_t *)page->slots;
+    size_t freed = 0;
+    for (size_t i = 0; i < page->count; i++) {
+        uint8_t *slot = &slots[i * page->size];
+        if (slot[0] == VM_TYPE_UNKNOWN) {
+            continue;
+        }
+        // arrays and tables both keep their mark byte second
+        vm_value_array_t *head = (vm_value_array_t *)slot;
+        if (head->mark & VM_GC_MARKED) {
+            head->mark &= ~VM_GC_MARKED;
+            continue;
+        }
+        if (slot[0] == VM_TYPE_TABLE) {
+            vm_gc_table_free((vm_value_table_t *)slot);
+        }
+        slot[0] = VM_TYPE_UNKNOWN;
+        vm_gc_slot_next(slot) = page->free;
+        page->free = slot;
+        freed += 1;
+    }
+    page->used -= (uint32_t)freed;
+    page->swept = true;
+    return freed;
+}
+
+#if !defined(_WIN32) && !defined(VM_WASM)
+// a stop the world collection of a large enough heap is shared between
+// gc->threads threads. each starts from its part of the roots and marks
+// through its own deque, stealing from the others once that runs dry, and
+// the mark is over when no thread is busy and every deque is empty
+typedef struct {
+    vm_gc_t *gc;
+    vm_gc_deque_t *deques;
+    size_t nthreads;
+    size_t busy;
+} vm_gc_par_t;
+
+typedef struct {
+    vm_gc_par_t *par;
+    size_t id;
+    size_t from;
+    size_t to;
+    size_t head;
+    size_t page_from;
+    size_t page_to;
+    size_t freed;
+} vm_gc_worker_t;
+
+static void vm_gc_par_run(size_t nthreads, vm_gc_worker_t *workers, void *(*func)(void *)) {
+    pthread_t *threads = vm_malloc(sizeof(pthread_t) * nthreads);
+    for (size_t i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[i], NULL, func, &workers[i]) != 0) {
+            fprintf(stderr, "gc: cannot start marking thread %zu of %zu\n", i, nthreads);
+            __builtin_trap();
+        }
+    }
+    func(&workers[0]);
+    for (size_t i = 1; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    vm_free(threads);
+}
+
+static void *vm_gc_par_steal(vm_gc_par_t *par, size_t id) {
+    for (size_t i = 1; i < par->nthreads; i++) {
+        void *ptr = vm_gc_deque_steal(&par->deques[(id + i) % par->nthreads]);
+        if (ptr != NULL) {
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+static bool vm_gc_par_pending(vm_gc_par_t *par) {
+    for (size_t i = 0; i < par->nthreads; i++) {
+        vm_gc_deque_t *dq = &par->deques[i];
+        if (__atomic_load_n(&dq->top, __ATOMIC_ACQUIRE) < __atomic_load_n(&dq->bottom, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *vm_gc_par_mark(void *arg) {
+    vm_gc_worker_t *self = arg;
+    vm_gc_par_t *par = self->par;
+    vm_gc_t *gc = par->gc;
+    vm_gc_deque_t *own = &par->deques[self->id];
+    for (size_t i = self->from; i < self->to; i++) {
+        vm_gc_deque_push(own, vm_box_to_pointer(gc->gray[i]));
+    }
+    for (;;) {
+        void *ptr;
+        while ((ptr = vm_gc_deque_take(own)) != NULL || (ptr = vm_gc_par_steal(par, self->id)) != NULL) {
+            vm_gc_mark_one(gc, own, vm_box_from_pointer(ptr));
+        }
+        __atomic_fetch_sub(&par->busy, 1, __ATOMIC_SEQ_CST);
+        for (;;) {
+            if (__atomic_load_n(&par->busy, __ATOMIC_SEQ_CST) == 0) {
+                return NULL;
+            }
+            if (vm_gc_par_pending(par)) {
+                __atomic_fetch_add(&par->busy, 1, __ATOMIC_SEQ_CST);
+                break;
+            }
+            sched_yield();
+        }
+    }
+}
+
+static void vm_gc_mark_parallel(vm_gc_t *gc) {
+    size_t nthreads = gc->threads;
+    vm_gc_par_t par = (vm_gc_par_t){
+        .gc = gc,
+        .deques = vm_malloc(sizeof(vm_gc_deque_t) * nthreads),
+        .nthreads = nthreads,
+        .busy = nthreads,
+    };
+    vm_gc_worker_t *workers = vm_malloc(sizeof(vm_gc_worker_t) * nthreads);
+    for (size_t i = 0; i < nthreads; i++) {
+        par.deques[i] = (vm_gc_deque_t){
+            .ring = vm_gc_ring_new(1024, NULL),
+        };
+        workers[i] = (vm_gc_worker_t){
+            .par = &par,
+            .id = i,
+            .from = gc->gray_len * i / nthreads,
+            .to = gc->gray_len * (i + 1) / nthreads,
+        };
+    }
+    vm_gc_par_run(nthreads, workers, vm_gc_par_mark);
+    gc->gray_len = 0;
+    for (size_t i = 0; i < nthreads; i++) {
+        vm_gc_ring_t *ring = par.deques[i].ring;
+        while (ring != NULL) {
+            vm_gc_ring_t *prev = ring->prev;
+            vm_free(ring);
+            ring = prev;
+        }
+    }
+    vm_free(workers);
+    vm_free(par.deques);
+}
+
+static void *vm_gc_par_sweep(void *arg) {
+    vm_gc_worker_t *self = arg;
+    vm_gc_t *gc = self->par->gc;
+    for (size_t i = self->page_from; i < self->page_to; i++) {
+        self->freed += vm_gc_sweep_page(gc->pages[i]);
+    }
+    self->head = vm_gc_sweep_range(gc->vals, self->from, self->from, self->to);
+    return NULL;
+}
+
+// each thread sweeps its own pages and compacts its own part of vals, the
+// parts are then moved together. only this thread touches the free lists
+static void vm_gc_sweep_parallel(vm_gc_t *gc) {
+    size_t nthreads = gc->threads;
+    size_t len = gc->sweep_end;
+    size_t npages = gc->sweep_pages;
+    vm_gc_par_t par = (vm_gc_par_t){
+        .gc = gc,
+        .nthreads = nthreads,
+    };
+    vm_gc_worker_t *workers = vm_malloc(sizeof(vm_gc_worker_t) * nthreads);
+    for (size_t i = 0; i < nthreads; i++) {
+        workers[i] = (vm_gc_worker_t){
+            .par = &par,
+            .id = i,
+            .from = len * i / nthreads,
+            .to = len * (i + 1) / nthreads,
+            .page_from = npages * i / nthreads,
+            .page_to = npages * (i + 1) / nthreads,
+        };
+    }
+    vm_gc_par_run(nthreads, workers, vm_gc_par_sweep);
+    size_t head = workers[0].head;
+    for (size_t i = 0; i < nthreads; i++) {
+        if (i != 0) {
+            size_t count = workers[i].head - workers[i].from;
+            memmove(&gc->vals[head], &gc->vals[workers[i].from], sizeof(vm_value_t) * count);
+            head += count;
+        }
+        gc->slab_used -= workers[i].freed;
+    }
+    for (size_t i = 0; i < npages; i++) {
+        vm_gc_page_list(gc, gc->pages[i]);
+    }
+    vm_free(workers);
+    gc->sweep_head = head;
+    gc->sweep_at = len;
+    gc->sweep_page = npages;
+}
+#endif
+
+// the whole mark in one go, on as many threads as the collector was given
+static void vm_gc_mark_all(vm_gc_t *gc) {
+#if !defined(_WIN32) && !defined(VM_WASM)
+    if (gc->threads > 1 && vm_gc_count(gc) >= VM_CONFIG_GC_PARALLEL_MIN) {
+        vm_gc_mark_parallel(gc);
+        return;
+    }
+#endif
+    vm_gc_mark(gc, SIZE_MAX);
+}
+
+// frees what was left unmarked, about budget values per call. the pages the
+// sweep started with go first, then the first sweep_end of vals. values
+// pushed since the sweep began were never marked and are moved down behind
+// the survivors once it is done
+static bool vm_gc_sweep(vm_gc_t *gc, size_t budget) {
+#if !defined(_WIN32) && !defined(VM_WASM)
+    if (gc->threads > 1 && budget == SIZE_MAX && gc->sweep_page == 0 && vm_gc_count(gc) >= VM_CONFIG_GC_PARALLEL_MIN) {
+        vm_gc_sweep_parallel(gc);
+    }
+#endif
+    size_t work = 0;
+    while (gc->sweep_page < gc->sweep_pages) {
+        if (work >= budget) {
+            return false;
+        }
+        vm_gc_page_t *page = gc->pages[gc->sweep_page++];
+        gc->slab_used -= vm_gc_sweep_page(page);
+        vm_gc_page_list(gc, page);
+        work += page->count;
+    }
+    size_t stop = gc->sweep_end;
+    if (budget != SIZE_MAX && stop - gc->sweep_at + work > budget) {
+        stop = gc->sweep_at + (budget > work ? budget - work : 0);
+    }
+    size_t head = vm_gc_sweep_range(gc->vals, gc->sweep_head, gc->sweep_at, stop);
+    gc->sweep_head = head;
+    gc->sweep_at = stop;
+    if (stop != gc->sweep_end) {
+        return false;
+    }
+    size_t fresh = gc->len - gc->sweep_end;
+    memmove(&gc->vals[head], &gc->vals[gc->sweep_end], sizeof(vm_value_t) * fresh);
+    gc->len = head + fresh;
+    return true;
+}
+
+// a full collection marks from the stack and then sweeps. with a slice set
+// each call only does that much of either and the mutator runs in between,
+// under vm_gc_barrier and allocating marked. young arrays are never marked,
+// the old values they hold were shaded when stored, and whatever the stack
+// holds by the end is marked in the pause that finishes the mark
+void vm_gc_run(vm_gc_t *restrict gc, vm_value_t *high) {
+#if VM_XGC
+    return;
+#endif
+    // leaves room for any array small enough to be young
+    bool minor = gc->young_size != 0 && gc->young_used + VM_CONFIG_GC_YOUNG_MAX > gc->young_size;
+    if (!minor && gc->phase == VM_GC_IDLE && vm_gc_count(gc) < gc->max) {
+        return;
+    }
+    uint64_t begin = vm_gc_now();
+    if (minor) {
+        vm_gc_minor(gc, high);
+    }
+    bool full = gc->phase != VM_GC_IDLE || vm_gc_count(gc) >= gc->max;
+    if (gc->phase == VM_GC_IDLE && vm_gc_count(gc) >= gc->max) {
+        if (gc->young_used != 0) {
+            vm_gc_minor(gc, high);
+        }
+        vm_gc_roots(gc, high);
+        gc->phase = VM_GC_MARKING;
+        gc->cycles += 1;
+    }
+    if (gc->phase == VM_GC_MARKING && gc->slice == 0) {
+        vm_gc_mark_all(gc);
+    }
+    size_t budget = gc->slice == 0 ? SIZE_MAX : gc->slice;
+    if (gc->phase == VM_GC_MARKING && vm_gc_mark(gc, budget)) {
+        // empties the remembered set too, which could name objects about to
+        // be swept
+        if (gc->young_used != 0) {
+            vm_gc_minor(gc, high);
+        }
+        vm_gc_roots(gc, high);
+        vm_gc_forget(gc, high);
+        vm_gc_mark(gc, SIZE_MAX);
+        gc->phase = VM_GC_SWEEPING;
+        gc->sweep_at = 0;
+        gc->sweep_head = 0;
+        gc->sweep_end = gc->len;
+        gc->sweep_page = 0;
+        gc->sweep_pages = gc->pages_len;
+        for (size_t i = 0; i < gc->pages_len; i++) {
+            gc->pages[i]->swept = false;
+        }
+    }
+    if (gc->phase == VM_GC_SWEEPING && vm_gc_sweep(gc, budget)) {
+        gc->phase = VM_GC_IDLE;
+        gc->max = vm_gc_count(gc) * 2;
+        size_t min = (size_t)(high - gc->stack) * 2;
+        if (gc->max < min) {
+            gc->max = min;
+        }
+    }
+    uint64_t pause = vm_gc_now() - begin;
+    gc->pauses += 1;
+    gc->pause_total += pause;
+    if (!full) {
+        if (pause > gc->minor_max) {
+            gc->minor_max = pause;
+        }
+    } else if (pause > gc->pause_max) {
+        gc->pause_max = pause;
+    }
+}
+
+void vm_gc_stats_print(vm_gc_t *gc, FILE *out) {
+    fprintf(out, "gc collections: %zu full, %zu minor\n", gc->cycles, gc->minors);
+    if (gc->slice == 0) {
+        fprintf(out, "gc slice: whole heap\n");
+    } else {
+        fprintf(out, "gc slice: %zu values\n", gc->slice);
+    }
+    fprintf(out, "gc threads: %zu\n", gc->threads);
+    fprintf(out, "gc slab: %zu objects in %zu pages, %zu others\n", gc->slab_used, gc->pages_len, gc->len);
+    fprintf(out, "gc pauses: %zu\n", gc->pauses);
+    if (gc->pauses != 0) {
+        fprintf(out, "gc pause max: %.3fms\n", (double)gc->pause_max / 1e6);
+        fprintf(out, "gc pause max, minor only: %.3fms\n", (double)gc->minor_max / 1e6);
+        fprintf(out, "gc pause mean: %.3fms\n", (double)gc->pause_total / 1e6 / (double)gc->pauses);
+        fprintf(out, "gc pause total: %.3fms\n", (double)gc->pause_total / 1e6);
     }
 }
 
 vm_value_t vm_gc_arr(vm_gc_t *restrict gc, vm_int_t slots) {
-    vm_value_array_t *arr = vm_malloc(sizeof(vm_value_array_t) + sizeof(vm_value_t) * (size_t)slots);
-    arr->tag = VM_TYPE_ARRAY;
-    if (gc->len + 1 >= gc->alloc) {
-        gc->alloc = gc->len * 2;
-        gc->vals = vm_realloc(gc->vals, sizeof(vm_value_t) * gc->alloc);
+    size_t size = sizeof(vm_value_array_t) + sizeof(vm_value_t) * (size_t)slots;
+    vm_value_array_t *arr;
+    uint8_t mark = 0;
+    if (size <= VM_CONFIG_GC_YOUNG_MAX && gc->young_used + size <= gc->young_size) {
+        arr = (vm_value_array_t *)&gc->young[gc->young_used];
+        gc->young_used += size;
+    } else {
+        arr = vm_gc_alloc(gc, size, &mark);
     }
-    gc->vals[gc->len++] = vm_value_from_array(arr);
+    arr->tag = VM_TYPE_ARRAY;
     arr->len = (uint32_t)slots;
-    arr->mark = 0;
+    arr->mark = mark;
     arr->data = (vm_value_t *)&arr[1];
-    #if NANBOX_EMPTY_BYTE != 0
+    // the nursery is reused, so stale values would otherwise be traced
     memset(arr->data, NANBOX_EMPTY_BYTE, sizeof(vm_value_t) * (size_t)slots);
-    #endif
     return vm_value_from_array(arr);
 }
 
@@ -262,26 +999,25 @@ vm_value_t vm_gc_get(vm_value_t obj, vm_value_t ind) {
     return arr->data[index];
 }
 
-void vm_gc_set(vm_value_t obj, vm_value_t ind, vm_value_t value) {
+void vm_gc_set(vm_gc_t *gc, vm_value_t obj, vm_value_t ind, vm_value_t value) {
     size_t index = (size_t)vm_value_to_float(ind);
     vm_value_array_t *arr = vm_value_to_array(obj);
     if (index >= arr->len) {
         // printf("bounds error: %zu >= %zu\n", index, (size_t) arr->len);
         __builtin_trap();
     }
+    vm_gc_barrier(gc, obj, value);
     arr->data[index] = value;
 }
 
 vm_int_t vm_gc_len(vm_value_t obj) { return (vm_int_t)vm_value_to_array(obj)->len; }
 
 vm_value_t vm_gc_tab(vm_gc_t *gc) {
-    vm_value_table_t *tab = vm_alloc0(sizeof(vm_value_table_t));
+    uint8_t mark;
+    vm_value_table_t *tab = vm_gc_alloc(gc, sizeof(vm_value_table_t), &mark);
+    memset(tab, 0, sizeof(vm_value_table_t));
     tab->tag = VM_TYPE_TABLE;
-    if (gc->len + 1 >= gc->alloc) {
-        gc->alloc = gc->len * 2;
-        gc->vals = vm_realloc(gc->vals, sizeof(vm_value_t) * gc->alloc);
-    }
-    gc->vals[gc->len++] = vm_value_from_table(tab);
+    tab->mark = mark;
     return vm_value_from_table(tab);
 }
 
@@ -408,7 +1144,10 @@ vm_value_t vm_gc_table_get(vm_value_table_t *tab, vm_value_t key) {
     }
 }
 
-void vm_gc_table_set(vm_value_table_t *tab, vm_value_t key, vm_value_t val) {
+void vm_gc_table_set(vm_gc_t *gc, vm_value_table_t *tab, vm_value_t key, vm_value_t val) {
+    // tables are never young, they hash other tables by address
+    vm_gc_barrier(gc, vm_value_from_table(tab), key);
+    vm_gc_barrier(gc, vm_value_from_table(tab), val);
 #if VM_TABLE_OPT
     if (vm_box_is_double(key)) {
         double dv = vm_value_to_float(key);
@@ -15,6 +15,9 @@ typedef int64_t vm_reg_t;
 struct vm_gc_t;
 typedef struct vm_gc_t vm_gc_t;
 
+struct vm_gc_page_t;
+typedef struct vm_gc_page_t vm_gc_page_t;
+
 typedef double vm_number_t;
 
 struct vm_value_array_t;
@@ -58,34 +61,99 @@ enum {
     VM_TYPE_MAX,
 };
 
+// the mark byte of arrays and tables, forwarded is only ever set on young
+// arrays that a minor collection copied out
+#define VM_GC_MARKED (1 << 0)
+#define VM_GC_REMEMBERED (1 << 1)
+#define VM_GC_FORWARDED (1 << 2)
+
+#define VM_GC_SLAB_CLASSES (VM_CONFIG_GC_SLAB_SLOTS + 1)
+
+enum {
+    VM_GC_IDLE,
+    VM_GC_MARKING,
+    VM_GC_SWEEPING,
+};
+
 struct vm_gc_t {
     vm_value_t *vals;
     size_t len;
     size_t alloc;
     size_t max;
+    // old arrays of up to VM_CONFIG_GC_SLAB_SLOTS values and all tables are
+    // carved out of pages of same sized slots, only larger arrays are malloced
+    // and kept in vals. each size has a list of pages with a free slot
+    vm_gc_page_t **pages;
+    size_t pages_len;
+    size_t pages_alloc;
+    vm_gc_page_t *avail[VM_GC_SLAB_CLASSES];
+    size_t slab_used;
     vm_value_t *stack;
     size_t nstack;
+    // calls stop at limit for the mutator to raise it, and no frame entered
+    // under limit writes past limit + margin, so the registers from there on
+    // have held no pointer since the last collection. lowered to the high of
+    // each collection, a margin of 0 means the mutator keeps to no limit
+    vm_value_t *limit;
+    size_t margin;
+    // young generation: arrays are bump allocated here and the ones a minor
+    // collection finds alive are copied out into vals, see vm_gc_minor
+    uint8_t *young;
+    size_t young_used;
+    size_t young_size;
+    // old objects that were given a young value since the last minor
+    // collection, found by vm_gc_barrier
+    vm_value_t *remembered;
+    size_t remembered_len;
+    size_t remembered_alloc;
+    // objects whose values are still to be looked at, promoted arrays in a
+    // minor collection and anything reached in a full one
+    vm_value_t *gray;
+    size_t gray_len;
+    size_t gray_alloc;
+    // incremental collection: with a nonzero slice each allocation marks or
+    // sweeps about that many values instead of stopping for the whole heap
+    uint8_t phase;
+    size_t slice;
+    // threads a stop the world mark or sweep of a large heap is split over
+    size_t threads;
+    size_t sweep_at;
+    size_t sweep_head;
+    size_t sweep_end;
+    size_t sweep_page;
+    size_t sweep_pages;
+    // pause stats, in nanoseconds. pauses that were only a minor collection
+    // are kept apart, no slice size shortens those
+    size_t minors;
+    size_t cycles;
+    size_t pauses;
+    uint64_t pause_total;
+    uint64_t pause_max;
+    uint64_t minor_max;
 };
 
 void vm_gc_init(vm_gc_t *out, size_t nstack, vm_value_t *stack);
 void vm_gc_deinit(vm_gc_t *out);
 void vm_gc_run(vm_gc_t *gc, vm_value_t *high);
+void vm_gc_remember(vm_gc_t *gc, vm_value_t obj);
+void vm_gc_shade(vm_gc_t *gc, vm_value_t val);
+void vm_gc_stats_print(vm_gc_t *gc, FILE *out);
 vm_value_t vm_gc_tab(vm_gc_t *gc);
 vm_value_t vm_gc_arr(vm_gc_t *gc, vm_int_t slots);
 vm_value_t vm_gc_get(vm_value_t obj, vm_value_t index);
-void vm_gc_set(vm_value_t obj, vm_value_t index, vm_value_t value);
+void vm_gc_set(vm_gc_t *gc, vm_value_t obj, vm_value_t index, vm_value_t value);
 vm_int_t vm_gc_len(vm_value_t obj);
 vm_value_t vm_gc_table_get(vm_value_table_t *tab, vm_value_t key);
-void vm_gc_table_set(vm_value_table_t *tab, vm_value_t key, vm_value_t val);
+void vm_gc_table_set(vm_gc_t *gc, vm_value_table_t *tab, vm_value_t key, vm_value_t val);
 bool vm_gc_eq(vm_value_t v1, vm_value_t v2);
 
 #define vm_gc_get_v(obj_, nth_) vm_gc_get(obj_, (nth_))
 #define vm_gc_get_i(obj_, nth_) vm_gc_get(obj_, vm_value_from_float(nth_))
 
-#define vm_gc_set_vv(obj_, nth_, val_) vm_gc_set(obj_, nth_, val_)
-#define vm_gc_set_vi(obj_, nth_, val_) vm_gc_set(obj_, nth_, vm_value_from_float(val_))
-#define vm_gc_set_iv(obj_, nth_, val_) vm_gc_set(obj_, vm_value_from_float(nth_), val_)
-#define vm_gc_set_ii(obj_, nth_, val_) vm_gc_set(obj_, vm_value_from_float(nth_), vm_value_from_float(val_))
+#define vm_gc_set_vv(gc_, obj_, nth_, val_) vm_gc_set(gc_, obj_, nth_, val_)
+#define vm_gc_set_vi(gc_, obj_, nth_, val_) vm_gc_set(gc_, obj_, nth_, vm_value_from_float(val_))
+#define vm_gc_set_iv(gc_, obj_, nth_, val_) vm_gc_set(gc_, obj_, vm_value_from_float(nth_), val_)
+#define vm_gc_set_ii(gc_, obj_, nth_, val_) vm_gc_set(gc_, obj_, vm_value_from_float(nth_), vm_value_from_float(val_))
 
 #define vm_value_nil() (vm_box_null())
 #define vm_value_from_bool(n_) (vm_box_from_boolean(n_))
@@ -124,4 +192,25 @@ static inline uint8_t vm_typeof(vm_value_t val) {
     return 0;
 }
 
+static inline bool vm_gc_young(vm_gc_t *gc, const void *ptr) {
+    return (uintptr_t)ptr - (uintptr_t)gc->young < gc->young_size;
+}
+
+// storing a young value into an old object has to be seen by the next minor
+// collection, which traces from the stack and the remembered set only. while
+// an incremental mark is running every old value stored anywhere is shaded,
+// so no marked object ends up pointing at one the mark will never reach
+static inline void vm_gc_barrier(vm_gc_t *gc, vm_value_t obj, vm_value_t val) {
+    if (!vm_box_is_pointer(val)) {
+        return;
+    }
+    if (vm_gc_young(gc, vm_box_to_pointer(val))) {
+        if (!vm_gc_young(gc, vm_box_to_pointer(obj))) {
+            vm_gc_remember(gc, obj);
+        }
+    } else if (gc->phase == VM_GC_MARKING) {
+        vm_gc_shade(gc, val);
+    }
+}
+
 #endif
@@ -0,0 +1,1081 @@
+#include "c.h"
+
+#include "../build.h"
+
+#include <ucontext.h>
+
+// runtime for the emitted programs
+
+vm_gc_t vm_c_gc;
+vm_value_t *vm_c_top;
+vm_value_t *vm_c_max;
+static vm_value_t *vm_c_stack;
+
+void vm_c_init(void) {
+    vm_c_stack = vm_alloc0(sizeof(vm_value_t) * VM_CONFIG_C_STACK);
+    vm_c_top = vm_c_stack;
+    vm_c_max = vm_c_stack + VM_CONFIG_C_STACK;
+    vm_gc_init(&vm_c_gc, VM_CONFIG_C_STACK, vm_c_stack);
+}
+
+void vm_c_deinit(void) {
+    vm_gc_deinit(&vm_c_gc);
+    vm_free(vm_c_stack);
+}
+
+// recursion in the program is recursion in c, so the entry runs on a stack
+// sized like the interpreter's instead of whatever the process was given
+void vm_c_run(void (*entry)(void)) {
+    ucontext_t caller;
+    ucontext_t callee;
+    void *stack = vm_malloc(VM_CONFIG_C_NATIVE_STACK);
+    getcontext(&callee);
+    callee.uc_stack.ss_sp = stack;
+    callee.uc_stack.ss_size = VM_CONFIG_C_NATIVE_STACK;
+    callee.uc_link = &caller;
+    makecontext(&callee, entry, 0);
+    swapcontext(&caller, &callee);
+    vm_free(stack);
+}
+
+void vm_c_overflow(void) {
+    fprintf(stderr, "stack overflow\n");
+    __builtin_trap();
+}
+
+void vm_c_type_error(const char *what) {
+    fprintf(stderr, "type error: expected %s\n", what);
+    __builtin_trap();
+}
+
+vm_value_t vm_c_arr(double len) {
+    vm_gc_run(&vm_c_gc, vm_c_top);
+    return vm_gc_arr(&vm_c_gc, (vm_int_t)len);
+}
+
+vm_value_t vm_c_tab(void) {
+    vm_gc_run(&vm_c_gc, vm_c_top);
+    return vm_gc_tab(&vm_c_gc);
+}
+
+static vm_value_t *vm_c_index(vm_value_t obj, vm_value_t key) {
+    vm_value_array_t *arr = vm_value_to_array(obj);
+    double index = vm_c_num(key);
+    if (index < 0 || index >= arr->len) {
+        fprintf(stderr, "bounds error: %f >= %zu\n", index, (size_t)arr->len);
+        __builtin_trap();
+    }
+    return &arr->data[(size_t)index];
+}
+
+vm_value_t vm_c_get(vm_value_t obj, vm_value_t key) {
+    switch (vm_typeof(obj)) {
+        case VM_TYPE_ARRAY: {
+            vm_value_t val = *vm_c_index(obj, key);
+            if (vm_box_is_empty(val)) {
+                fprintf(stderr, "get of unset index\n");
+                __builtin_trap();
+            }
+            return val;
+        }
+        case VM_TYPE_TABLE: {
+            return vm_gc_table_get(vm_value_to_table(obj), key);
+        }
+        default: {
+            vm_c_type_error("array or table");
+            return vm_value_nil();
+        }
+    }
+}
+
+void vm_c_set(vm_value_t obj, vm_value_t key, vm_value_t val) {
+    switch (vm_typeof(obj)) {
+        case VM_TYPE_ARRAY: {
+            vm_value_t *slot = vm_c_index(obj, key);
+            vm_gc_barrier(&vm_c_gc, obj, val);
+            *slot = val;
+            break;
+        }
+        case VM_TYPE_TABLE: {
+            vm_gc_table_set(&vm_c_gc, vm_value_to_table(obj), key, val);
+            break;
+        }
+        default: {
+            vm_c_type_error("array or table");
+        }
+    }
+}
+
+double vm_c_len(vm_value_t obj) {
+    if (vm_typeof(obj) != VM_TYPE_ARRAY) {
+        vm_c_type_error("array");
+    }
+    return (double)vm_value_to_array(obj)->len;
+}
+
+// an array is a closure: its first element is called with it prepended
+vm_value_t vm_c_call(vm_value_t func, size_t nargs, vm_value_t *args) {
+    switch (vm_typeof(func)) {
+        case VM_TYPE_FUNC: {
+            vm_c_func_t *ptr = vm_value_to_block(func);
+            return ptr->entry(nargs, args);
+        }
+        case VM_TYPE_ARRAY: {
+            vm_value_t inner = vm_c_get(func, vm_value_from_int(0));
+            if (vm_typeof(inner) != VM_TYPE_FUNC) {
+                vm_c_type_error("function in closure");
+            }
+            vm_value_t small[9];
+            vm_value_t *cargs = nargs < 9 ? &small[0] : vm_malloc(sizeof(vm_value_t) * (nargs + 1));
+            cargs[0] = func;
+            for (size_t i = 0; i < nargs; i++) {
+                cargs[i + 1] = args[i];
+            }
+            vm_c_func_t *ptr = vm_value_to_block(inner);
+            vm_value_t ret = ptr->entry(nargs + 1, cargs);
+            if (cargs != &small[0]) {
+                vm_free(cargs);
+            }
+            return ret;
+        }
+        default: {
+            vm_c_type_error("function");
+            return vm_value_nil();
+        }
+    }
+}
+
+// code generation
+
+enum {
+    VM_IR_BE_C_NONE,
+    VM_IR_BE_C_NUM,
+    VM_IR_BE_C_DYN,
+};
+
+struct vm_ir_be_c_func_t;
+typedef struct vm_ir_be_c_func_t vm_ir_be_c_func_t;
+
+struct vm_ir_be_c_func_t {
+    vm_ir_block_t *entry;
+    // blocks reachable from the entry without a call, entry first
+    vm_ir_block_t **blocks;
+    size_t nblocks;
+    uint8_t *kinds;
+    // read by some instr or branch, registers that are only written are
+    // never declared and their writes are kept for effect only
+    bool *used;
+    size_t *slots;
+    size_t nregs;
+    size_t nslots;
+    size_t nparams;
+    uint8_t ret;
+    bool escapes;
+    // something jumps back to the entry, so it needs a label
+    bool loops;
+};
+
+typedef struct {
+    size_t nblocks;
+    vm_ir_block_t *blocks;
+    // indexed by the entry block's id, NULL for blocks that are not entries
+    vm_ir_be_c_func_t **funcs;
+} vm_ir_be_c_t;
+
+static vm_ir_be_c_func_t *vm_ir_be_c_func(vm_ir_be_c_t *c, vm_ir_block_t *entry) {
+    if (c->funcs[entry->id] == NULL) {
+        vm_ir_be_c_func_t *func = vm_alloc0(sizeof(vm_ir_be_c_func_t));
+        func->entry = entry;
+        for (size_t i = 0; i < entry->nargs; i++) {
+            if (entry->args[i] > func->nparams) {
+                func->nparams = entry->args[i];
+            }
+        }
+        c->funcs[entry->id] = func;
+    }
+    return c->funcs[entry->id];
+}
+
+static uint8_t vm_ir_be_c_kind(vm_ir_be_c_func_t *func, vm_ir_arg_t arg) {
+    switch (arg.type) {
+        case VM_IR_ARG_REG: {
+            return func->kinds[arg.reg];
+        }
+        case VM_IR_ARG_NUM: {
+            return VM_IR_BE_C_NUM;
+        }
+        default: {
+            return VM_IR_BE_C_DYN;
+        }
+    }
+}
+
+static void vm_ir_be_c_join(bool *changed, uint8_t *kind, uint8_t with) {
+    if (with > *kind) {
+        *kind = with;
+        *changed = true;
+    }
+}
+
+static size_t vm_ir_be_c_nargs(vm_ir_instr_t *instr) {
+    size_t nargs = 0;
+    for (size_t i = 1; instr->args[i].type != VM_IR_ARG_NONE; i++) {
+        nargs += 1;
+    }
+    return nargs;
+}
+
+// the targets a branch can take, constant conditions only take one
+static size_t vm_ir_be_c_succ(vm_ir_be_c_func_t *func, vm_ir_branch_t *branch, vm_ir_block_t **succ) {
+    switch (branch->op) {
+        case VM_IR_BOP_JUMP: {
+            succ[0] = branch->targets[0];
+            return 1;
+        }
+        case VM_IR_BOP_BOOL: {
+            vm_ir_arg_t arg = branch->args[0];
+            switch (arg.type) {
+                case VM_IR_ARG_REG: {
+                    if (func->kinds != NULL && func->kinds[arg.reg] == VM_IR_BE_C_NUM) {
+                        succ[0] = branch->targets[1];
+                        return 1;
+                    }
+                    break;
+                }
+                case VM_IR_ARG_NUM: {
+                    succ[0] = branch->targets[arg.num != 0];
+                    return 1;
+                }
+                case VM_IR_ARG_BOOL: {
+                    succ[0] = branch->targets[arg.logic];
+                    return 1;
+                }
+                case VM_IR_ARG_NIL: {
+                    succ[0] = branch->targets[0];
+                    return 1;
+                }
+                default: {
+                    succ[0] = branch->targets[1];
+                    return 1;
+                }
+            }
+            break;
+        }
+        case VM_IR_BOP_LESS: {
+            if (branch->args[0].type == VM_IR_ARG_NUM && branch->args[1].type == VM_IR_ARG_NUM) {
+                succ[0] = branch->targets[branch->args[0].num < branch->args[1].num];
+                return 1;
+            }
+            break;
+        }
+        case VM_IR_BOP_EQUAL: {
+            if (branch->args[0].type == VM_IR_ARG_NUM && branch->args[1].type == VM_IR_ARG_NUM) {
+                succ[0] = branch->targets[branch->args[0].num == branch->args[1].num];
+                return 1;
+            }
+            break;
+        }
+        default: {
+            return 0;
+        }
+    }
+    succ[0] = branch->targets[0];
+    succ[1] = branch->targets[1];
+    return 2;
+}
+
+static void vm_ir_be_c_reach(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func) {
+    bool *seen = vm_alloc0(sizeof(bool) * c->nblocks);
+    vm_ir_block_t **todo = vm_malloc(sizeof(vm_ir_block_t *) * c->nblocks);
+    size_t ntodo = 0;
+    todo[ntodo++] = func->entry;
+    seen[func->entry->id] = true;
+    func->loops = false;
+    while (ntodo != 0) {
+        vm_ir_block_t *block = todo[--ntodo];
+        bool tail = false;
+        for (size_t i = 0; i < block->len && !tail; i++) {
+            vm_ir_instr_t *instr = block->instrs[i];
+            if (instr->op == VM_IR_IOP_TCALL) {
+                if (instr->args[0].type == VM_IR_ARG_FUNC && instr->args[0].func == func->entry) {
+                    func->loops = true;
+                }
+                tail = true;
+            }
+        }
+        // the block ends at its tail call, its branch is never emitted
+        if (tail) {
+            continue;
+        }
+        vm_ir_block_t *succ[2];
+        size_t nsucc = vm_ir_be_c_succ(func, block->branch, succ);
+        for (size_t i = 0; i < nsucc; i++) {
+            if (succ[i] == func->entry) {
+                func->loops = true;
+            }
+            if (!seen[succ[i]->id]) {
+                seen[succ[i]->id] = true;
+                todo[ntodo++] = succ[i];
+            }
+        }
+    }
+    vm_free(func->blocks);
+    func->blocks = vm_malloc(sizeof(vm_ir_block_t *) * c->nblocks);
+    func->nblocks = 0;
+    func->blocks[func->nblocks++] = func->entry;
+    for (size_t i = 0; i < c->nblocks; i++) {
+        if (seen[i] && &c->blocks[i] != func->entry) {
+            func->blocks[func->nblocks++] = &c->blocks[i];
+        }
+    }
+    vm_free(todo);
+    vm_free(seen);
+}
+
+// finds every function, which ones are used as values and how many params
+// each takes, a call site can pass more than the entry's live registers
+static void vm_ir_be_c_funcs(vm_ir_be_c_t *c) {
+    vm_ir_be_c_func(c, &c->blocks[0]);
+    for (size_t i = 0; i < c->nblocks; i++) {
+        vm_ir_block_t *block = &c->blocks[i];
+        if (block->id < 0) {
+            continue;
+        }
+        if (block->isfunc) {
+            vm_ir_be_c_func(c, block);
+        }
+        for (size_t j = 0; j < block->len; j++) {
+            vm_ir_instr_t *instr = block->instrs[j];
+            if (instr->op == VM_IR_IOP_NOP) {
+                continue;
+            }
+            bool call = instr->op == VM_IR_IOP_CALL || instr->op == VM_IR_IOP_TCALL;
+            for (size_t k = 0; instr->args[k].type != VM_IR_ARG_NONE; k++) {
+                if (instr->args[k].type != VM_IR_ARG_FUNC) {
+                    continue;
+                }
+                vm_ir_be_c_func_t *func = vm_ir_be_c_func(c, instr->args[k].func);
+                if (call && k == 0) {
+                    size_t nargs = vm_ir_be_c_nargs(instr);
+                    if (nargs > func->nparams) {
+                        func->nparams = nargs;
+                    }
+                } else {
+                    func->escapes = true;
+                }
+            }
+        }
+        for (size_t k = 0; k < 2; k++) {
+            if (block->branch->args[k].type == VM_IR_ARG_FUNC) {
+                vm_ir_be_c_func(c, block->branch->args[k].func)->escapes = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < c->nblocks; i++) {
+        vm_ir_be_c_func_t *func = c->funcs[i];
+        if (func == NULL) {
+            continue;
+        }
+        vm_ir_be_c_reach(c, func);
+        func->nregs = func->nparams + 1;
+        for (size_t j = 0; j < func->nblocks; j++) {
+            if (func->blocks[j]->nregs > func->nregs) {
+                func->nregs = func->blocks[j]->nregs;
+            }
+        }
+        func->kinds = vm_alloc0(sizeof(uint8_t) * func->nregs);
+        func->used = vm_alloc0(sizeof(bool) * func->nregs);
+        func->slots = vm_alloc0(sizeof(size_t) * func->nregs);
+        if (func->escapes || func->entry == &c->blocks[0]) {
+            for (size_t j = 1; j <= func->nparams; j++) {
+                func->kinds[j] = VM_IR_BE_C_DYN;
+            }
+        }
+    }
+}
+
+// a register is a number if every write to it is one, flow insensitive and
+// across direct calls: params take the kinds of the args, results the returns
+static bool vm_ir_be_c_infer_func(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func) {
+    bool changed = false;
+    for (size_t i = 0; i < func->nblocks; i++) {
+        vm_ir_block_t *block = func->blocks[i];
+        for (size_t j = 0; j < block->len; j++) {
+            vm_ir_instr_t *instr = block->instrs[j];
+            uint8_t kind = VM_IR_BE_C_NONE;
+            switch (instr->op) {
+                case VM_IR_IOP_MOVE: {
+                    kind = vm_ir_be_c_kind(func, instr->args[0]);
+                    break;
+                }
+                case VM_IR_IOP_ADD:
+                case VM_IR_IOP_SUB:
+                case VM_IR_IOP_MUL:
+                case VM_IR_IOP_DIV:
+                case VM_IR_IOP_MOD:
+                case VM_IR_IOP_BOR:
+                case VM_IR_IOP_BAND:
+                case VM_IR_IOP_BXOR:
+                case VM_IR_IOP_BSHL:
+                case VM_IR_IOP_BSHR:
+                case VM_IR_IOP_LEN:
+                case VM_IR_IOP_TYPE:
+                case VM_IR_IOP_IN: {
+                    kind = VM_IR_BE_C_NUM;
+                    break;
+                }
+                case VM_IR_IOP_ARR:
+                case VM_IR_IOP_TAB:
+                case VM_IR_IOP_GET: {
+                    kind = VM_IR_BE_C_DYN;
+                    break;
+                }
+                case VM_IR_IOP_CALL:
+                case VM_IR_IOP_TCALL: {
+                    kind = VM_IR_BE_C_DYN;
+                    if (instr->args[0].type == VM_IR_ARG_FUNC) {
+                        vm_ir_be_c_func_t *callee = c->funcs[instr->args[0].func->id];
+                        size_t nargs = vm_ir_be_c_nargs(instr);
+                        if (!callee->escapes) {
+                            for (size_t k = 1; k <= callee->nparams; k++) {
+                                uint8_t arg = k <= nargs ? vm_ir_be_c_kind(func, instr->args[k]) : VM_IR_BE_C_DYN;
+                                vm_ir_be_c_join(&changed, &callee->kinds[k], arg);
+                            }
+                        }
+                        kind = callee->ret;
+                    }
+                    if (instr->op == VM_IR_IOP_TCALL) {
+                        vm_ir_be_c_join(&changed, &func->ret, kind);
+                    }
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+            if (instr->out.type == VM_IR_ARG_REG) {
+                vm_ir_be_c_join(&changed, &func->kinds[instr->out.reg], kind);
+            }
+        }
+        if (block->branch->op == VM_IR_BOP_RET) {
+            vm_ir_be_c_join(&changed, &func->ret, vm_ir_be_c_kind(func, block->branch->args[0]));
+        }
+    }
+    return changed;
+}
+
+static void vm_ir_be_c_use(vm_ir_be_c_func_t *func, vm_ir_arg_t arg) {
+    if (arg.type == VM_IR_ARG_REG) {
+        func->used[arg.reg] = true;
+    }
+}
+
+static void vm_ir_be_c_infer(vm_ir_be_c_t *c) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < c->nblocks; i++) {
+            if (c->funcs[i] != NULL && vm_ir_be_c_infer_func(c, c->funcs[i])) {
+                changed = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < c->nblocks; i++) {
+        vm_ir_be_c_func_t *func = c->funcs[i];
+        if (func == NULL) {
+            continue;
+        }
+        // anything never written is nil, then bool branches on numbers fold
+        for (size_t j = 0; j < func->nregs; j++) {
+            if (func->kinds[j] == VM_IR_BE_C_NONE) {
+                func->kinds[j] = VM_IR_BE_C_DYN;
+            }
+        }
+        if (func->ret == VM_IR_BE_C_NONE) {
+            func->ret = VM_IR_BE_C_DYN;
+        }
+        vm_ir_be_c_reach(c, func);
+        for (size_t j = 0; j < func->nblocks; j++) {
+            vm_ir_block_t *block = func->blocks[j];
+            bool tail = false;
+            for (size_t k = 0; k < block->len && !tail; k++) {
+                vm_ir_instr_t *instr = block->instrs[k];
+                if (instr->op == VM_IR_IOP_NOP) {
+                    continue;
+                }
+                for (size_t a = 0; instr->args[a].type != VM_IR_ARG_NONE; a++) {
+                    vm_ir_be_c_use(func, instr->args[a]);
+                }
+                tail = instr->op == VM_IR_IOP_TCALL;
+            }
+            if (!tail) {
+                vm_ir_be_c_use(func, block->branch->args[0]);
+                vm_ir_be_c_use(func, block->branch->args[1]);
+            }
+        }
+        for (size_t j = 0; j < func->nregs; j++) {
+            if (func->used[j] && func->kinds[j] == VM_IR_BE_C_DYN && (j == 0 || j > func->nparams)) {
+                func->slots[j] = func->nslots++;
+            }
+        }
+        for (size_t j = 1; j <= func->nparams; j++) {
+            if (func->kinds[j] == VM_IR_BE_C_DYN) {
+                func->slots[j] = func->nslots++;
+            }
+        }
+    }
+}
+
+static const char *vm_ir_be_c_type(uint8_t kind) {
+    if (kind == VM_IR_BE_C_NUM) {
+        return "double";
+    }
+    return "vm_value_t";
+}
+
+static void vm_ir_be_c_num(FILE *of, double num) {
+    if (num == (double)(int64_t)num && fabs(num) < 1e15) {
+        fprintf(of, "%.1f", num);
+    } else {
+        fprintf(of, "%a", num);
+    }
+}
+
+// prints arg as kind, boxing or unboxing when it is the other one
+static void vm_ir_be_c_arg(vm_ir_be_c_func_t *func, FILE *of, vm_ir_arg_t arg, uint8_t kind) {
+    switch (arg.type) {
+        case VM_IR_ARG_REG: {
+            uint8_t has = func->kinds[arg.reg];
+            if (has == kind) {
+                fprintf(of, "r%zu", arg.reg);
+            } else if (kind == VM_IR_BE_C_NUM) {
+                fprintf(of, "vm_c_num(r%zu)", arg.reg);
+            } else {
+                fprintf(of, "vm_c_box(r%zu)", arg.reg);
+            }
+            break;
+        }
+        case VM_IR_ARG_NUM: {
+            if (kind == VM_IR_BE_C_NUM) {
+                vm_ir_be_c_num(of, arg.num);
+            } else {
+                fprintf(of, "vm_c_box(");
+                vm_ir_be_c_num(of, arg.num);
+                fprintf(of, ")");
+            }
+            break;
+        }
+        case VM_IR_ARG_NIL: {
+            if (kind == VM_IR_BE_C_NUM) {
+                fprintf(of, "vm_c_num(vm_value_nil())");
+            } else {
+                fprintf(of, "vm_value_nil()");
+            }
+            break;
+        }
+        case VM_IR_ARG_BOOL: {
+            if (kind == VM_IR_BE_C_NUM) {
+                fprintf(of, "vm_c_num(vm_value_from_bool(%s))", arg.logic ? "true" : "false");
+            } else {
+                fprintf(of, "vm_value_from_bool(%s)", arg.logic ? "true" : "false");
+            }
+            break;
+        }
+        case VM_IR_ARG_FUNC: {
+            if (kind == VM_IR_BE_C_NUM) {
+                fprintf(of, "vm_c_num(vm_value_from_block(&vm_c_func%zi))", arg.func->id);
+            } else {
+                fprintf(of, "vm_value_from_block(&vm_c_func%zi)", arg.func->id);
+            }
+            break;
+        }
+        case VM_IR_ARG_STR: {
+            fprintf(stderr, "vm2c: NO STRINGS YET\n");
+            __builtin_trap();
+        }
+        default: {
+            fprintf(stderr, "vm2c: cannot lower extern calls\n");
+            __builtin_trap();
+        }
+    }
+}
+
+static void vm_ir_be_c_spill(vm_ir_be_c_func_t *func, FILE *of) {
+    for (size_t i = 0; i < func->nregs; i++) {
+        if (func->kinds[i] == VM_IR_BE_C_DYN && (func->used[i] || (i >= 1 && i <= func->nparams))) {
+            fprintf(of, "    frame[%zu] = r%zu;\n", func->slots[i], i);
+        }
+    }
+}
+
+// a collection can move young arrays, so boxed registers are read back
+// from the frame it updated, all but the one just assigned
+static void vm_ir_be_c_reload(vm_ir_be_c_func_t *func, FILE *of, vm_ir_arg_t out) {
+    for (size_t i = 0; i < func->nregs; i++) {
+        if (out.type == VM_IR_ARG_REG && out.reg == i) {
+            continue;
+        }
+        if (func->kinds[i] == VM_IR_BE_C_DYN && (func->used[i] || (i >= 1 && i <= func->nparams))) {
+            fprintf(of, "    r%zu = frame[%zu];\n", i, func->slots[i]);
+        }
+    }
+}
+
+static void vm_ir_be_c_leave(vm_ir_be_c_func_t *func, FILE *of) {
+    if (func->nslots != 0) {
+        fprintf(of, "    vm_c_top = frame;\n");
+    }
+}
+
+// starts `out = ` for a value of kind, the matching end closes the box
+static void vm_ir_be_c_out(vm_ir_be_c_func_t *func, FILE *of, vm_ir_arg_t out, uint8_t kind) {
+    if (out.type != VM_IR_ARG_REG) {
+        fprintf(of, "    (void)(");
+    } else if (func->kinds[out.reg] == kind) {
+        fprintf(of, "    r%zu = (", out.reg);
+    } else if (kind == VM_IR_BE_C_NUM) {
+        fprintf(of, "    r%zu = vm_c_box(", out.reg);
+    } else {
+        fprintf(of, "    r%zu = vm_c_num(", out.reg);
+    }
+}
+
+static void vm_ir_be_c_binary(vm_ir_be_c_func_t *func, FILE *of, vm_ir_instr_t *instr, vm_ir_arg_t out, const char *op) {
+    vm_ir_be_c_out(func, of, out, VM_IR_BE_C_NUM);
+    vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_NUM);
+    fprintf(of, " %s ", op);
+    vm_ir_be_c_arg(func, of, instr->args[1], VM_IR_BE_C_NUM);
+    fprintf(of, ");\n");
+}
+
+static void vm_ir_be_c_bitwise(vm_ir_be_c_func_t *func, FILE *of, vm_ir_instr_t *instr, vm_ir_arg_t out, const char *op) {
+    vm_ir_be_c_out(func, of, out, VM_IR_BE_C_NUM);
+    fprintf(of, "(double)(vm_c_i32(");
+    vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_NUM);
+    fprintf(of, ") %s vm_c_i32(", op);
+    vm_ir_be_c_arg(func, of, instr->args[1], VM_IR_BE_C_NUM);
+    fprintf(of, ")));\n");
+}
+
+// the call expression, direct calls pass each param as the callee takes it
+static void vm_ir_be_c_call(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func, FILE *of, vm_ir_instr_t *instr) {
+    size_t nargs = vm_ir_be_c_nargs(instr);
+    if (instr->args[0].type == VM_IR_ARG_FUNC) {
+        vm_ir_be_c_func_t *callee = c->funcs[instr->args[0].func->id];
+        fprintf(of, "vm_c_f%zi(", callee->entry->id);
+        for (size_t i = 1; i <= callee->nparams; i++) {
+            if (i != 1) {
+                fprintf(of, ", ");
+            }
+            if (i <= nargs) {
+                vm_ir_be_c_arg(func, of, instr->args[i], callee->kinds[i]);
+            } else {
+                vm_ir_be_c_arg(func, of, vm_ir_arg_nil(), callee->kinds[i]);
+            }
+        }
+        fprintf(of, ")");
+        return;
+    }
+    fprintf(of, "vm_c_call(");
+    vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_DYN);
+    if (nargs == 0) {
+        fprintf(of, ", 0, NULL)");
+    } else {
+        fprintf(of, ", %zu, (vm_value_t[]){", nargs);
+        for (size_t i = 1; i <= nargs; i++) {
+            if (i != 1) {
+                fprintf(of, ", ");
+            }
+            vm_ir_be_c_arg(func, of, instr->args[i], VM_IR_BE_C_DYN);
+        }
+        fprintf(of, "})");
+    }
+}
+
+// the call converted to kind
+static void vm_ir_be_c_call_as(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func, FILE *of, vm_ir_instr_t *instr, uint8_t kind) {
+    uint8_t has = VM_IR_BE_C_DYN;
+    if (instr->args[0].type == VM_IR_ARG_FUNC) {
+        has = c->funcs[instr->args[0].func->id]->ret;
+    }
+    if (has == kind) {
+        vm_ir_be_c_call(c, func, of, instr);
+    } else {
+        fprintf(of, kind == VM_IR_BE_C_NUM ? "vm_c_num(" : "vm_c_box(");
+        vm_ir_be_c_call(c, func, of, instr);
+        fprintf(of, ")");
+    }
+}
+
+static void vm_ir_be_c_tcall(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func, FILE *of, vm_ir_instr_t *instr) {
+    if (instr->args[0].type == VM_IR_ARG_FUNC && instr->args[0].func == func->entry) {
+        // a loop back to the entry, the args are all read before any is set
+        size_t nargs = vm_ir_be_c_nargs(instr);
+        fprintf(of, "    {\n");
+        for (size_t i = 1; i <= func->nparams; i++) {
+            fprintf(of, "        %s a%zu = ", vm_ir_be_c_type(func->kinds[i]), i);
+            vm_ir_be_c_arg(func, of, i <= nargs ? instr->args[i] : vm_ir_arg_nil(), func->kinds[i]);
+            fprintf(of, ";\n");
+        }
+        for (size_t i = 1; i <= func->nparams; i++) {
+            fprintf(of, "        r%zu = a%zu;\n", i, i);
+        }
+        fprintf(of, "    }\n");
+        fprintf(of, "    goto b%zi;\n", func->entry->id);
+        return;
+    }
+    vm_ir_be_c_leave(func, of);
+    fprintf(of, "    return ");
+    vm_ir_be_c_call_as(c, func, of, instr, func->ret);
+    fprintf(of, ";\n");
+}
+
+static void vm_ir_be_c_instr(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func, FILE *of, vm_ir_instr_t *instr) {
+    vm_ir_arg_t out = instr->out;
+    if (out.type == VM_IR_ARG_REG && !func->used[out.reg] && (out.reg == 0 || out.reg > func->nparams)) {
+        out = (vm_ir_arg_t){.type = VM_IR_ARG_NONE};
+    }
+    switch (instr->op) {
+        case VM_IR_IOP_NOP: {
+            break;
+        }
+        case VM_IR_IOP_MOVE: {
+            if (out.type == VM_IR_ARG_REG) {
+                uint8_t kind = func->kinds[out.reg];
+                fprintf(of, "    r%zu = ", out.reg);
+                vm_ir_be_c_arg(func, of, instr->args[0], kind);
+                fprintf(of, ";\n");
+            }
+            break;
+        }
+        case VM_IR_IOP_ADD: {
+            vm_ir_be_c_binary(func, of, instr, out, "+");
+            break;
+        }
+        case VM_IR_IOP_SUB: {
+            vm_ir_be_c_binary(func, of, instr, out, "-");
+            break;
+        }
+        case VM_IR_IOP_MUL: {
+            vm_ir_be_c_binary(func, of, instr, out, "*");
+            break;
+        }
+        case VM_IR_IOP_DIV: {
+            vm_ir_be_c_binary(func, of, instr, out, "/");
+            break;
+        }
+        case VM_IR_IOP_MOD: {
+            vm_ir_be_c_out(func, of, out, VM_IR_BE_C_NUM);
+            fprintf(of, "vm_c_mod(");
+            vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_NUM);
+            fprintf(of, ", ");
+            vm_ir_be_c_arg(func, of, instr->args[1], VM_IR_BE_C_NUM);
+            fprintf(of, "));\n");
+            break;
+        }
+        case VM_IR_IOP_BOR: {
+            vm_ir_be_c_bitwise(func, of, instr, out, "|");
+            break;
+        }
+        case VM_IR_IOP_BAND: {
+            vm_ir_be_c_bitwise(func, of, instr, out, "&");
+            break;
+        }
+        case VM_IR_IOP_BXOR: {
+            vm_ir_be_c_bitwise(func, of, instr, out, "^");
+            break;
+        }
+        case VM_IR_IOP_BSHL: {
+            vm_ir_be_c_bitwise(func, of, instr, out, "<<");
+            break;
+        }
+        case VM_IR_IOP_BSHR: {
+            vm_ir_be_c_bitwise(func, of, instr, out, ">>");
+            break;
+        }
+        case VM_IR_IOP_CALL: {
+            vm_ir_be_c_spill(func, of);
+            if (out.type == VM_IR_ARG_REG) {
+                fprintf(of, "    r%zu = ", out.reg);
+                vm_ir_be_c_call_as(c, func, of, instr, func->kinds[out.reg]);
+            } else {
+                fprintf(of, "    ");
+                vm_ir_be_c_call(c, func, of, instr);
+            }
+            fprintf(of, ";\n");
+            vm_ir_be_c_reload(func, of, out);
+            break;
+        }
+        case VM_IR_IOP_ARR: {
+            if (out.type == VM_IR_ARG_REG) {
+                vm_ir_be_c_spill(func, of);
+                vm_ir_be_c_out(func, of, out, VM_IR_BE_C_DYN);
+                fprintf(of, "vm_c_arr(");
+                vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_NUM);
+                fprintf(of, "));\n");
+                vm_ir_be_c_reload(func, of, out);
+            }
+            break;
+        }
+        case VM_IR_IOP_TAB: {
+            if (out.type == VM_IR_ARG_REG) {
+                vm_ir_be_c_spill(func, of);
+                vm_ir_be_c_out(func, of, out, VM_IR_BE_C_DYN);
+                fprintf(of, "vm_c_tab());\n");
+                vm_ir_be_c_reload(func, of, out);
+            }
+            break;
+        }
+        case VM_IR_IOP_GET: {
+            // kept without an out, it still traps out of bounds
+            vm_ir_be_c_out(func, of, out, VM_IR_BE_C_DYN);
+            fprintf(of, "vm_c_get(");
+            vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_DYN);
+            fprintf(of, ", ");
+            vm_ir_be_c_arg(func, of, instr->args[1], VM_IR_BE_C_DYN);
+            fprintf(of, "));\n");
+            break;
+        }
+        case VM_IR_IOP_SET: {
+            fprintf(of, "    vm_c_set(");
+            vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_DYN);
+            fprintf(of, ", ");
+            vm_ir_be_c_arg(func, of, instr->args[1], VM_IR_BE_C_DYN);
+            fprintf(of, ", ");
+            vm_ir_be_c_arg(func, of, instr->args[2], VM_IR_BE_C_DYN);
+            fprintf(of, ");\n");
+            break;
+        }
+        case VM_IR_IOP_LEN: {
+            if (out.type == VM_IR_ARG_REG) {
+                vm_ir_be_c_out(func, of, out, VM_IR_BE_C_NUM);
+                fprintf(of, "vm_c_len(");
+                vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_DYN);
+                fprintf(of, "));\n");
+            }
+            break;
+        }
+        case VM_IR_IOP_TYPE: {
+            if (out.type == VM_IR_ARG_REG) {
+                vm_ir_be_c_out(func, of, out, VM_IR_BE_C_NUM);
+                if (instr->args[0].type == VM_IR_ARG_REG) {
+                    fprintf(of, "vm_c_type(");
+                    vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_DYN);
+                    fprintf(of, "));\n");
+                } else {
+                    fprintf(of, "%zu.0);\n", (size_t)VM_TYPE_F64);
+                }
+            }
+            break;
+        }
+        case VM_IR_IOP_OUT: {
+            fprintf(of, "    putchar((int)");
+            vm_ir_be_c_arg(func, of, instr->args[0], VM_IR_BE_C_NUM);
+            fprintf(of, ");\n");
+            break;
+        }
+        case VM_IR_IOP_IN: {
+            vm_ir_be_c_out(func, of, out, VM_IR_BE_C_NUM);
+            fprintf(of, "(double)fgetc(stdin));\n");
+            break;
+        }
+        default: {
+            fprintf(stderr, "vm2c: unimplemented op: %zu\n", (size_t)instr->op);
+            __builtin_trap();
+        }
+    }
+}
+
+static void vm_ir_be_c_branch(vm_ir_be_c_func_t *func, FILE *of, vm_ir_block_t *block) {
+    vm_ir_branch_t *branch = block->branch;
+    vm_ir_block_t *succ[2];
+    size_t nsucc = vm_ir_be_c_succ(func, branch, succ);
+    if (nsucc == 1) {
+        fprintf(of, "    goto b%zi;\n", succ[0]->id);
+        return;
+    }
+    switch (branch->op) {
+        case VM_IR_BOP_BOOL: {
+            fprintf(of, "    if (vm_c_truthy(");
+            vm_ir_be_c_arg(func, of, branch->args[0], VM_IR_BE_C_DYN);
+            fprintf(of, ")) {\n");
+            break;
+        }
+        case VM_IR_BOP_LESS: {
+            fprintf(of, "    if (");
+            vm_ir_be_c_arg(func, of, branch->args[0], VM_IR_BE_C_NUM);
+            fprintf(of, " < ");
+            vm_ir_be_c_arg(func, of, branch->args[1], VM_IR_BE_C_NUM);
+            fprintf(of, ") {\n");
+            break;
+        }
+        case VM_IR_BOP_EQUAL: {
+            uint8_t lhs = vm_ir_be_c_kind(func, branch->args[0]);
+            uint8_t rhs = vm_ir_be_c_kind(func, branch->args[1]);
+            fprintf(of, "    if (");
+            if (lhs == VM_IR_BE_C_NUM && rhs == VM_IR_BE_C_NUM) {
+                vm_ir_be_c_arg(func, of, branch->args[0], VM_IR_BE_C_NUM);
+                fprintf(of, " == ");
+                vm_ir_be_c_arg(func, of, branch->args[1], VM_IR_BE_C_NUM);
+            } else if (lhs == VM_IR_BE_C_NUM || rhs == VM_IR_BE_C_NUM) {
+                size_t num = lhs == VM_IR_BE_C_NUM ? 0 : 1;
+                fprintf(of, "vm_c_eq_num(");
+                vm_ir_be_c_arg(func, of, branch->args[1 - num], VM_IR_BE_C_DYN);
+                fprintf(of, ", ");
+                vm_ir_be_c_arg(func, of, branch->args[num], VM_IR_BE_C_NUM);
+                fprintf(of, ")");
+            } else {
+                fprintf(of, "vm_c_eq(");
+                vm_ir_be_c_arg(func, of, branch->args[0], VM_IR_BE_C_DYN);
+                fprintf(of, ", ");
+                vm_ir_be_c_arg(func, of, branch->args[1], VM_IR_BE_C_DYN);
+                fprintf(of, ")");
+            }
+            fprintf(of, ") {\n");
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    fprintf(of, "        goto b%zi;\n", succ[1]->id);
+    fprintf(of, "    }\n");
+    fprintf(of, "    goto b%zi;\n", succ[0]->id);
+}
+
+static void vm_ir_be_c_block(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func, FILE *of, vm_ir_block_t *block) {
+    if (block != func->entry || func->loops) {
+        fprintf(of, "b%zi:;\n", block->id);
+    }
+    for (size_t i = 0; i < block->len; i++) {
+        vm_ir_instr_t *instr = block->instrs[i];
+        if (instr->op == VM_IR_IOP_TCALL) {
+            // nothing in the block runs after a tail call
+            vm_ir_be_c_tcall(c, func, of, instr);
+            return;
+        }
+        vm_ir_be_c_instr(c, func, of, instr);
+    }
+    switch (block->branch->op) {
+        case VM_IR_BOP_RET: {
+            vm_ir_be_c_leave(func, of);
+            fprintf(of, "    return ");
+            vm_ir_be_c_arg(func, of, block->branch->args[0], func->ret);
+            fprintf(of, ";\n");
+            break;
+        }
+        case VM_IR_BOP_EXIT: {
+            fprintf(of, "    exit(0);\n");
+            break;
+        }
+        default: {
+            vm_ir_be_c_branch(func, of, block);
+            break;
+        }
+    }
+}
+
+static void vm_ir_be_c_sig(vm_ir_be_c_func_t *func, FILE *of) {
+    fprintf(of, "static %s vm_c_f%zi(", vm_ir_be_c_type(func->ret), func->entry->id);
+    if (func->nparams == 0) {
+        fprintf(of, "void");
+    }
+    for (size_t i = 1; i <= func->nparams; i++) {
+        if (i != 1) {
+            fprintf(of, ", ");
+        }
+        fprintf(of, "%s r%zu", vm_ir_be_c_type(func->kinds[i]), i);
+    }
+    fprintf(of, ")");
+}
+
+static void vm_ir_be_c_body(vm_ir_be_c_t *c, vm_ir_be_c_func_t *func, FILE *of) {
+    vm_ir_be_c_sig(func, of);
+    fprintf(of, " {\n");
+    if (func->nslots != 0) {
+        fprintf(of, "    vm_value_t *frame = vm_c_enter(%zu);\n", func->nslots);
+    }
+    for (size_t i = 1; i <= func->nparams; i++) {
+        if (!func->used[i]) {
+            fprintf(of, "    (void)r%zu;\n", i);
+        }
+    }
+    for (size_t i = 0; i < func->nregs; i++) {
+        if (!func->used[i] || (i >= 1 && i <= func->nparams)) {
+            continue;
+        }
+        if (func->kinds[i] == VM_IR_BE_C_NUM) {
+            fprintf(of, "    double r%zu = 0;\n", i);
+        } else {
+            fprintf(of, "    vm_value_t r%zu = vm_value_nil();\n", i);
+        }
+    }
+    for (size_t i = 0; i < func->nblocks; i++) {
+        vm_ir_be_c_block(c, func, of, func->blocks[i]);
+    }
+    fprintf(of, "}\n\n");
+}
+
+void vm_ir_be_c(FILE *of, size_t nblocks, vm_ir_block_t *blocks) {
+    vm_ir_be_c_t c = (vm_ir_be_c_t){
+        .nblocks = nblocks,
+        .blocks = blocks,
+        .funcs = vm_alloc0(sizeof(vm_ir_be_c_func_t *) * nblocks),
+    };
+    vm_ir_be_c_funcs(&c);
+    vm_ir_be_c_infer(&c);
+    fprintf(of, "#include \"vm/ir/be/c.h\"\n\n");
+    for (size_t i = 0; i < nblocks; i++) {
+        if (c.funcs[i] != NULL) {
+            vm_ir_be_c_sig(c.funcs[i], of);
+            fprintf(of, ";\n");
+        }
+    }
+    fprintf(of, "\n");
+    // functions used as values get an entry taking any number of boxed args
+    for (size_t i = 0; i < nblocks; i++) {
+        vm_ir_be_c_func_t *func = c.funcs[i];
+        if (func == NULL || !func->escapes) {
+            continue;
+        }
+        fprintf(of, "static vm_value_t vm_c_g%zu(size_t nargs, vm_value_t *args) {\n", i);
+        fprintf(of, "    (void)nargs;\n");
+        fprintf(of, "    (void)args;\n");
+        fprintf(of, "    return %s(vm_c_f%zu(", func->ret == VM_IR_BE_C_NUM ? "vm_c_box" : "", i);
+        for (size_t j = 1; j <= func->nparams; j++) {
+            if (j != 1) {
+                fprintf(of, ", ");
+            }
+            fprintf(of, "nargs > %zu ? args[%zu] : vm_value_nil()", j - 1, j - 1);
+        }
+        fprintf(of, "));\n");
+        fprintf(of, "}\n\n");
+        fprintf(of, "static vm_c_func_t vm_c_func%zu = {VM_TYPE_FUNC, &vm_c_g%zu};\n\n", i, i);
+    }
+    for (size_t i = 0; i < nblocks; i++) {
+        if (c.funcs[i] != NULL) {
+            vm_ir_be_c_body(&c, c.funcs[i], of);
+        }
+    }
+    fprintf(of, "static void vm_c_main(void) {\n");
+    fprintf(of, "    vm_c_f0();\n");
+    fprintf(of, "}\n\n");
+    fprintf(of, "int main(void) {\n");
+    fprintf(of, "    vm_c_init();\n");
+    fprintf(of, "    vm_c_run(&vm_c_main);\n");
+    fprintf(of, "    vm_c_deinit();\n");
+    fprintf(of, "    return 0;\n");
+    fprintf(of, "}\n");
+    for (size_t i = 0; i < nblocks; i++) {
+        vm_ir_be_c_func_t *func = c.funcs[i];
+        if (func == NULL) {
+            continue;
+        }
+        vm_free(func->blocks);
+        vm_free(func->kinds);
+        vm_free(func->used);
+        vm_free(func->slots);
+        vm_free(func);
+    }
+    vm_free(c.funcs);
+}
@@ -0,0 +1,104 @@
+#if !defined(VM_HEADER_IR_BE_C)
+#define VM_HEADER_IR_BE_C
+
+#include "../../gc.h"
+#include "../ir.h"
+
+/// ahead of time backend, lowers the ir to one c function per vm function
+/// the emitted file includes this header and links against libminivm.a
+///
+/// registers that only ever hold numbers become doubles, every other one is
+/// a boxed value that is stored to the function's frame on the shadow stack
+/// before anything that can collect, which is the only place the gc looks
+
+struct vm_c_func_t;
+typedef struct vm_c_func_t vm_c_func_t;
+
+// what a func value points to, the tag has to come first for vm_typeof
+struct vm_c_func_t {
+    uint8_t tag;
+    vm_value_t (*entry)(size_t nargs, vm_value_t *args);
+};
+
+extern vm_gc_t vm_c_gc;
+extern vm_value_t *vm_c_top;
+extern vm_value_t *vm_c_max;
+
+void vm_ir_be_c(FILE *of, size_t nblocks, vm_ir_block_t *blocks);
+
+void vm_c_init(void);
+void vm_c_deinit(void);
+void vm_c_run(void (*entry)(void));
+void vm_c_overflow(void);
+void vm_c_type_error(const char *what);
+vm_value_t vm_c_arr(double len);
+vm_value_t vm_c_tab(void);
+vm_value_t vm_c_get(vm_value_t obj, vm_value_t key);
+void vm_c_set(vm_value_t obj, vm_value_t key, vm_value_t val);
+double vm_c_len(vm_value_t obj);
+vm_value_t vm_c_call(vm_value_t func, size_t nargs, vm_value_t *args);
+
+// integral numbers are boxed as ints, the same key always hashes the same
+static inline vm_value_t vm_c_box(double num) {
+    if (num >= INT32_MIN && num <= INT32_MAX && (double)(vm_int_t)num == num) {
+        return vm_value_from_int((vm_int_t)num);
+    }
+    return vm_value_from_float(num);
+}
+
+static inline double vm_c_num(vm_value_t val) {
+    if (vm_box_is_int(val)) {
+        return (double)vm_value_to_int(val);
+    }
+    if (!vm_box_is_number(val)) {
+        vm_c_type_error("number");
+    }
+    return vm_value_to_float(val);
+}
+
+static inline vm_int_t vm_c_i32(double num) {
+    return (vm_int_t)num;
+}
+
+static inline double vm_c_mod(double lhs, double rhs) {
+    vm_int_t ilhs = (vm_int_t)lhs;
+    vm_int_t irhs = (vm_int_t)rhs;
+    if ((double)ilhs == lhs && (double)irhs == rhs && irhs > 0) {
+        return (double)(ilhs % irhs);
+    }
+    return fmod(lhs, rhs);
+}
+
+static inline double vm_c_type(vm_value_t val) {
+    return (double)vm_typeof(val);
+}
+
+// only nil and false take the false branch, every number is true
+static inline bool vm_c_truthy(vm_value_t val) {
+    if (vm_box_is_boolean(val)) {
+        return vm_value_to_bool(val);
+    }
+    return !vm_box_is_null(val);
+}
+
+static inline bool vm_c_eq_num(vm_value_t lhs, double rhs) {
+    return vm_box_is_number(lhs) && vm_box_to_number(lhs) == rhs;
+}
+
+static inline bool vm_c_eq(vm_value_t lhs, vm_value_t rhs) {
+    if (vm_box_is_number(lhs) && vm_box_is_number(rhs)) {
+        return vm_box_to_number(lhs) == vm_box_to_number(rhs);
+    }
+    return vm_gc_eq(lhs, rhs);
+}
+
+static inline vm_value_t *vm_c_enter(size_t nslots) {
+    vm_value_t *frame = vm_c_top;
+    vm_c_top += nslots;
+    if (vm_c_top > vm_c_max) {
+        vm_c_overflow();
+    }
+    return frame;
+}
+
+#endif
@@ -86,6 +86,7 @@ static inline const char *vm_int_debug_instr_name(size_t op) {
         [VM_INT_OP_CALL_L6] = "call",
         [VM_INT_OP_CALL_L7] = "call",
         [VM_INT_OP_CALL_L8] = "call",
+        [VM_INT_OP_CALL_LN] = "call",
         [VM_INT_OP_CALL_R0] = "call",
         [VM_INT_OP_CALL_R1] = "call",
         [VM_INT_OP_CALL_R2] = "call",
@@ -95,6 +96,7 @@ static inline const char *vm_int_debug_instr_name(size_t op) {
         [VM_INT_OP_CALL_R6] = "call",
         [VM_INT_OP_CALL_R7] = "call",
         [VM_INT_OP_CALL_R8] = "call",
+        [VM_INT_OP_CALL_RN] = "call",
         [VM_INT_OP_CALL_X0] = "call",
         [VM_INT_OP_CALL_X1] = "call",
         [VM_INT_OP_CALL_X2] = "call",
@@ -104,6 +106,7 @@ static inline const char *vm_int_debug_instr_name(size_t op) {
         [VM_INT_OP_CALL_X6] = "call",
         [VM_INT_OP_CALL_X7] = "call",
         [VM_INT_OP_CALL_X8] = "call",
+        [VM_INT_OP_CALL_XN] = "call",
         [VM_INT_OP_CALL_C0] = "call",
         [VM_INT_OP_CALL_C1] = "call",
         [VM_INT_OP_CALL_C2] = "call",
@@ -112,6 +115,7 @@ static inline const char *vm_int_debug_instr_name(size_t op) {
         [VM_INT_OP_CALL_C5] = "call",
         [VM_INT_OP_CALL_C6] = "call",
         [VM_INT_OP_CALL_C7] = "call",
+        [VM_INT_OP_CALL_CN] = "call",
         [VM_INT_OP_ARR_F] = "arr",
         [VM_INT_OP_ARR_R] = "arr",
         [VM_INT_OP_SET_RRR] = "set",
@@ -144,6 +148,7 @@ static inline const char *vm_int_debug_instr_name(size_t op) {
         [VM_INT_OP_CALL_T6] = "call",
         [VM_INT_OP_CALL_T7] = "call",
         [VM_INT_OP_CALL_T8] = "call",
+        [VM_INT_OP_CALL_TN] = "call",
         [VM_INT_OP_JUMP_T] = "jump",
         [VM_INT_OP_BB_RTT] = "bb",
         [VM_INT_OP_TAB] = "tab",
@@ -153,6 +158,25 @@ static inline const char *vm_int_debug_instr_name(size_t op) {
         [VM_INT_OP_TSET_RFF] = "set.table",
         [VM_INT_OP_TGET_RR] = "get.table",
         [VM_INT_OP_TGET_RF] = "get.table",
+        [VM_INT_OP_TCALL_L] = "tcall",
+        [VM_INT_OP_TCALL_T] = "tcall",
+        [VM_INT_OP_TCALL_R] = "tcall",
+        [VM_INT_OP_TCALL_C] = "tcall",
+        [VM_INT_OP_GENERIC] = "generic",
+        [VM_INT_OP_GENERIC_JUMP] = "jump",
+        [VM_INT_OP_I32MOD_RR_BEQ_RILL] = "mod.i32+beq.i32",
+        [VM_INT_OP_I32MOD_RR_BEQ_RITT] = "mod.i32+beq.i32",
+        [VM_INT_OP_I32MUL_RR_BLT_RRLL] = "mul.i32+blt.i32",
+        [VM_INT_OP_I32MUL_RR_BLT_RRTT] = "mul.i32+blt.i32",
+        [VM_INT_OP_I32ADD_RI_BLT_RRLL] = "add.i32+blt.i32",
+        [VM_INT_OP_I32ADD_RI_BLT_RRTT] = "add.i32+blt.i32",
+        [VM_INT_OP_I32ADD_RI_MUL_RR] = "add.i32+mul.i32",
+        [VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRLL] = "add.i32+mul.i32+blt.i32",
+        [VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRTT] = "add.i32+mul.i32+blt.i32",
+        [VM_INT_OP_I32SUB_RI_SUB_RR] = "sub.i32+sub.i32",
+        [VM_INT_OP_LEN_R_I32BEQ_RILL] = "len+beq.i32",
+        [VM_INT_OP_LEN_R_I32BEQ_RITT] = "len+beq.i32",
+        [VM_INT_OP_MOV_I_I32SUB_RI] = "mov+sub.i32",
     };
     return table[op];
 }
@@ -230,24 +254,26 @@ static inline const char *vm_int_debug_instr_format(size_t opcode) {
         [VM_INT_OP_FBEQ_RRTT] = "?ffLL",
         [VM_INT_OP_FBEQ_RFTT] = "?fIFLL",
         [VM_INT_OP_FBEQ_FRTT] = "?FfLL",
-        [VM_INT_OP_CALL_L0] = "L:",
-        [VM_INT_OP_CALL_L1] = "Ld:",
-        [VM_INT_OP_CALL_L2] = "Ldd:",
-        [VM_INT_OP_CALL_L3] = "Lddd:",
-        [VM_INT_OP_CALL_L4] = "Ldddd:",
-        [VM_INT_OP_CALL_L5] = "Lddddd:",
-        [VM_INT_OP_CALL_L6] = "Ldddddd:",
-        [VM_INT_OP_CALL_L7] = "Lddddddd:",
-        [VM_INT_OP_CALL_L8] = "Ldddddddd:",
-        [VM_INT_OP_CALL_R0] = "t:",
-        [VM_INT_OP_CALL_R1] = "td:",
-        [VM_INT_OP_CALL_R2] = "tdd:",
-        [VM_INT_OP_CALL_R3] = "tddd:",
-        [VM_INT_OP_CALL_R4] = "tdddd:",
-        [VM_INT_OP_CALL_R5] = "tddddd:",
-        [VM_INT_OP_CALL_R6] = "tdddddd:",
-        [VM_INT_OP_CALL_R7] = "tddddddd:",
-        [VM_INT_OP_CALL_R8] = "tdddddddd:",
+        [VM_INT_OP_CALL_L0] = "LI:",
+        [VM_INT_OP_CALL_L1] = "LdI:",
+        [VM_INT_OP_CALL_L2] = "LddI:",
+        [VM_INT_OP_CALL_L3] = "LdddI:",
+        [VM_INT_OP_CALL_L4] = "LddddI:",
+        [VM_INT_OP_CALL_L5] = "LdddddI:",
+        [VM_INT_OP_CALL_L6] = "LddddddI:",
+        [VM_INT_OP_CALL_L7] = "LdddddddI:",
+        [VM_INT_OP_CALL_L8] = "LddddddddI:",
+        [VM_INT_OP_CALL_LN] = "LI",
+        [VM_INT_OP_CALL_R0] = "tI:",
+        [VM_INT_OP_CALL_R1] = "tdI:",
+        [VM_INT_OP_CALL_R2] = "tddI:",
+        [VM_INT_OP_CALL_R3] = "tdddI:",
+        [VM_INT_OP_CALL_R4] = "tddddI:",
+        [VM_INT_OP_CALL_R5] = "tdddddI:",
+        [VM_INT_OP_CALL_R6] = "tddddddI:",
+        [VM_INT_OP_CALL_R7] = "tdddddddI:",
+        [VM_INT_OP_CALL_R8] = "tddddddddI:",
+        [VM_INT_OP_CALL_RN] = "tI",
         [VM_INT_OP_CALL_X0] = "X:",
         [VM_INT_OP_CALL_X1] = "Xd:",
         [VM_INT_OP_CALL_X2] = "Xdd:",
@@ -257,16 +283,18 @@ static inline const char *vm_int_debug_instr_format(size_t opcode) {
         [VM_INT_OP_CALL_X6] = "Xdddddd:",
         [VM_INT_OP_CALL_X7] = "Xddddddd:",
         [VM_INT_OP_CALL_X8] = "Xdddddddd:",
-        [VM_INT_OP_CALL_C0] = "c:",
-        [VM_INT_OP_CALL_C1] = "cd:",
-        [VM_INT_OP_CALL_C2] = "cdd:",
-        [VM_INT_OP_CALL_C3] = "cddd:",
-        [VM_INT_OP_CALL_C4] = "cdddd:",
-        [VM_INT_OP_CALL_C5] = "cddddd:",
-        [VM_INT_OP_CALL_C6] = "cdddddd:",
-        [VM_INT_OP_CALL_C7] = "cddddddd:",
-        [VM_INT_OP_ARR_F] = ":F",
-        [VM_INT_OP_ARR_R] = ":f",
+        [VM_INT_OP_CALL_XN] = "XI",
+        [VM_INT_OP_CALL_C0] = "cI:",
+        [VM_INT_OP_CALL_C1] = "cdI:",
+        [VM_INT_OP_CALL_C2] = "cddI:",
+        [VM_INT_OP_CALL_C3] = "cdddI:",
+        [VM_INT_OP_CALL_C4] = "cddddI:",
+        [VM_INT_OP_CALL_C5] = "cdddddI:",
+        [VM_INT_OP_CALL_C6] = "cddddddI:",
+        [VM_INT_OP_CALL_C7] = "cdddddddI:",
+        [VM_INT_OP_CALL_CN] = "cI",
+        [VM_INT_OP_ARR_F] = ":FI",
+        [VM_INT_OP_ARR_R] = ":fI",
         [VM_INT_OP_SET_RRR] = "afd",
         [VM_INT_OP_SET_RRI] = "afF",
         [VM_INT_OP_SET_RIR] = "aFd",
@@ -287,24 +315,44 @@ static inline const char *vm_int_debug_instr_format(size_t opcode) {
         [VM_INT_OP_RET_RF] = "?l",
         [VM_INT_OP_RET_RA] = "?a",
         [VM_INT_OP_RET_RT] = "?t",
-        [VM_INT_OP_CALL_T0] = "T:",
-        [VM_INT_OP_CALL_T1] = "Td:",
-        [VM_INT_OP_CALL_T2] = "Tdd:",
-        [VM_INT_OP_CALL_T3] = "Tddd:",
-        [VM_INT_OP_CALL_T4] = "Tdddd:",
-        [VM_INT_OP_CALL_T5] = "Tddddd:",
-        [VM_INT_OP_CALL_T6] = "Tdddddd:",
-        [VM_INT_OP_CALL_T7] = "Tddddddd:",
-        [VM_INT_OP_CALL_T8] = "Tdddddddd:",
+        [VM_INT_OP_CALL_T0] = "TI:",
+        [VM_INT_OP_CALL_T1] = "TdI:",
+        [VM_INT_OP_CALL_T2] = "TddI:",
+        [VM_INT_OP_CALL_T3] = "TdddI:",
+        [VM_INT_OP_CALL_T4] = "TddddI:",
+        [VM_INT_OP_CALL_T5] = "TdddddI:",
+        [VM_INT_OP_CALL_T6] = "TddddddI:",
+        [VM_INT_OP_CALL_T7] = "TdddddddI:",
+        [VM_INT_OP_CALL_T8] = "TddddddddI:",
+        [VM_INT_OP_CALL_TN] = "TI",
         [VM_INT_OP_JUMP_T] = "?T",
         [VM_INT_OP_BB_RTT] = "?bTT",
-        [VM_INT_OP_TAB] = ":",
+        [VM_INT_OP_TAB] = ":I",
         [VM_INT_OP_TSET_RRR] = "odd",
         [VM_INT_OP_TSET_RRF] = "odF",
         [VM_INT_OP_TSET_RFR] = "oFd",
         [VM_INT_OP_TSET_RFF] = "oFF",
         [VM_INT_OP_TGET_RR] = ":od",
-        [VM_INT_OP_TGET_RF] = ":oF"};
+        [VM_INT_OP_TGET_RF] = ":oF",
+        [VM_INT_OP_TCALL_L] = "LII",
+        [VM_INT_OP_TCALL_T] = "TII",
+        [VM_INT_OP_TCALL_R] = "tII",
+        [VM_INT_OP_TCALL_C] = "cII",
+        [VM_INT_OP_GENERIC] = "TI:",
+        [VM_INT_OP_GENERIC_JUMP] = "?T",
+        [VM_INT_OP_I32MOD_RR_BEQ_RILL] = ":iiiITT",
+        [VM_INT_OP_I32MOD_RR_BEQ_RITT] = ":iiiILL",
+        [VM_INT_OP_I32MUL_RR_BLT_RRLL] = ":iiiiTT",
+        [VM_INT_OP_I32MUL_RR_BLT_RRTT] = ":iiiiLL",
+        [VM_INT_OP_I32ADD_RI_BLT_RRLL] = ":iIiiTT",
+        [VM_INT_OP_I32ADD_RI_BLT_RRTT] = ":iIiiLL",
+        [VM_INT_OP_I32ADD_RI_MUL_RR] = ":iI:ii",
+        [VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRLL] = ":iI:iiiiTT",
+        [VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRTT] = ":iI:iiiiLL",
+        [VM_INT_OP_I32SUB_RI_SUB_RR] = ":iI:ii",
+        [VM_INT_OP_LEN_R_I32BEQ_RILL] = ":aiITT",
+        [VM_INT_OP_LEN_R_I32BEQ_RITT] = ":aiILL",
+        [VM_INT_OP_MOV_I_I32SUB_RI] = ":I:iI"};
     return table[opcode];
 }
 
@@ -1,53 +1,119 @@
 
+// the sampling profiler's timer and signal calls are posix, not c11, so ask
+// for them before any system header is read
+#if !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
 #include "int3.h"
 
 #include "../../lib.h"
 #include "../build.h"
+#include "../loop.h"
 #include "debug.h"
 #include "spall.h"
 
+#if !defined(_WIN32) && !defined(VM_WASM)
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#endif
+
 #if !defined(VM_ALLOW_INLINE_JUMPS)
 #define VM_ALLOW_INLINE_JUMPS 1
 #endif
 
 #define vm_int_block_comp_buf_check()                                           \
-    ({                                                                          \
-        if (buf.len + 64 >= buf.alloc) {                                        \
-            buf.alloc = buf.len * 2 + 16;                                       \
+    do {                                                                        \
+        if (buf.len + 64 * VM_INT_WIDE >= buf.alloc) {                          \
+            buf.alloc = (buf.len + 64 * VM_INT_WIDE) * 2;                       \
             buf.ops = vm_realloc(buf.ops, sizeof(vm_int_opcode_t) * buf.alloc); \
         }                                                                       \
-    })
+    } while (0)
+
+#define vm_int_block_comp_put_wide(field_, val_)              \
+    do {                                                      \
+        vm_int_wide(&buf.ops[buf.len])->field_ = (val_);      \
+        buf.len += VM_INT_WIDE;                               \
+    } while (0)
+
+// ops get a prologue when anything watches them run, the debug one traces,
+// prints and pairs while counting alone takes one that only counts
+#define vm_int_block_comp_prologue()                                             \
+    (state->debug_print_instrs || state->use_spall || state->pair_counts         \
+         ? VM_INT_OP_DEBUG_PRINT_INSTRS                                          \
+         : (state->op_counts != NULL ? VM_INT_OP_COUNT : VM_INT_MAX_OP))
 
 #define vm_int_block_comp_put_ptr(arg_)                                  \
-    ({                                                                   \
+    do {                                                                 \
         size_t arg__ = (arg_);                                           \
         if (ptrs[arg__] == NULL) {                                       \
             fprintf(stderr, "bad ptr: ptrs[%zu]", arg__);                \
             __builtin_trap();                                            \
         }                                                                \
-        if (state->debug_print_instrs || state->use_spall) {             \
-            buf.ops[buf.len++].ptr = ptrs[VM_INT_OP_DEBUG_PRINT_INSTRS]; \
+        size_t pre__ = vm_int_block_comp_prologue();                     \
+        if (pre__ != VM_INT_MAX_OP) {                                    \
+            vm_int_block_comp_put_wide(ptr, ptrs[pre__]);                \
             buf.ops[buf.len++].reg = (arg__);                            \
-            buf.ops[buf.len++].ptr = ptrs[(arg__)];                      \
+            vm_int_block_comp_put_wide(ptr, ptrs[(arg__)]);              \
         } else {                                                         \
-            buf.ops[buf.len++].ptr = ptrs[(arg__)];                      \
+            size_t fused__ = vm_int_block_comp_fuse(fuse_op, arg__);     \
+            if (fused__ != VM_INT_MAX_OP && ptrs[fused__] != NULL) {     \
+                vm_int_wide(&buf.ops[fuse_at])->ptr = ptrs[fused__];     \
+                fuse_op = fused__;                                       \
+            } else {                                                     \
+                fuse_op = arg__;                                         \
+                fuse_at = buf.len;                                       \
+                vm_int_block_comp_put_wide(ptr, ptrs[(arg__)]);          \
+            }                                                            \
         }                                                                \
-    })
+    } while (0)
+
+// konst[r] is one past the slot of the mov that loaded the int in r, as long
+// as nothing has touched r since, see vm_int_block_comp_ensure_float_reg
+static size_t vm_int_block_comp_forget_reg(vm_int_state_t *state, size_t *konst, size_t reg) {
+    if (reg < state->framesize) {
+        konst[reg] = 0;
+    }
+    return reg;
+}
+
+#define vm_int_block_comp_forget(reg_) vm_int_block_comp_forget_reg(state, konst, (reg_))
 
-#define vm_int_block_comp_put_out(out_) buf.ops[buf.len++].reg = (out_)
+#define vm_int_block_comp_put_out(out_) buf.ops[buf.len++].reg = vm_int_block_comp_forget(out_)
 
-#define vm_int_block_comp_put_reg(vreg_) buf.ops[buf.len++].reg = (vreg_).reg
+#define vm_int_block_comp_put_reg(vreg_) buf.ops[buf.len++].reg = vm_int_block_comp_forget((vreg_).reg)
 #define vm_int_block_comp_put_bval(val_) buf.ops[buf.len++].bval = (val_).logic
 #define vm_int_block_comp_put_ival(val_) buf.ops[buf.len++].ival = (int32_t)(val_).num
-#define vm_int_block_comp_put_fval(val_) buf.ops[buf.len++].fval = (val_).num
+#define vm_int_block_comp_put_fval(val_) vm_int_block_comp_put_wide(fval, (val_).num)
 
-#define vm_int_block_comp_put_regc(vreg_) buf.ops[buf.len++].reg = (vreg_)
+#define vm_int_block_comp_put_regc(vreg_) buf.ops[buf.len++].reg = vm_int_block_comp_forget(vreg_)
 #define vm_int_block_comp_put_ivalc(val_) buf.ops[buf.len++].ival = (val_)
-#define vm_int_block_comp_put_fvalc(val_) buf.ops[buf.len++].fval = (val_)
+#define vm_int_block_comp_put_fvalc(val_) vm_int_block_comp_put_wide(fval, (val_))
+
+#define vm_int_block_comp_put_block(block_) vm_int_block_comp_put_wide(block, (block_))
+
+// slots from the frame start to where a call puts its callee's frame
+#define vm_int_block_comp_put_frame() buf.ops[buf.len++].reg = block->nregs + 1
 
-#define vm_int_block_comp_put_block(block_) ({ \
-    buf.ops[buf.len++].block = (block_);       \
-})
+// an int op that can overflow leaves for the version of the block it jumps
+// to when it does, so that block is noted against its first operand; ops
+// that do not end their block have nowhere to go and wrap instead
+#define vm_int_block_comp_exit()                                                                                \
+    do {                                                                                                        \
+        if (VM_INT_OVERFLOW && block->branch->op == VM_IR_BOP_JUMP && block->instrs[block->len - 1] == instr) { \
+            exits = vm_realloc(exits, sizeof(size_t) * (nexits + 1));                                           \
+            exit_blocks = vm_realloc(exit_blocks, sizeof(vm_ir_block_t *) * (nexits + 1));                      \
+            exits[nexits] = buf.len;                                                                            \
+            exit_blocks[nexits] = block->branch->targets[0];                                                    \
+            nexits += 1;                                                                                        \
+        }                                                                                                       \
+    } while (0)
+
+// integral and in range, so it can be an int immediate
+static bool vm_int_is_int(double num) {
+    return fmod(num, 1) == 0.0 && num >= INT32_MIN && num <= INT32_MAX;
+}
 
 struct vm_int_data_t;
 typedef struct vm_int_data_t vm_int_data_t;
@@ -55,29 +121,180 @@ typedef struct vm_int_data_t vm_int_data_t;
 struct vm_int_data_t {
     vm_int_buf_t *bufs;
     uint8_t **types;
+    uint64_t *keys;
     size_t len;
     size_t alloc;
+    // open addressed on the signature, holds version index + 1
+    uint32_t *table;
+    size_t table_alloc;
+    // version taken by the previous lookup
+    size_t last;
+    // taken by every lookup that misses once there are VM_INT_MAX_VERSIONS
+    vm_int_opcode_t *generic;
+    // replacement for the call ending this block, when it was inlined
+    vm_ir_block_t *inlined;
+    // a call returns into this block, so a sampled run publishes on entry
+    bool ret;
 };
 
-static void vm_int_data_push(vm_int_data_t *data, vm_int_buf_t buf, uint8_t *types) {
+// signature of a block entry: the argument types packed as 4-bit tags
+// exact up to 16 args, beyond that the rest is folded in and hits are checked
+static uint64_t vm_int_data_key(vm_int_state_t *state, vm_ir_block_t *block) {
+    uint64_t key = 0;
+    for (size_t a = 0; a < block->nargs; a++) {
+        uint64_t type = vm_typeof(state->locals[block->args[a]]);
+        if (a < 16) {
+            key |= type << (a * 4);
+        } else {
+            key = (key << 5 | key >> 59) ^ type;
+        }
+    }
+    return key;
+}
+
+static size_t vm_int_data_slot(vm_int_data_t *data, uint64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15llu) >> 32) & (data->table_alloc - 1);
+}
+
+static bool vm_int_data_match(vm_int_data_t *data, vm_int_state_t *state, vm_ir_block_t *block, size_t index, uint64_t key) {
+    if (data->keys[index] != key) {
+        return false;
+    }
+    if (block->nargs <= 16) {
+        return true;
+    }
+    uint8_t *types = data->types[index];
+    for (size_t a = 0; a < block->nargs; a++) {
+        size_t reg = block->args[a];
+        if (vm_typeof(state->locals[reg]) != types[reg]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool vm_int_data_find(vm_int_data_t *data, vm_int_state_t *state, vm_ir_block_t *block, uint64_t key, size_t *out) {
+    if (data->len == 0) {
+        return false;
+    }
+    if (vm_int_data_match(data, state, block, data->last, key)) {
+        *out = data->last;
+        return true;
+    }
+    size_t mask = data->table_alloc - 1;
+    for (size_t slot = vm_int_data_slot(data, key); data->table[slot] != 0; slot = (slot + 1) & mask) {
+        size_t index = data->table[slot] - 1;
+        if (vm_int_data_match(data, state, block, index, key)) {
+            data->last = index;
+            *out = index;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void vm_int_data_insert(vm_int_data_t *data, size_t index) {
+    size_t mask = data->table_alloc - 1;
+    size_t slot = vm_int_data_slot(data, data->keys[index]);
+    while (data->table[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    data->table[slot] = (uint32_t)(index + 1);
+}
+
+static void vm_int_data_push(vm_int_data_t *data, vm_int_buf_t buf, uint8_t *types, uint64_t key) {
     if (data->len + 1 >= data->alloc) {
         data->alloc = (data->len + 1) * 2;
         data->bufs = vm_realloc(data->bufs, sizeof(vm_int_buf_t) * data->alloc);
         data->types = vm_realloc(data->types, sizeof(uint8_t *) * data->alloc);
+        data->keys = vm_realloc(data->keys, sizeof(uint64_t) * data->alloc);
     }
     data->bufs[data->len] = buf;
     data->types[data->len] = types;
+    data->keys[data->len] = key;
+    data->last = data->len;
     data->len += 1;
+    // keep the table at most half full
+    if (data->len * 2 > data->table_alloc) {
+        vm_free(data->table);
+        data->table_alloc = data->table_alloc == 0 ? 4 : data->table_alloc * 2;
+        data->table = vm_alloc0(sizeof(uint32_t) * data->table_alloc);
+        for (size_t i = 0; i < data->len; i++) {
+            vm_int_data_insert(data, i);
+        }
+    } else {
+        vm_int_data_insert(data, data->len - 1);
+    }
+}
+
+static size_t vm_int_exit_slot(vm_int_state_t *state, vm_int_opcode_t *key) {
+    return (size_t)(((uint64_t)(size_t)key * 0x9E3779B97F4A7C15llu) >> 32) & (state->exit_alloc - 1);
+}
+
+static void vm_int_exit_insert(vm_int_state_t *state, vm_int_opcode_t *key, vm_ir_block_t *block) {
+    size_t slot = vm_int_exit_slot(state, key);
+    while (state->exit_keys[slot] != NULL) {
+        slot = (slot + 1) & (state->exit_alloc - 1);
+    }
+    state->exit_keys[slot] = key;
+    state->exit_blocks[slot] = block;
+}
+
+static void vm_int_exit_add(vm_int_state_t *state, vm_int_opcode_t *key, vm_ir_block_t *block) {
+    // keep the table at most half full
+    if ((state->exit_len + 1) * 2 > state->exit_alloc) {
+        vm_int_opcode_t **keys = state->exit_keys;
+        vm_ir_block_t **blocks = state->exit_blocks;
+        size_t alloc = state->exit_alloc;
+        state->exit_alloc = alloc == 0 ? 64 : alloc * 2;
+        state->exit_keys = vm_alloc0(sizeof(vm_int_opcode_t *) * state->exit_alloc);
+        state->exit_blocks = vm_malloc(sizeof(vm_ir_block_t *) * state->exit_alloc);
+        for (size_t i = 0; i < alloc; i++) {
+            if (keys[i] != NULL) {
+                vm_int_exit_insert(state, keys[i], blocks[i]);
+            }
+        }
+        vm_free(keys);
+        vm_free(blocks);
+    }
+    vm_int_exit_insert(state, key, block);
+    state->exit_len += 1;
+}
+
+vm_ir_block_t *vm_int_exit_find(vm_int_state_t *state, vm_int_opcode_t *key) {
+    if (state->exit_alloc == 0) {
+        return NULL;
+    }
+    size_t slot = vm_int_exit_slot(state, key);
+    while (state->exit_keys[slot] != NULL) {
+        if (state->exit_keys[slot] == key) {
+            return state->exit_blocks[slot];
+        }
+        slot = (slot + 1) & (state->exit_alloc - 1);
+    }
+    return NULL;
+}
+
+// kept out of line so the overflow check costs the handlers one branch
+__attribute__((cold, noinline)) static vm_int_opcode_t *vm_int_exit_comp(vm_int_state_t *state, void **ptrs, vm_int_opcode_t *at, vm_value_t *out, double val) {
+    vm_ir_block_t *next = vm_int_exit_find(state, at);
+    if (next == NULL) {
+        return NULL;
+    }
+    *out = vm_value_from_float(val);
+    return vm_int_block_comp(state, ptrs, next);
 }
 
 #define vm_int_block_comp_mov(vreg_, fval_)             \
-    ({                                                  \
+    do {                                                \
         size_t reg = vreg_;                             \
         double val = fval_;                             \
-        if (fmod(val, 1) == 0.0) {                      \
+        if (vm_int_is_int(val)) {                       \
             vm_int_block_comp_put_ptr(VM_INT_OP_MOV_I); \
+            size_t at = buf.len;                        \
             vm_int_block_comp_put_out(reg);             \
             vm_int_block_comp_put_ivalc((int32_t)val);  \
+            konst[reg] = at;                            \
             types[reg] = VM_TYPE_I32;                   \
         } else {                                        \
             vm_int_block_comp_put_ptr(VM_INT_OP_MOV_F); \
@@ -85,518 +302,1208 @@ static void vm_int_data_push(vm_int_data_t *data, vm_int_buf_t buf, uint8_t *typ
             vm_int_block_comp_put_fvalc(val);           \
             types[reg] = VM_TYPE_F64;                   \
         }                                               \
-    })
-
-#define vm_int_block_comp_ensure_float_reg(reg_)                                             \
-    ({                                                                                       \
-        size_t reg = (reg_);                                                                 \
-        if (types[reg] == VM_TYPE_F64) {                                                     \
-            /* :) */                                                                         \
-        } else if (types[reg] == VM_TYPE_I32) {                                              \
-            vm_int_block_comp_put_ptr(VM_INT_OP_FMOV_R);                                     \
-            vm_int_block_comp_put_out(reg);                                                  \
-            types[reg] = VM_TYPE_F64;                                                        \
-        } else {                                                                             \
-            fprintf(stderr, "TYPE ERROR (reg: %zu) (type: %zu)\n", reg, (size_t)types[reg]); \
-            __builtin_trap();                                                                \
-        }                                                                                    \
-    })
-
-#define vm_int_block_comp_ensure_int_reg(reg_)                                               \
-    ({                                                                                       \
-        size_t reg = (reg_);                                                                 \
-        if (types[reg] == VM_TYPE_I32) {                                                     \
-            /* :) */                                                                         \
-        } else if (types[reg] == VM_TYPE_F64) {                                              \
-            vm_int_block_comp_put_ptr(VM_INT_OP_IMOV_R);                                     \
-            vm_int_block_comp_put_out(reg);                                                  \
-            types[reg] = VM_TYPE_I32;                                                        \
-        } else {                                                                             \
-            fprintf(stderr, "TYPE ERROR (reg: %zu) (type: %zu)\n", reg, (size_t)types[reg]); \
-            __builtin_trap();                                                                \
-        }                                                                                    \
-    })
-
-static void *vm_int_block_comp(vm_int_state_t *state, void **ptrs, vm_ir_block_t *block) {
-    if (state->use_spall) {
-        double begin = vm_trace_time();
-        vm_trace_begin(&state->spall_ctx, NULL, begin, "Basic Block Compile");
-        vm_trace_begin(&state->spall_ctx, NULL, begin, "Basic Block Cache Check");
+    } while (0)
+
+// a type error in the version being compiled: fatal when it is about to run,
+// but compiling ahead of time only gives up on this version
+#define vm_int_block_comp_type_error(...) \
+    do {                                  \
+        if (state->comp_eager) {          \
+            goto fail;                    \
+        }                                 \
+        fprintf(stderr, __VA_ARGS__);     \
+        __builtin_trap();                 \
+    } while (0)
+
+#define vm_int_block_comp_ensure_float_reg(reg_)                                                          \
+    do {                                                                                                  \
+        size_t reg = (reg_);                                                                              \
+        if (types[reg] == VM_TYPE_F64) {                                                                  \
+            /* :) */                                                                                      \
+        } else if (types[reg] == VM_TYPE_I32) {                                                           \
+            size_t at = konst[reg];                                                                       \
+            /* a wide float only fits over the int if nothing was put after it */                         \
+            if (at != 0 && vm_int_wide(&buf.ops[at - VM_INT_WIDE])->ptr == ptrs[VM_INT_OP_MOV_I]          \
+                && (VM_INT_WIDE == 1 || buf.len == at + 2)) {                                             \
+                /* the int was loaded and never read, so load a float instead */                          \
+                vm_int_wide(&buf.ops[at - VM_INT_WIDE])->ptr = ptrs[VM_INT_OP_MOV_F];                     \
+                if (vm_int_block_comp_prologue() != VM_INT_MAX_OP) {                                      \
+                    buf.ops[at - VM_INT_WIDE - 1].reg = VM_INT_OP_MOV_F;                                  \
+                }                                                                                         \
+                int32_t ival = buf.ops[at + 1].ival;                                                      \
+                vm_int_wide(&buf.ops[at + 1])->fval = (double)ival;                                       \
+                buf.len += VM_INT_WIDE - 1;                                                               \
+                fuse_op = VM_INT_MAX_OP;                                                                  \
+                konst[reg] = 0;                                                                           \
+            } else {                                                                                      \
+                vm_int_block_comp_put_ptr(VM_INT_OP_FMOV_R);                                              \
+                vm_int_block_comp_put_out(reg);                                                           \
+            }                                                                                             \
+            types[reg] = VM_TYPE_F64;                                                                     \
+        } else {                                                                                          \
+            vm_int_block_comp_type_error("TYPE ERROR (reg: %zu) (type: %zu)\n", reg, (size_t)types[reg]); \
+        }                                                                                                 \
+    } while (0)
+
+#define vm_int_block_comp_ensure_int_reg(reg_)                                                            \
+    do {                                                                                                  \
+        size_t reg = (reg_);                                                                              \
+        if (types[reg] == VM_TYPE_I32) {                                                                  \
+            /* :) */                                                                                      \
+        } else if (types[reg] == VM_TYPE_F64) {                                                           \
+            vm_int_block_comp_put_ptr(VM_INT_OP_IMOV_R);                                                  \
+            vm_int_block_comp_put_out(reg);                                                               \
+            types[reg] = VM_TYPE_I32;                                                                     \
+        } else {                                                                                          \
+            vm_int_block_comp_type_error("TYPE ERROR (reg: %zu) (type: %zu)\n", reg, (size_t)types[reg]); \
+        }                                                                                                 \
+    } while (0)
+
+// superinstructions: the operands of a fused op are the operands of its
+// parts back to back, so fusing only rewrites the first part's handler
+static size_t vm_int_block_comp_fuse(size_t last, size_t next) {
+    if (!VM_INT_FUSE) {
+        return VM_INT_MAX_OP;
     }
-    vm_int_data_t *data = block->data;
-    if (data == NULL) {
-        data = vm_malloc(sizeof(vm_int_data_t));
-        block->data = data;
-        data->alloc = 0;
-        data->len = 0;
-        data->bufs = NULL;
-        data->types = NULL;
-    } else {
-        for (size_t i = 0; i < data->len; i++) {
-            uint8_t *types = data->types[i];
-            for (size_t a = 0; a < block->nargs; a++) {
-                size_t reg = block->args[a];
-                if (vm_typeof(state->locals[reg]) != types[reg]) {
-                    goto next;
-                }
+    switch (last) {
+        case VM_INT_OP_I32MOD_RR: {
+            switch (next) {
+                case VM_INT_OP_I32BEQ_RITT:
+                    return VM_INT_OP_I32MOD_RR_BEQ_RITT;
+            }
+            break;
+        }
+        case VM_INT_OP_I32MUL_RR: {
+            switch (next) {
+                case VM_INT_OP_I32BLT_RRTT:
+                    return VM_INT_OP_I32MUL_RR_BLT_RRTT;
+            }
+            break;
+        }
+        case VM_INT_OP_I32ADD_RI: {
+            switch (next) {
+                case VM_INT_OP_I32BLT_RRTT:
+                    return VM_INT_OP_I32ADD_RI_BLT_RRTT;
+                case VM_INT_OP_I32MUL_RR:
+                    return VM_INT_OP_I32ADD_RI_MUL_RR;
+            }
+            break;
+        }
+        case VM_INT_OP_I32ADD_RI_MUL_RR: {
+            switch (next) {
+                case VM_INT_OP_I32BLT_RRTT:
+                    return VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRTT;
+            }
+            break;
+        }
+        case VM_INT_OP_I32SUB_RI: {
+            switch (next) {
+                case VM_INT_OP_I32SUB_RR:
+                    return VM_INT_OP_I32SUB_RI_SUB_RR;
+            }
+            break;
+        }
+        case VM_INT_OP_LEN_R: {
+            switch (next) {
+                case VM_INT_OP_I32BEQ_RITT:
+                    return VM_INT_OP_LEN_R_I32BEQ_RITT;
             }
-            if (state->use_spall) {
-                double end = vm_trace_time();
-                vm_trace_end(&state->spall_ctx, NULL, end);
-                vm_trace_end(&state->spall_ctx, NULL, end);
+            break;
+        }
+        case VM_INT_OP_MOV_I: {
+            switch (next) {
+                case VM_INT_OP_I32SUB_RI:
+                    return VM_INT_OP_MOV_I_I32SUB_RI;
             }
-            return data->bufs[i].ops;
-        next:;
+            break;
         }
     }
-    if (state->use_spall) {
-        vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
+    return VM_INT_MAX_OP;
+}
+
+static vm_ir_arg_t vm_int_inline_arg(vm_ir_arg_t arg, size_t base) {
+    if (arg.type == VM_IR_ARG_REG) {
+        arg.reg += base;
     }
-    vm_int_buf_t buf;
-    buf.len = 0;
-    buf.alloc = 128;
-    buf.ops = vm_alloc0(sizeof(vm_int_opcode_t) * buf.alloc);
-    uint8_t *types = vm_malloc(sizeof(uint8_t) * state->framesize);
-    for (size_t i = 0; i < block->nargs; i++) {
-        size_t reg = block->args[i];
-        types[reg] = vm_typeof(state->locals[reg]);
-        if (types[reg] == VM_TYPE_UNSET) {
-            fprintf(stderr, "unset reg in .L%zu: r%zu (arg #%zu)\n", block->id, reg, i);
-            __builtin_trap();
+    return arg;
+}
+
+static vm_ir_block_t *vm_int_inline_clone(vm_ir_block_t *block, size_t base, vm_ir_arg_t out, vm_ir_block_t *next, size_t *nclones, vm_ir_block_t ***clones) {
+    for (size_t i = 0; i < *nclones; i += 2) {
+        if ((*clones)[i] == block) {
+            return (*clones)[i + 1];
+        }
+    }
+    vm_ir_block_t *ret = vm_alloc0(sizeof(vm_ir_block_t));
+    *clones = vm_realloc(*clones, sizeof(vm_ir_block_t *) * (*nclones + 2));
+    (*clones)[(*nclones)++] = block;
+    (*clones)[(*nclones)++] = ret;
+    ret->id = block->id;
+    ret->nregs = base + block->nregs;
+    // the caller's live registers are args too, so versions of the copy
+    // are specialized on them just like versions of the continuation
+    ret->args = vm_malloc(sizeof(size_t) * (next->nargs + block->nargs));
+    for (size_t i = 0; i < next->nargs; i++) {
+        if (out.type != VM_IR_ARG_REG || next->args[i] != out.reg) {
+            ret->args[ret->nargs++] = next->args[i];
         }
     }
-#if defined(VM_DEBUG_COMP)
-    fprintf(stderr, "block .%zu(", block->id);
     for (size_t i = 0; i < block->nargs; i++) {
-        if (i != 0) {
-            fprintf(stderr, ", ");
+        ret->args[ret->nargs++] = block->args[i] + base;
+    }
+    for (size_t i = 0; i < block->len; i++) {
+        vm_ir_instr_t *from = block->instrs[i];
+        size_t nargs = 0;
+        while (from->args[nargs].type != VM_IR_ARG_NONE) {
+            nargs += 1;
         }
-        size_t reg = block->args[i];
-        uint8_t type = types[reg];
-        static const char *const typenames[VM_TYPE_MAX] = {
-            [VM_TYPE_UNSET] = "unset",
-            [VM_TYPE_NIL] = "nil",
-            [VM_TYPE_BOOL] = "bool",
-            [VM_TYPE_I32] = "int",
-            [VM_TYPE_F64] = "float",
-            [VM_TYPE_FUNC] = "func",
-            [VM_TYPE_ARRAY] = "array",
-            [VM_TYPE_TABLE] = "table",
-        };
-        const char *typename = typenames[type];
-        if (!typename) __builtin_trap();
-        fprintf(stderr, "r%zu : %s", reg, typename);
+        vm_ir_instr_t *instr = vm_ir_instr_new(nargs);
+        instr->out = from->out;
+        instr->op = from->op;
+        memcpy(instr->args, from->args, sizeof(vm_ir_arg_t) * nargs);
+        instr->out = vm_int_inline_arg(instr->out, base);
+        if (instr->op == VM_IR_IOP_TCALL) {
+            // the copy returns into the caller's continuation, not our caller
+            instr->op = VM_IR_IOP_CALL;
+        }
+        if (instr->op != VM_IR_IOP_CALL || instr->args[0].type != VM_IR_ARG_FUNC) {
+            instr->args[0] = vm_int_inline_arg(instr->args[0], base);
+        }
+        for (size_t k = 1; instr->args[k].type != VM_IR_ARG_NONE; k++) {
+            instr->args[k] = vm_int_inline_arg(instr->args[k], base);
+        }
+        vm_ir_block_realloc(ret, instr);
     }
-    fprintf(stderr, ") {\n");
-#endif
-inline_jump:;
-    for (size_t arg = 0; arg < block->len; arg++) {
-        vm_ir_instr_t *instr = block->instrs[arg];
-#if defined(VM_DEBUG_COMP)
-        if (instr->op != VM_IR_IOP_NOP) {
-            fprintf(stderr, "  ");
-            vm_ir_print_instr(stderr, instr);
-            fprintf(stderr, "\n");
-            fflush(stderr);
+    ret->branch = vm_malloc(sizeof(vm_ir_branch_t));
+    *ret->branch = *block->branch;
+    if (block->branch->op == VM_IR_BOP_RET) {
+        // ret v becomes out <- v, then back to the caller's continuation
+        if (out.type == VM_IR_ARG_REG) {
+            vm_ir_block_add_move(ret, out, vm_int_inline_arg(block->branch->args[0], base));
         }
-#endif
-        vm_int_block_comp_buf_check();
+        ret->branch->op = VM_IR_BOP_JUMP;
+        ret->branch->args[0] = (vm_ir_arg_t){.type = VM_IR_ARG_NONE};
+        ret->branch->targets[0] = next;
+        return ret;
+    }
+    for (size_t i = 0; i < 2; i++) {
+        ret->branch->args[i] = vm_int_inline_arg(block->branch->args[i], base);
+        if (block->branch->targets[i] != NULL) {
+            ret->branch->targets[i] = vm_int_inline_clone(block->branch->targets[i], base, out, next, nclones, clones);
+        }
+    }
+    return ret;
+}
+
+// instrs in every block reachable from func without leaving it, plus one per
+// block, giving up as soon as it is over budget
+static size_t vm_int_inline_size(vm_ir_block_t *func, size_t budget) {
+    vm_ir_block_t **seen = vm_malloc(sizeof(vm_ir_block_t *) * (budget + 1));
+    size_t nseen = 0;
+    seen[nseen++] = func;
+    size_t size = 0;
+    for (size_t i = 0; i < nseen && size <= budget; i++) {
+        vm_ir_block_t *block = seen[i];
+        size += 1;
+        for (size_t j = 0; j < block->len; j++) {
+            if (block->instrs[j]->op != VM_IR_IOP_NOP) {
+                size += 1;
+            }
+        }
+        if (block->branch->op == VM_IR_BOP_RET) {
+            continue;
+        }
+        for (size_t t = 0; t < 2; t++) {
+            vm_ir_block_t *target = block->branch->targets[t];
+            if (target == NULL) {
+                continue;
+            }
+            bool found = false;
+            for (size_t j = 0; j < nseen; j++) {
+                found = found || seen[j] == target;
+            }
+            if (!found) {
+                if (nseen == budget + 1) {
+                    size = budget + 1;
+                    break;
+                }
+                seen[nseen++] = target;
+            }
+        }
+    }
+    vm_free(seen);
+    return size;
+}
+
+// a call to a small known function is replaced by a copy of its blocks
+// with registers moved past any the caller still needs, so the callee runs
+// in the caller's frame and its rets become jumps to the call's continuation
+static vm_ir_block_t *vm_int_inline_call(vm_int_state_t *state, vm_ir_block_t *block, vm_ir_instr_t *call) {
+    if (state->inline_budget == 0 || call->args[0].type != VM_IR_ARG_FUNC) {
+        return NULL;
+    }
+    if (block->branch->op != VM_IR_BOP_JUMP || block->instrs[block->len - 1] != call) {
+        return NULL;
+    }
+    vm_int_data_t *data = block->data;
+    if (data != NULL && data->inlined != NULL) {
+        return data->inlined;
+    }
+    vm_ir_block_t *func = call->args[0].func;
+    if (vm_int_inline_size(func, state->inline_budget) > state->inline_budget) {
+        return NULL;
+    }
+    size_t nargs = 0;
+    size_t base = 0;
+    while (call->args[nargs + 1].type != VM_IR_ARG_NONE) {
+        vm_ir_arg_t arg = call->args[nargs + 1];
+        if (arg.type == VM_IR_ARG_REG && arg.reg >= base) {
+            base = arg.reg + 1;
+        }
+        nargs += 1;
+    }
+    for (size_t i = 0; i < func->nargs; i++) {
+        if (func->args[i] == 0 || func->args[i] > nargs) {
+            return NULL;
+        }
+    }
+    if (call->out.type == VM_IR_ARG_REG && call->out.reg >= base) {
+        base = call->out.reg + 1;
+    }
+    vm_ir_block_t *next = block->branch->targets[0];
+    for (size_t i = 0; i < next->nargs; i++) {
+        if (next->args[i] >= base) {
+            base = next->args[i] + 1;
+        }
+    }
+    if (base + func->nregs > state->framesize) {
+        return NULL;
+    }
+    size_t nclones = 0;
+    vm_ir_block_t **clones = NULL;
+    vm_ir_block_t *entry = vm_int_inline_clone(func, base, call->out, next, &nclones, &clones);
+    vm_free(clones);
+    vm_ir_block_t *ret = vm_alloc0(sizeof(vm_ir_block_t));
+    ret->id = block->id;
+    ret->nregs = base + func->nregs;
+    for (size_t i = 1; i <= nargs; i++) {
+        vm_ir_block_add_move(ret, vm_ir_arg_reg(base + i), call->args[i]);
+    }
+    vm_ir_block_end_jump(ret, entry);
+    if (data == NULL) {
+        data = vm_alloc0(sizeof(vm_int_data_t));
+        block->data = data;
+    }
+    data->inlined = ret;
+    state->inlined += 1;
+    return ret;
+}
+
+static uint8_t vm_int_loop_arg_type(const uint8_t *types, vm_ir_arg_t arg) {
+    switch (arg.type) {
+        case VM_IR_ARG_REG:
+            return types[arg.reg];
+        case VM_IR_ARG_NUM:
+            return vm_int_is_int(arg.num) ? VM_TYPE_I32 : VM_TYPE_F64;
+        case VM_IR_ARG_NIL:
+            return VM_TYPE_NIL;
+        case VM_IR_ARG_BOOL:
+            return VM_TYPE_BOOL;
+        case VM_IR_ARG_FUNC:
+            return VM_TYPE_FUNC;
+        default:
+            return VM_TYPE_UNKNOWN;
+    }
+}
+
+// the same choice vm_int_block_comp makes for an arith op or compare: ints
+// stay ints, any float turns every reg operand into a float in place
+static uint8_t vm_int_loop_arith(uint8_t *types, vm_ir_arg_t *args, size_t nargs) {
+    bool isfloat = false;
+    for (size_t i = 0; i < nargs; i++) {
+        uint8_t type = vm_int_loop_arg_type(types, args[i]);
+        if (type == VM_TYPE_F64) {
+            isfloat = true;
+        } else if (type != VM_TYPE_I32) {
+            return VM_TYPE_UNKNOWN;
+        }
+    }
+    if (!isfloat) {
+        return VM_TYPE_I32;
+    }
+    for (size_t i = 0; i < nargs; i++) {
+        if (args[i].type == VM_IR_ARG_REG) {
+            types[args[i].reg] = VM_TYPE_F64;
+        }
+    }
+    return VM_TYPE_F64;
+}
+
+static void vm_int_loop_block(vm_ir_block_t *block, uint8_t *types) {
+    for (size_t i = 0; i < block->len; i++) {
+        vm_ir_instr_t *instr = block->instrs[i];
+        uint8_t out = VM_TYPE_UNKNOWN;
         switch (instr->op) {
             case VM_IR_IOP_NOP: {
-                break;
+                continue;
             }
             case VM_IR_IOP_MOVE: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    switch (instr->args[0].type) {
-                        case VM_IR_ARG_REG: {
-                            // r = move r
-                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_R);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            types[instr->out.reg] = types[instr->args[0].reg];
-                            break;
-                        }
-                        case VM_IR_ARG_NIL: {
-                            // r = move i
-                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_V);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            types[instr->out.reg] = VM_TYPE_NIL;
-                            break;
-                        }
-                        case VM_IR_ARG_BOOL: {
-                            // r = move i
-                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_B);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_bval(instr->args[0]);
-                            types[instr->out.reg] = VM_TYPE_BOOL;
-                            break;
-                        }
-                        case VM_IR_ARG_NUM: {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num);
-                            break;
-                        }
-                        case VM_IR_ARG_STR: {
-                            fprintf(stderr, "NO STRINGS YET\n");
-                            __builtin_trap();
-                        }
-                        case VM_IR_ARG_FUNC: {
-                            // r = move i
-                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_T);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_block(instr->args[0].func);
-                            types[instr->out.reg] = VM_TYPE_FUNC;
-                            break;
-                        }
+                out = vm_int_loop_arg_type(types, instr->args[0]);
+                break;
+            }
+            case VM_IR_IOP_ADD:
+            case VM_IR_IOP_SUB:
+            case VM_IR_IOP_MUL:
+            case VM_IR_IOP_MOD: {
+                out = vm_int_loop_arith(types, instr->args, 2);
+                break;
+            }
+            case VM_IR_IOP_DIV: {
+                // int division picks its result type at runtime
+                if (vm_int_loop_arith(types, instr->args, 2) == VM_TYPE_F64) {
+                    out = VM_TYPE_F64;
+                }
+                break;
+            }
+            case VM_IR_IOP_BOR:
+            case VM_IR_IOP_BAND:
+            case VM_IR_IOP_BXOR:
+            case VM_IR_IOP_BSHL:
+            case VM_IR_IOP_BSHR: {
+                for (size_t k = 0; k < 2; k++) {
+                    if (instr->args[k].type == VM_IR_ARG_REG) {
+                        types[instr->args[k].reg] = VM_TYPE_I32;
                     }
                 }
+                out = VM_TYPE_I32;
                 break;
             }
-            case VM_IR_IOP_BOR: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor r r
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BOR_RR);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = bor r i
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BOR_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_ival(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor i r
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BOR_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            vm_int_block_comp_put_ival(instr->args[0]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num | (vm_int_t)instr->args[1].num));
-                        }
-                    }
+            case VM_IR_IOP_ARR: {
+                if (instr->args[0].type == VM_IR_ARG_REG) {
+                    types[instr->args[0].reg] = VM_TYPE_F64;
                 }
+                out = VM_TYPE_ARRAY;
                 break;
             }
-            case VM_IR_IOP_BAND: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor r r
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BAND_RR);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = bor r i
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BAND_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_ival(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor i r
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BAND_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            vm_int_block_comp_put_ival(instr->args[0]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num & (vm_int_t)instr->args[1].num));
-                        }
-                    }
-                }
+            case VM_IR_IOP_TAB: {
+                out = VM_TYPE_TABLE;
                 break;
             }
-            case VM_IR_IOP_BXOR: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor r r
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BXOR_RR);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = bor r i
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BXOR_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_ival(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor i r
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BXOR_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            vm_int_block_comp_put_ival(instr->args[0]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num ^ (vm_int_t)instr->args[1].num));
-                        }
-                    }
+            case VM_IR_IOP_GET:
+            case VM_IR_IOP_SET: {
+                if (vm_int_loop_arg_type(types, instr->args[0]) == VM_TYPE_ARRAY && instr->args[1].type == VM_IR_ARG_REG) {
+                    types[instr->args[1].reg] = VM_TYPE_F64;
                 }
                 break;
             }
-            case VM_IR_IOP_BSHL: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor r r
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHL_RR);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = bor r i
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHL_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_ival(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor i r
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHL_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            vm_int_block_comp_put_ival(instr->args[0]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num << (vm_int_t)instr->args[1].num));
-                        }
-                    }
-                }
+            case VM_IR_IOP_LEN:
+            case VM_IR_IOP_IN: {
+                out = VM_TYPE_I32;
                 break;
             }
-            case VM_IR_IOP_BSHR: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor r r
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHR_RR);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = bor r i
-                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHR_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[0]);
-                            vm_int_block_comp_put_ival(instr->args[1]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = bor i r
-                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
-                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHR_RI);
-                            vm_int_block_comp_put_out(instr->out.reg);
-                            vm_int_block_comp_put_reg(instr->args[1]);
-                            vm_int_block_comp_put_ival(instr->args[0]);
-                            types[instr->out.reg] = VM_TYPE_I32;
-                        } else {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num >> (vm_int_t)instr->args[1].num));
-                        }
-                    }
+            case VM_IR_IOP_OUT: {
+                if (instr->args[0].type == VM_IR_ARG_REG) {
+                    types[instr->args[0].reg] = VM_TYPE_F64;
                 }
                 break;
             }
-            case VM_IR_IOP_ADD: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = add r r
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32ADD_RR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FADD_RR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_F64;
-                            }
-                        } else {
-                            // r = add r i
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && fmod(instr->args[1].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32ADD_RI);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_ival(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FADD_RF);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_fval(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_F64;
-                            }
-                        }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = add i r
-                            if (types[instr->args[1].reg] == VM_TYPE_I32 && fmod(instr->args[0].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32ADD_RI);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                vm_int_block_comp_put_ival(instr->args[0]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FADD_RF);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                vm_int_block_comp_put_fval(instr->args[0]);
-                                types[instr->out.reg] = VM_TYPE_F64;
-                            }
-                        } else {
-                            // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num + instr->args[1].num);
+        }
+        if (instr->out.type == VM_IR_ARG_REG) {
+            types[instr->out.reg] = out;
+        }
+    }
+    if (block->branch->op == VM_IR_BOP_LESS || block->branch->op == VM_IR_BOP_EQUAL) {
+        vm_int_loop_arith(types, block->branch->args, 2);
+    }
+}
+
+// an int the loop turns into a float on its first trip is turned into one
+// before entering, so the whole loop runs in the version it settles on
+// instead of a first trip version plus a steady state version
+static bool vm_int_loop_spec(vm_int_state_t *state, vm_ir_block_t *head, const uint8_t *entry, uint8_t *spec) {
+    size_t nbody = head->nbody;
+    size_t size = state->framesize;
+    uint8_t *ins = vm_malloc(sizeof(uint8_t) * size * nbody);
+    uint8_t *back = vm_malloc(sizeof(uint8_t) * size);
+    uint8_t *cur = vm_malloc(sizeof(uint8_t) * size);
+    size_t *work = vm_malloc(sizeof(size_t) * nbody);
+    bool *queued = vm_malloc(sizeof(bool) * nbody);
+    for (size_t i = 0; i < head->nargs; i++) {
+        spec[head->args[i]] = entry[head->args[i]];
+    }
+    bool any = false;
+    for (;;) {
+        memset(ins, VM_TYPE_UNSET, sizeof(uint8_t) * size * nbody);
+        memset(back, VM_TYPE_UNSET, sizeof(uint8_t) * size);
+        memset(queued, 0, sizeof(bool) * nbody);
+        for (size_t i = 0; i < head->nargs; i++) {
+            ins[head->args[i]] = spec[head->args[i]];
+        }
+        size_t nwork = 0;
+        work[nwork++] = 0;
+        queued[0] = true;
+        while (nwork != 0) {
+            size_t index = work[--nwork];
+            queued[index] = false;
+            vm_ir_block_t *block = head->body[index];
+            memcpy(cur, &ins[index * size], sizeof(uint8_t) * size);
+            vm_int_loop_block(block, cur);
+            for (size_t t = 0; t < 2; t++) {
+                vm_ir_block_t *target = block->branch->targets[t];
+                if (target == NULL) {
+                    continue;
+                }
+                uint8_t *into = NULL;
+                size_t tindex = 0;
+                if (target == head) {
+                    into = back;
+                } else {
+                    for (size_t j = 1; j < nbody; j++) {
+                        if (head->body[j] == target) {
+                            tindex = j;
+                            into = &ins[j * size];
+                            break;
                         }
                     }
+                    if (into == NULL) {
+                        continue;
+                    }
+                }
+                bool changed = false;
+                for (size_t j = 0; j < target->nargs; j++) {
+                    size_t reg = target->args[j];
+                    uint8_t type = into[reg];
+                    if (type == VM_TYPE_UNSET) {
+                        type = cur[reg];
+                    } else if (type != cur[reg] && cur[reg] != VM_TYPE_UNSET) {
+                        type = VM_TYPE_UNKNOWN;
+                    }
+                    if (type != into[reg]) {
+                        into[reg] = type;
+                        changed = true;
+                    }
+                }
+                if (changed && into != back && !queued[tindex]) {
+                    queued[tindex] = true;
+                    work[nwork++] = tindex;
                 }
-                break;
             }
-            case VM_IR_IOP_SUB: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = sub r r
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32SUB_RR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FSUB_RR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_F64;
-                            }
-                        } else {
-                            // r = sub r i
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && fmod(instr->args[1].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32SUB_RI);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_ival(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FSUB_RF);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_fval(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_F64;
-                            }
+        }
+        bool redo = false;
+        for (size_t i = 0; i < head->nargs; i++) {
+            size_t reg = head->args[i];
+            if (spec[reg] == VM_TYPE_I32 && back[reg] == VM_TYPE_F64) {
+                spec[reg] = VM_TYPE_F64;
+                redo = true;
+                any = true;
+            }
+        }
+        if (!redo) {
+            break;
+        }
+    }
+    vm_free(queued);
+    vm_free(work);
+    vm_free(cur);
+    vm_free(back);
+    vm_free(ins);
+    return any;
+}
+
+// conversions for a jump into a loop from outside of it, see vm_int_loop_spec
+#define vm_int_block_comp_loop_entry(target_)                                               \
+    do {                                                                                    \
+        vm_ir_block_t *head = (target_);                                                    \
+        if (VM_INT_LOOP_SPEC && head->body != NULL && !vm_ir_in_loop(head, block)) {        \
+            uint8_t *spec = vm_malloc(sizeof(uint8_t) * state->framesize);                  \
+            if (vm_int_loop_spec(state, head, types, spec)) {                               \
+                for (size_t i = 0; i < head->nargs; i++) {                                  \
+                    size_t hreg = head->args[i];                                            \
+                    if (spec[hreg] == VM_TYPE_F64 && types[hreg] == VM_TYPE_I32) {          \
+                        vm_int_block_comp_buf_check();                                      \
+                        vm_int_block_comp_ensure_float_reg(hreg);                           \
+                    }                                                                       \
+                }                                                                           \
+            }                                                                               \
+            vm_free(spec);                                                                  \
+        }                                                                                   \
+    } while (0)
+
+// eager compilation, see vm_int_precompile: every transfer the compiler emits
+// whose target has known argument types is queued, and what each version
+// returns is kept to type the continuations of the calls into it
+typedef struct {
+    vm_ir_block_t *block;
+    uint8_t *types;
+    // node that jumps here and call this is the callee entry of, or SIZE_MAX
+    size_t from;
+    size_t call;
+} vm_int_precomp_todo_t;
+
+typedef struct {
+    size_t from;
+    size_t callee;
+    vm_ir_block_t *next;
+    uint8_t *types;
+    size_t out;
+    // ret types that have their continuation queued already
+    uint32_t done;
+} vm_int_precomp_call_t;
+
+typedef struct {
+    void *ops;
+    // types returned by this version, and by it or anything it jumps to
+    uint32_t rets;
+    uint32_t reach;
+    size_t *succ;
+    size_t nsucc;
+    size_t asucc;
+} vm_int_precomp_node_t;
+
+struct vm_int_precomp_t {
+    size_t framesize;
+    vm_int_precomp_node_t *nodes;
+    size_t nnodes;
+    size_t anodes;
+    // open addressed on the ops of a version, holds node index + 1
+    uint32_t *table;
+    size_t table_alloc;
+    vm_int_precomp_call_t *calls;
+    size_t ncalls;
+    size_t acalls;
+    vm_int_precomp_todo_t *todos;
+    size_t ntodos;
+    size_t atodos;
+    // node the version being compiled becomes, and the types it returns
+    size_t cur;
+    uint32_t rets;
+};
+
+static uint8_t *vm_int_precomp_types(vm_int_precomp_t *pc, const uint8_t *types) {
+    uint8_t *ret = vm_malloc(sizeof(uint8_t) * pc->framesize);
+    if (types == NULL) {
+        memset(ret, VM_TYPE_UNSET, sizeof(uint8_t) * pc->framesize);
+    } else {
+        memcpy(ret, types, sizeof(uint8_t) * pc->framesize);
+    }
+    return ret;
+}
+
+static void vm_int_precomp_todo(vm_int_precomp_t *pc, vm_ir_block_t *block, uint8_t *types, size_t from, size_t call) {
+    if (pc->ntodos + 1 >= pc->atodos) {
+        pc->atodos = (pc->ntodos + 1) * 2;
+        pc->todos = vm_realloc(pc->todos, sizeof(vm_int_precomp_todo_t) * pc->atodos);
+    }
+    pc->todos[pc->ntodos++] = (vm_int_precomp_todo_t){
+        .block = block,
+        .types = types,
+        .from = from,
+        .call = call,
+    };
+}
+
+// a jump or branch out of the version being compiled
+static void vm_int_precomp_jump(vm_int_precomp_t *pc, vm_ir_block_t *block, const uint8_t *types) {
+    vm_int_precomp_todo(pc, block, vm_int_precomp_types(pc, types), pc->cur, SIZE_MAX);
+}
+
+// a call to a known function, next is NULL for a tail call which returns
+// whatever the callee does
+static void vm_int_precomp_call(vm_int_precomp_t *pc, vm_ir_instr_t *call, size_t nregs, const uint8_t *types, size_t out, vm_ir_block_t *next) {
+    uint8_t *entry = vm_int_precomp_types(pc, NULL);
+    for (size_t i = 1; call->args[i].type != VM_IR_ARG_NONE && i < pc->framesize; i++) {
+        size_t reg = call->args[i].type == VM_IR_ARG_REG ? call->args[i].reg : nregs + 1 + i;
+        entry[i] = reg < pc->framesize ? types[reg] : VM_TYPE_UNKNOWN;
+    }
+    if (next == NULL) {
+        vm_int_precomp_todo(pc, call->args[0].func, entry, pc->cur, SIZE_MAX);
+        return;
+    }
+    if (pc->ncalls + 1 >= pc->acalls) {
+        pc->acalls = (pc->ncalls + 1) * 2;
+        pc->calls = vm_realloc(pc->calls, sizeof(vm_int_precomp_call_t) * pc->acalls);
+    }
+    pc->calls[pc->ncalls++] = (vm_int_precomp_call_t){
+        .from = pc->cur,
+        .callee = SIZE_MAX,
+        .next = next,
+        .types = vm_int_precomp_types(pc, types),
+        .out = out,
+        .done = 0,
+    };
+    vm_int_precomp_todo(pc, call->args[0].func, entry, SIZE_MAX, pc->ncalls - 1);
+}
+
+static size_t vm_int_precomp_slot(vm_int_precomp_t *pc, void *ops) {
+    return (size_t)(((uint64_t)(size_t)ops * 0x9E3779B97F4A7C15llu) >> 32) & (pc->table_alloc - 1);
+}
+
+static size_t vm_int_precomp_find(vm_int_precomp_t *pc, void *ops) {
+    if (pc->table_alloc == 0) {
+        return SIZE_MAX;
+    }
+    for (size_t slot = vm_int_precomp_slot(pc, ops); pc->table[slot] != 0; slot = (slot + 1) & (pc->table_alloc - 1)) {
+        size_t index = pc->table[slot] - 1;
+        if (pc->nodes[index].ops == ops) {
+            return index;
+        }
+    }
+    return SIZE_MAX;
+}
+
+static void vm_int_precomp_insert(vm_int_precomp_t *pc, size_t index) {
+    size_t slot = vm_int_precomp_slot(pc, pc->nodes[index].ops);
+    while (pc->table[slot] != 0) {
+        slot = (slot + 1) & (pc->table_alloc - 1);
+    }
+    pc->table[slot] = (uint32_t)(index + 1);
+}
+
+static size_t vm_int_precomp_node(vm_int_precomp_t *pc, void *ops, uint32_t rets) {
+    if (pc->nnodes + 1 >= pc->anodes) {
+        pc->anodes = (pc->nnodes + 1) * 2;
+        pc->nodes = vm_realloc(pc->nodes, sizeof(vm_int_precomp_node_t) * pc->anodes);
+    }
+    size_t index = pc->nnodes++;
+    pc->nodes[index] = (vm_int_precomp_node_t){
+        .ops = ops,
+        .rets = rets,
+        .reach = rets,
+    };
+    // keep the table at most half full
+    if (pc->nnodes * 2 > pc->table_alloc) {
+        vm_free(pc->table);
+        pc->table_alloc = pc->table_alloc == 0 ? 64 : pc->table_alloc * 2;
+        pc->table = vm_alloc0(sizeof(uint32_t) * pc->table_alloc);
+        for (size_t i = 0; i < pc->nnodes; i++) {
+            vm_int_precomp_insert(pc, i);
+        }
+    } else {
+        vm_int_precomp_insert(pc, index);
+    }
+    return index;
+}
+
+static void vm_int_precomp_edge(vm_int_precomp_t *pc, size_t from, size_t to) {
+    vm_int_precomp_node_t *node = &pc->nodes[from];
+    if (node->nsucc + 1 >= node->asucc) {
+        node->asucc = (node->nsucc + 1) * 2;
+        node->succ = vm_realloc(node->succ, sizeof(size_t) * node->asucc);
+    }
+    node->succ[node->nsucc++] = to;
+}
+
+// puts a branch target, and with a precompile running queues the version
+// it will want, the types at the end of this version are the ones it gets
+#define vm_int_block_comp_put_target(block_)                         \
+    do {                                                             \
+        vm_ir_block_t *target_ = (block_);                           \
+        if (state->precomp != NULL) {                                \
+            vm_int_precomp_jump(state->precomp, target_, types);     \
+        }                                                            \
+        vm_int_block_comp_put_block(target_);                        \
+    } while (0)
+
+// versions per block are bucketed 1, 2, 3, 4, 5-8, 9-16, 17-64 and 65 up
+static size_t vm_int_comp_bucket(size_t nversions) {
+    if (nversions <= 4) {
+        return nversions - 1;
+    }
+    if (nversions <= 8) {
+        return 4;
+    }
+    if (nversions <= 16) {
+        return 5;
+    }
+    if (nversions <= 64) {
+        return 6;
+    }
+    return 7;
+}
+
+// monotonic nanoseconds, for the compile times in -icomp-stats
+static uint64_t vm_int_now(void) {
+#if !defined(_WIN32) && !defined(VM_WASM)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+void vm_int_comp_stats_print(vm_int_state_t *state, FILE *out) {
+    static const char *const buckets[VM_INT_COMP_HIST] = {"1", "2", "3", "4", "5-8", "9-16", "17-64", "65+"};
+    fprintf(out, "versions compiled eagerly: %zu in %.3fms\n", state->precomp_versions, (double)state->precomp_ns / 1e6);
+    fprintf(out, "versions compiled lazily: %zu in %.3fms\n", state->comp_versions, (double)state->comp_ns / 1e6);
+    fprintf(out, "blocks compiled: %zu, threaded code: %zu bytes\n", state->comp_blocks, state->comp_bytes);
+    fprintf(out, "blocks past %zu versions: %zu\n", (size_t)VM_INT_MAX_VERSIONS, state->comp_megamorphic);
+    fprintf(out, "version lookups: %zu, hits: %zu (%.1f%%)\n", state->comp_lookups, state->comp_hits,
+            state->comp_lookups == 0 ? 0.0 : 100.0 * (double)state->comp_hits / (double)state->comp_lookups);
+    fprintf(out, "%12s  versions per block\n", "blocks");
+    for (size_t i = 0; i < VM_INT_COMP_HIST; i++) {
+        if (state->comp_hist[i] != 0) {
+            fprintf(out, "%12zu  %s\n", state->comp_hist[i], buckets[i]);
+        }
+    }
+    fprintf(out, "call sites linked on return: %zu, with more than one type: %zu\n", state->ret_sites, state->ret_poly);
+}
+
+// the version of a block past VM_INT_MAX_VERSIONS, one for every type of its
+// args: vm_int_generic_run interprets the block checking tags as it goes and
+// where it leaves to is looked up again on each run. a call it makes returns
+// to a jump that does that lookup for every returned type, since the types
+// in the caller's frame can differ between runs by more than the return
+static vm_int_opcode_t *vm_int_generic_comp(vm_int_state_t *state, void **ptrs, vm_ir_block_t *block) {
+    vm_int_data_t *data = block->data;
+    uint64_t comp_begin = vm_int_now();
+    size_t regions_at = state->sample_regions_len;
+    vm_int_buf_t buf;
+    buf.len = 0;
+    buf.alloc = 128;
+    buf.ops = vm_alloc0(sizeof(vm_int_opcode_t) * buf.alloc);
+    size_t fuse_op = VM_INT_MAX_OP;
+    size_t fuse_at = 0;
+    // the return slots point into buf, so it has to fit without moving
+    vm_int_block_comp_buf_check();
+    if (state->sample != NULL) {
+        vm_int_sample_region(state, buf.len, block->id);
+        if (block->isfunc || data->ret) {
+            vm_int_block_comp_put_wide(ptr, ptrs[VM_INT_OP_SAMPLE]);
+        }
+    }
+    if (state->block_counts != NULL && block->id >= 0 && (size_t)block->id < state->block_counts_len) {
+        vm_int_block_comp_put_wide(ptr, ptrs[VM_INT_OP_COUNT_BLOCK]);
+        buf.ops[buf.len++].reg = block->id;
+    }
+    vm_ir_block_t *next = NULL;
+    size_t out = block->nregs + 1;
+    if (block->len != 0 && block->branch->op == VM_IR_BOP_JUMP) {
+        vm_ir_instr_t *call = block->instrs[block->len - 1];
+        if (call->op == VM_IR_IOP_CALL && call->args[0].type != VM_IR_ARG_EXTERN) {
+            next = block->branch->targets[0];
+            if (call->out.type == VM_IR_ARG_REG) {
+                out = call->out.reg;
+            }
+            if (state->sample != NULL) {
+                if (next->data == NULL) {
+                    next->data = vm_alloc0(sizeof(vm_int_data_t));
+                }
+                ((vm_int_data_t *)next->data)->ret = true;
+            }
+        }
+    }
+    vm_int_block_comp_put_ptr(VM_INT_OP_GENERIC);
+    vm_int_block_comp_put_block(block);
+    vm_int_block_comp_put_frame();
+    buf.ops[buf.len++].reg = out;
+    vm_int_block_comp_put_block(next);
+    size_t slots = buf.len;
+    buf.len += VM_INT_WIDE * (VM_TYPE_MAX - 1);
+    vm_int_opcode_t *ret = &buf.ops[buf.len];
+    vm_int_block_comp_put_ptr(VM_INT_OP_GENERIC_JUMP);
+    vm_int_block_comp_put_block(next);
+    for (uint8_t i = 0; i < VM_TYPE_MAX - 1; i++) {
+        vm_int_wide(&buf.ops[slots + VM_INT_WIDE * i])->ptr = ret;
+    }
+    for (size_t i = regions_at; i < state->sample_regions_len; i++) {
+        state->sample_regions[i].ops = buf.ops;
+        state->sample_regions[i].len = buf.len;
+    }
+    state->comp_megamorphic += 1;
+    state->comp_versions += 1;
+    state->comp_bytes += sizeof(vm_int_opcode_t) * buf.len;
+    state->comp_ns += vm_int_now() - comp_begin;
+    return buf.ops;
+}
+
+void *vm_int_block_comp(vm_int_state_t *state, void **ptrs, vm_ir_block_t *block) {
+    if (state->use_spall) {
+        double begin = vm_trace_time();
+        vm_trace_begin(&state->spall_ctx, NULL, begin, "Basic Block Compile");
+        vm_trace_begin(&state->spall_ctx, NULL, begin, "Basic Block Cache Check");
+    }
+    vm_int_data_t *data = block->data;
+    if (data == NULL) {
+        data = vm_alloc0(sizeof(vm_int_data_t));
+        block->data = data;
+    }
+    uint64_t key = vm_int_data_key(state, block);
+    size_t found;
+    state->comp_lookups += 1;
+    if (vm_int_data_find(data, state, block, key, &found)) {
+        state->comp_hits += 1;
+        if (state->use_spall) {
+            double end = vm_trace_time();
+            vm_trace_end(&state->spall_ctx, NULL, end);
+            vm_trace_end(&state->spall_ctx, NULL, end);
+        }
+        return data->bufs[found].ops;
+    }
+    if (VM_INT_MAX_VERSIONS != 0 && data->len >= VM_INT_MAX_VERSIONS && ptrs[VM_INT_OP_GENERIC] != NULL) {
+        if (data->generic == NULL) {
+            data->generic = vm_int_generic_comp(state, ptrs, block);
+        } else {
+            state->comp_hits += 1;
+        }
+        if (state->use_spall) {
+            double end = vm_trace_time();
+            vm_trace_end(&state->spall_ctx, NULL, end);
+            vm_trace_end(&state->spall_ctx, NULL, end);
+        }
+        return data->generic;
+    }
+    if (state->use_spall) {
+        vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
+    }
+    uint64_t comp_begin = vm_int_now();
+    size_t regions_at = state->sample_regions_len;
+    vm_int_buf_t buf;
+    buf.len = 0;
+    buf.alloc = 128;
+    buf.ops = vm_alloc0(sizeof(vm_int_opcode_t) * buf.alloc);
+    size_t fuse_op = VM_INT_MAX_OP;
+    size_t fuse_at = 0;
+    uint8_t *types = vm_malloc(sizeof(uint8_t) * state->framesize);
+    memset(types, VM_TYPE_UNSET, sizeof(uint8_t) * state->framesize);
+    size_t *konst = vm_alloc0(sizeof(size_t) * state->framesize);
+    size_t nexits = 0;
+    size_t *exits = NULL;
+    vm_ir_block_t **exit_blocks = NULL;
+    for (size_t i = 0; i < block->nargs; i++) {
+        size_t reg = block->args[i];
+        types[reg] = vm_typeof(state->locals[reg]);
+        if (types[reg] == VM_TYPE_UNSET) {
+            fprintf(stderr, "unset reg in .L%zu: r%zu (arg #%zu)\n", block->id, reg, i);
+            __builtin_trap();
+        }
+    }
+#if defined(VM_DEBUG_COMP)
+    fprintf(stderr, "block .%zu(", block->id);
+    for (size_t i = 0; i < block->nargs; i++) {
+        if (i != 0) {
+            fprintf(stderr, ", ");
+        }
+        size_t reg = block->args[i];
+        uint8_t type = types[reg];
+        static const char *const typenames[VM_TYPE_MAX] = {
+            [VM_TYPE_UNSET] = "unset",
+            [VM_TYPE_NIL] = "nil",
+            [VM_TYPE_BOOL] = "bool",
+            [VM_TYPE_I32] = "int",
+            [VM_TYPE_F64] = "float",
+            [VM_TYPE_FUNC] = "func",
+            [VM_TYPE_ARRAY] = "array",
+            [VM_TYPE_TABLE] = "table",
+        };
+        const char *typename = typenames[type];
+        if (!typename) __builtin_trap();
+        fprintf(stderr, "r%zu : %s", reg, typename);
+    }
+    fprintf(stderr, ") {\n");
+#endif
+inline_jump:;
+    if (state->sample != NULL) {
+        vm_int_block_comp_buf_check();
+        vm_int_sample_region(state, buf.len, block->id);
+        // only calls and returns publish, a sample is charged to the function
+        // entry or call continuation it was taken after
+        if (buf.len == 0 && (block->isfunc || data->ret)) {
+            vm_int_block_comp_put_wide(ptr, ptrs[VM_INT_OP_SAMPLE]);
+            fuse_op = VM_INT_MAX_OP;
+        }
+    }
+    if (state->block_counts != NULL && block->id >= 0 && (size_t)block->id < state->block_counts_len) {
+        vm_int_block_comp_buf_check();
+        vm_int_block_comp_put_wide(ptr, ptrs[VM_INT_OP_COUNT_BLOCK]);
+        buf.ops[buf.len++].reg = block->id;
+        fuse_op = VM_INT_MAX_OP;
+    }
+    for (size_t arg = 0; arg < block->len; arg++) {
+        vm_ir_instr_t *instr = block->instrs[arg];
+#if defined(VM_DEBUG_COMP)
+        if (instr->op != VM_IR_IOP_NOP) {
+            fprintf(stderr, "  ");
+            vm_ir_print_instr(stderr, instr);
+            fprintf(stderr, "\n");
+            fflush(stderr);
+        }
+#endif
+        vm_int_block_comp_buf_check();
+        switch (instr->op) {
+            case VM_IR_IOP_NOP: {
+                break;
+            }
+            case VM_IR_IOP_MOVE: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    switch (instr->args[0].type) {
+                        case VM_IR_ARG_REG: {
+                            // r = move r
+                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_R);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            types[instr->out.reg] = types[instr->args[0].reg];
+                            break;
                         }
-                    } else {
-                        if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = sub i r
-                            if (types[instr->args[1].reg] == VM_TYPE_I32 && fmod(instr->args[0].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32SUB_IR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_ival(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FSUB_FR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_fval(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_F64;
-                            }
-                        } else {
+                        case VM_IR_ARG_NIL: {
                             // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num - instr->args[1].num);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_V);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            types[instr->out.reg] = VM_TYPE_NIL;
+                            break;
+                        }
+                        case VM_IR_ARG_BOOL: {
+                            // r = move i
+                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_B);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_bval(instr->args[0]);
+                            types[instr->out.reg] = VM_TYPE_BOOL;
+                            break;
+                        }
+                        case VM_IR_ARG_NUM: {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num);
+                            break;
+                        }
+                        case VM_IR_ARG_STR: {
+                            fprintf(stderr, "NO STRINGS YET\n");
+                            __builtin_trap();
+                        }
+                        case VM_IR_ARG_FUNC: {
+                            // r = move i
+                            vm_int_block_comp_put_ptr(VM_INT_OP_MOV_T);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_block(instr->args[0].func);
+                            types[instr->out.reg] = VM_TYPE_FUNC;
+                            break;
                         }
                     }
                 }
                 break;
             }
-            case VM_IR_IOP_MUL: {
+            case VM_IR_IOP_BOR: {
                 if (instr->out.type == VM_IR_ARG_REG) {
                     if (instr->args[0].type == VM_IR_ARG_REG) {
                         if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = mul r r
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MUL_RR);
-                                vm_int_block_comp_put_out(instr->out.reg);
-                                vm_int_block_comp_put_reg(instr->args[0]);
-                                vm_int_block_comp_put_reg(instr->args[1]);
-                                types[instr->out.reg] = VM_TYPE_I32;
-                            } else {
-                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
+                            // r = bor r r
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BOR_RR);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = bor r i
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BOR_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_ival(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor i r
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BOR_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            vm_int_block_comp_put_ival(instr->args[0]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num | (vm_int_t)instr->args[1].num));
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_BAND: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor r r
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BAND_RR);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = bor r i
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BAND_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_ival(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor i r
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BAND_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            vm_int_block_comp_put_ival(instr->args[0]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num & (vm_int_t)instr->args[1].num));
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_BXOR: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor r r
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BXOR_RR);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = bor r i
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BXOR_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_ival(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor i r
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BXOR_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            vm_int_block_comp_put_ival(instr->args[0]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num ^ (vm_int_t)instr->args[1].num));
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_BSHL: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor r r
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHL_RR);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = bor r i
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHL_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_ival(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor i r
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHL_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            vm_int_block_comp_put_ival(instr->args[0]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num << (vm_int_t)instr->args[1].num));
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_BSHR: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor r r
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHR_RR);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = bor r i
+                            vm_int_block_comp_ensure_int_reg(instr->args[0].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHR_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[0]);
+                            vm_int_block_comp_put_ival(instr->args[1]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = bor i r
+                            vm_int_block_comp_ensure_int_reg(instr->args[1].reg);
+                            vm_int_block_comp_put_ptr(VM_INT_OP_I32BSHR_RI);
+                            vm_int_block_comp_put_out(instr->out.reg);
+                            vm_int_block_comp_put_reg(instr->args[1]);
+                            vm_int_block_comp_put_ival(instr->args[0]);
+                            types[instr->out.reg] = VM_TYPE_I32;
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, (double)((vm_int_t)instr->args[0].num >> (vm_int_t)instr->args[1].num));
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_ADD: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = add r r
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32ADD_RR);
+                                vm_int_block_comp_exit();
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_I32;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
                                 vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FMUL_RR);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FADD_RR);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
                                 types[instr->out.reg] = VM_TYPE_F64;
                             }
                         } else {
-                            // r = mul r i
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && fmod(instr->args[1].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MUL_RI);
+                            // r = add r i
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[1].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32ADD_RI);
+                                vm_int_block_comp_exit();
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_ival(instr->args[1]);
                                 types[instr->out.reg] = VM_TYPE_I32;
                             } else {
                                 vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FMUL_RF);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FADD_RF);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_fval(instr->args[1]);
@@ -605,16 +1512,17 @@ inline_jump:;
                         }
                     } else {
                         if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = mul i r
-                            if (types[instr->args[1].reg] == VM_TYPE_I32 && fmod(instr->args[0].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MUL_RI);
+                            // r = add i r
+                            if (types[instr->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[0].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32ADD_RI);
+                                vm_int_block_comp_exit();
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[1]);
                                 vm_int_block_comp_put_ival(instr->args[0]);
                                 types[instr->out.reg] = VM_TYPE_I32;
                             } else {
                                 vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FMUL_RF);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FADD_RF);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[1]);
                                 vm_int_block_comp_put_fval(instr->args[0]);
@@ -628,43 +1536,39 @@ inline_jump:;
                 }
                 break;
             }
-            case VM_IR_IOP_DIV: {
+            case VM_IR_IOP_SUB: {
                 if (instr->out.type == VM_IR_ARG_REG) {
                     if (instr->args[0].type == VM_IR_ARG_REG) {
                         if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = div r r
+                            // r = sub r r
                             if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32DIV_RR);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32SUB_RR);
+                                vm_int_block_comp_exit();
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
-                                vm_int_block_comp_put_block(block->branch->targets[0]);
-                                vm_int_block_comp_put_block(NULL);
-                                vm_int_block_comp_put_block(NULL);
-                                goto retv;
+                                types[instr->out.reg] = VM_TYPE_I32;
                             } else {
                                 vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
                                 vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FDIV_RR);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FSUB_RR);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
                                 types[instr->out.reg] = VM_TYPE_F64;
                             }
                         } else {
-                            // r = div r i
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && fmod(instr->args[1].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32DIV_RI);
+                            // r = sub r i
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[1].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32SUB_RI);
+                                vm_int_block_comp_exit();
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_ival(instr->args[1]);
-                                vm_int_block_comp_put_block(block->branch->targets[0]);
-                                vm_int_block_comp_put_block(NULL);
-                                vm_int_block_comp_put_block(NULL);
-                                goto retv;
+                                types[instr->out.reg] = VM_TYPE_I32;
                             } else {
                                 vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FDIV_RF);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FSUB_RF);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_fval(instr->args[1]);
@@ -673,19 +1577,17 @@ inline_jump:;
                         }
                     } else {
                         if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = div i r
-                            if (types[instr->args[1].reg] == VM_TYPE_I32 && fmod(instr->args[0].num, 1) == 0.0) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32DIV_IR);
+                            // r = sub i r
+                            if (types[instr->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[0].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32SUB_IR);
+                                vm_int_block_comp_exit();
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_ival(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
-                                vm_int_block_comp_put_block(block->branch->targets[0]);
-                                vm_int_block_comp_put_block(NULL);
-                                vm_int_block_comp_put_block(NULL);
-                                goto retv;
+                                types[instr->out.reg] = VM_TYPE_I32;
                             } else {
                                 vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
-                                vm_int_block_comp_put_ptr(VM_INT_OP_FDIV_FR);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FSUB_FR);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_fval(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
@@ -693,19 +1595,155 @@ inline_jump:;
                             }
                         } else {
                             // r = move i
-                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num / instr->args[1].num);
+                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num - instr->args[1].num);
                         }
                     }
                 }
                 break;
             }
-            case VM_IR_IOP_MOD: {
+            case VM_IR_IOP_MUL: {
                 if (instr->out.type == VM_IR_ARG_REG) {
                     if (instr->args[0].type == VM_IR_ARG_REG) {
                         if (instr->args[1].type == VM_IR_ARG_REG) {
-                            // r = mod r r
+                            // r = mul r r
                             if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
-                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MOD_RR);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MUL_RR);
+                                vm_int_block_comp_exit();
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_I32;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
+                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FMUL_RR);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_F64;
+                            }
+                        } else {
+                            // r = mul r i
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[1].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MUL_RI);
+                                vm_int_block_comp_exit();
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_ival(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_I32;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FMUL_RF);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_fval(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_F64;
+                            }
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = mul i r
+                            if (types[instr->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[0].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MUL_RI);
+                                vm_int_block_comp_exit();
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                vm_int_block_comp_put_ival(instr->args[0]);
+                                types[instr->out.reg] = VM_TYPE_I32;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FMUL_RF);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                vm_int_block_comp_put_fval(instr->args[0]);
+                                types[instr->out.reg] = VM_TYPE_F64;
+                            }
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num + instr->args[1].num);
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_DIV: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = div r r
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32DIV_RR);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                vm_int_block_comp_put_block(block->branch->targets[0]);
+                                vm_int_block_comp_put_block(NULL);
+                                vm_int_block_comp_put_block(NULL);
+                                goto retv;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
+                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FDIV_RR);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_F64;
+                            }
+                        } else {
+                            // r = div r i
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[1].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32DIV_RI);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_ival(instr->args[1]);
+                                vm_int_block_comp_put_block(block->branch->targets[0]);
+                                vm_int_block_comp_put_block(NULL);
+                                vm_int_block_comp_put_block(NULL);
+                                goto retv;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FDIV_RF);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_reg(instr->args[0]);
+                                vm_int_block_comp_put_fval(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_F64;
+                            }
+                        }
+                    } else {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = div i r
+                            if (types[instr->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[0].num)) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32DIV_IR);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_ival(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                vm_int_block_comp_put_block(block->branch->targets[0]);
+                                vm_int_block_comp_put_block(NULL);
+                                vm_int_block_comp_put_block(NULL);
+                                goto retv;
+                            } else {
+                                vm_int_block_comp_ensure_float_reg(instr->args[1].reg);
+                                vm_int_block_comp_put_ptr(VM_INT_OP_FDIV_FR);
+                                vm_int_block_comp_put_out(instr->out.reg);
+                                vm_int_block_comp_put_fval(instr->args[0]);
+                                vm_int_block_comp_put_reg(instr->args[1]);
+                                types[instr->out.reg] = VM_TYPE_F64;
+                            }
+                        } else {
+                            // r = move i
+                            vm_int_block_comp_mov(instr->out.reg, instr->args[0].num / instr->args[1].num);
+                        }
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_MOD: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        if (instr->args[1].type == VM_IR_ARG_REG) {
+                            // r = mod r r
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && types[instr->args[1].reg] == VM_TYPE_I32) {
+                                vm_int_block_comp_put_ptr(VM_INT_OP_I32MOD_RR);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
@@ -721,7 +1759,7 @@ inline_jump:;
                             }
                         } else {
                             // r = mod r i
-                            if (types[instr->args[0].reg] == VM_TYPE_I32 && fmod(instr->args[1].num, 1) == 0.0) {
+                            if (types[instr->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[1].num)) {
                                 vm_int_block_comp_put_ptr(VM_INT_OP_I32MOD_RI);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_reg(instr->args[0]);
@@ -739,7 +1777,7 @@ inline_jump:;
                     } else {
                         if (instr->args[1].type == VM_IR_ARG_REG) {
                             // r = mod i r
-                            if (types[instr->args[1].reg] == VM_TYPE_I32 && fmod(instr->args[0].num, 1) == 0.0) {
+                            if (types[instr->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(instr->args[0].num)) {
                                 vm_int_block_comp_put_ptr(VM_INT_OP_I32MOD_IR);
                                 vm_int_block_comp_put_out(instr->out.reg);
                                 vm_int_block_comp_put_ival(instr->args[0]);
@@ -761,45 +1799,97 @@ inline_jump:;
                 }
                 break;
             }
-            case VM_IR_IOP_CALL: {
+            case VM_IR_IOP_CALL:
+            case VM_IR_IOP_TCALL: {
+                vm_ir_block_t *inlined = vm_int_inline_call(state, block, instr);
+                if (inlined != NULL) {
+                    block = inlined;
+                    goto inline_jump;
+                }
                 for (size_t i = 1; instr->args[i].type != VM_IR_ARG_NONE; i++) {
                     if (instr->args[i].type == VM_IR_ARG_NUM) {
-                        vm_int_block_comp_mov(state->framesize + i, instr->args[0].num);
+                        vm_int_block_comp_mov(block->nregs + 1 + i, instr->args[i].num);
                     }
                 }
                 size_t nargs = 0;
                 for (size_t i = 1; instr->args[i].type != VM_IR_ARG_NONE; i++) {
                     nargs += 1;
                 }
+                if (instr->op == VM_IR_IOP_TCALL && instr->args[0].type != VM_IR_ARG_EXTERN && ptrs[VM_INT_OP_TCALL_T] != NULL) {
+                    // nothing in this frame runs after the call, so the callee
+                    // takes the frame over and returns straight to our caller
+                    if (instr->args[0].type == VM_IR_ARG_FUNC) {
+                        if (state->precomp != NULL) {
+                            vm_int_precomp_call(state->precomp, instr, block->nregs, types, 0, NULL);
+                        }
+                        vm_int_block_comp_put_ptr(VM_INT_OP_TCALL_T);
+                        vm_int_block_comp_put_block(instr->args[0].func);
+                    } else if (types[instr->args[0].reg] == VM_TYPE_FUNC) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_TCALL_R);
+                        vm_int_block_comp_put_reg(instr->args[0]);
+                    } else if (types[instr->args[0].reg] == VM_TYPE_ARRAY) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_TCALL_C);
+                        vm_int_block_comp_put_reg(instr->args[0]);
+                    } else {
+                        vm_int_block_comp_type_error("type error on call r%zu (type %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
+                    }
+                    vm_int_block_comp_put_frame();
+                    vm_int_block_comp_put_ivalc((int32_t)nargs);
+                    for (size_t i = 1; instr->args[i].type != VM_IR_ARG_NONE; i++) {
+                        if (instr->args[i].type == VM_IR_ARG_NUM) {
+                            vm_int_block_comp_put_regc(block->nregs + 1 + i);
+                        } else {
+                            vm_int_block_comp_put_reg(instr->args[i]);
+                        }
+                    }
+                    goto retv;
+                }
+                // each family has ops for a fixed count up to 8 args, 7 for
+                // closures since the array is passed first, past that the
+                // count is the op's first operand after the callee
+                bool many = nargs > 8;
                 if (instr->args[0].type == VM_IR_ARG_FUNC) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_CALL_T0 + nargs);
+                    vm_int_block_comp_put_ptr(many ? VM_INT_OP_CALL_TN : VM_INT_OP_CALL_T0 + nargs);
                     vm_int_block_comp_put_block(instr->args[0].func);
                 } else if (instr->args[0].type == VM_IR_ARG_EXTERN) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_CALL_X0 + nargs);
+                    vm_int_block_comp_put_ptr(many ? VM_INT_OP_CALL_XN : VM_INT_OP_CALL_X0 + nargs);
                     vm_int_block_comp_put_ival(instr->args[0]);
                 } else if (types[instr->args[0].reg] == VM_TYPE_FUNC) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_CALL_R0 + nargs);
-                    vm_int_block_comp_put_block(instr->args[0].func);
+                    vm_int_block_comp_put_ptr(many ? VM_INT_OP_CALL_RN : VM_INT_OP_CALL_R0 + nargs);
+                    vm_int_block_comp_put_reg(instr->args[0]);
                 } else if (types[instr->args[0].reg] == VM_TYPE_ARRAY) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_CALL_C0 + nargs);
+                    many = nargs > 7;
+                    vm_int_block_comp_put_ptr(many ? VM_INT_OP_CALL_CN : VM_INT_OP_CALL_C0 + nargs);
                     vm_int_block_comp_put_reg(instr->args[0]);
                 } else {
-                    fprintf(stderr, "type error on call r%zu (type %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
-                    __builtin_trap();
+                    vm_int_block_comp_type_error("type error on call r%zu (type %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
+                }
+                if (many) {
+                    vm_int_block_comp_put_ivalc((int32_t)nargs);
                 }
                 for (size_t i = 1; instr->args[i].type != VM_IR_ARG_NONE; i++) {
                     if (instr->args[i].type == VM_IR_ARG_NUM) {
-                        vm_int_block_comp_put_regc(state->framesize + i);
+                        vm_int_block_comp_put_regc(block->nregs + 1 + i);
                     } else {
                         vm_int_block_comp_put_reg(instr->args[i]);
                     }
                 }
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    vm_int_block_comp_put_out(instr->out.reg);
-                } else {
-                    vm_int_block_comp_put_out(block->nregs + 1);
+                if (instr->args[0].type != VM_IR_ARG_EXTERN) {
+                    vm_int_block_comp_put_frame();
+                }
+                size_t out = instr->out.type == VM_IR_ARG_REG ? instr->out.reg : block->nregs + 1;
+                if (state->precomp != NULL && instr->args[0].type == VM_IR_ARG_FUNC) {
+                    vm_int_precomp_call(state->precomp, instr, block->nregs, types, out, block->branch->targets[0]);
                 }
+                vm_int_block_comp_put_out(out);
                 vm_int_block_comp_put_block(block->branch->targets[0]);
+                if (state->sample != NULL) {
+                    vm_ir_block_t *next = block->branch->targets[0];
+                    if (next->data == NULL) {
+                        next->data = vm_alloc0(sizeof(vm_int_data_t));
+                    }
+                    ((vm_int_data_t *)next->data)->ret = true;
+                }
                 for (uint8_t i = 1; i < VM_TYPE_MAX; i++) {
                     vm_int_block_comp_put_block(NULL);
                 }
@@ -809,6 +1899,7 @@ inline_jump:;
                 if (instr->out.type == VM_IR_ARG_REG) {
                     vm_int_block_comp_put_ptr(VM_INT_OP_TAB);
                     vm_int_block_comp_put_out(instr->out.reg);
+                    vm_int_block_comp_put_frame();
                     types[instr->out.reg] = VM_TYPE_TABLE;
                 }
                 break;
@@ -821,12 +1912,14 @@ inline_jump:;
                         vm_int_block_comp_put_ptr(VM_INT_OP_ARR_R);
                         vm_int_block_comp_put_out(instr->out.reg);
                         vm_int_block_comp_put_reg(instr->args[0]);
+                        vm_int_block_comp_put_frame();
                         types[instr->out.reg] = VM_TYPE_ARRAY;
                     } else {
                         // r = new i
                         vm_int_block_comp_put_ptr(VM_INT_OP_ARR_F);
                         vm_int_block_comp_put_out(instr->out.reg);
                         vm_int_block_comp_put_fval(instr->args[0]);
+                        vm_int_block_comp_put_frame();
                         types[instr->out.reg] = VM_TYPE_ARRAY;
                     }
                 }
@@ -849,8 +1942,7 @@ inline_jump:;
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_reg(instr->args[1]);
                             } else {
-                                fprintf(stderr, "cannot get: r%zu (tag: %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
-                                __builtin_trap();
+                                vm_int_block_comp_type_error("cannot get: r%zu (tag: %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
                             }
                         } else {
                             // r = get r i
@@ -865,8 +1957,7 @@ inline_jump:;
                                 vm_int_block_comp_put_reg(instr->args[0]);
                                 vm_int_block_comp_put_fval(instr->args[1]);
                             } else {
-                                fprintf(stderr, "cannot get: r%zu (tag: %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
-                                __builtin_trap();
+                                vm_int_block_comp_type_error("cannot get: r%zu (tag: %zu)\n", instr->args[0].reg, (size_t)types[instr->args[0].reg]);
                             }
                         }
                         vm_int_block_comp_put_block(block->branch->targets[0]);
@@ -895,8 +1986,7 @@ inline_jump:;
                                 vm_int_block_comp_put_reg(instr->args[1]);
                                 vm_int_block_comp_put_reg(instr->args[2]);
                             } else {
-                                fprintf(stderr, "cannot set: r%zu\n", instr->args[0].reg);
-                                __builtin_trap();
+                                vm_int_block_comp_type_error("cannot set: r%zu\n", instr->args[0].reg);
                             }
                         } else {
                             // set r r i
@@ -912,8 +2002,7 @@ inline_jump:;
                                 vm_int_block_comp_put_reg(instr->args[1]);
                                 vm_int_block_comp_put_fval(instr->args[2]);
                             } else {
-                                fprintf(stderr, "cannot set: r%zu\n", instr->args[0].reg);
-                                __builtin_trap();
+                                vm_int_block_comp_type_error("cannot set: r%zu\n", instr->args[0].reg);
                             }
                         }
                     } else {
@@ -930,8 +2019,7 @@ inline_jump:;
                                 vm_int_block_comp_put_fval(instr->args[1]);
                                 vm_int_block_comp_put_reg(instr->args[2]);
                             } else {
-                                fprintf(stderr, "cannot set: r%zu\n", instr->args[0].reg);
-                                __builtin_trap();
+                                vm_int_block_comp_type_error("cannot set: r%zu\n", instr->args[0].reg);
                             }
                         } else {
                             // set r i i
@@ -946,8 +2034,7 @@ inline_jump:;
                                 vm_int_block_comp_put_fval(instr->args[1]);
                                 vm_int_block_comp_put_fval(instr->args[2]);
                             } else {
-                                fprintf(stderr, "cannot set: r%zu\n", instr->args[0].reg);
-                                __builtin_trap();
+                                vm_int_block_comp_type_error("cannot set: r%zu\n", instr->args[0].reg);
                             }
                         }
                     }
@@ -964,509 +2051,1885 @@ inline_jump:;
                             vm_int_block_comp_put_reg(instr->args[0]);
                             types[instr->out.reg] = VM_TYPE_I32;
                         } else {
-                            fprintf(stderr, "cannot len: r%zu\n", instr->args[0].reg);
-                            __builtin_trap();
+                            vm_int_block_comp_type_error("cannot len: r%zu\n", instr->args[0].reg);
                         }
                     }
                 }
-                break;
+                break;
+            }
+            case VM_IR_IOP_TYPE: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    if (instr->args[0].type == VM_IR_ARG_REG) {
+                        // r = type r
+                        vm_int_block_comp_mov(instr->out.reg, types[instr->args[0].reg]);
+                    } else {
+                        // r = move i
+                        vm_int_block_comp_mov(instr->out.reg, VM_TYPE_F64);
+                    }
+                }
+                break;
+            }
+            case VM_IR_IOP_IN: {
+                if (instr->out.type == VM_IR_ARG_REG) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_IN_V);
+                    vm_int_block_comp_put_out(instr->out.reg);
+                    types[instr->out.reg] = VM_TYPE_I32;
+                }
+                break;
+            }
+            case VM_IR_IOP_OUT: {
+                if (instr->args[0].type == VM_IR_ARG_NUM) {
+                    // out i
+                    vm_int_block_comp_put_ptr(VM_INT_OP_OUT_I);
+                    vm_int_block_comp_put_ival(instr->args[0]);
+                } else {
+                    // out r
+                    vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
+                    vm_int_block_comp_put_ptr(VM_INT_OP_OUT_R);
+                    vm_int_block_comp_put_reg(instr->args[0]);
+                }
+                break;
+            }
+            default: {
+                fprintf(stderr, "unimplemented op: %zu\n", (size_t)instr->op);
+                __builtin_trap();
+            }
+        }
+    }
+    vm_int_block_comp_buf_check();
+    switch (block->branch->op) {
+        case VM_IR_BOP_JUMP: {
+            vm_int_block_comp_loop_entry(block->branch->targets[0]);
+            // jump l
+            if (block->branch->targets[0]->id <= block->id || !VM_ALLOW_INLINE_JUMPS) {
+                vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                vm_int_block_comp_put_target(block->branch->targets[0]);
+            } else {
+                block = block->branch->targets[0];
+                goto inline_jump;
+            }
+            break;
+        }
+        case VM_IR_BOP_BOOL: {
+            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
+                // jump l
+                vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                vm_int_block_comp_put_target(block->branch->targets[block->branch->args[0].num != 0]);
+            } else {
+                // bb r l l
+                if (types[block->branch->args[0].reg] == VM_TYPE_BOOL) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_BB_RTT);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                    vm_int_block_comp_put_target(block->branch->targets[0]);
+                    vm_int_block_comp_put_target(block->branch->targets[1]);
+                } else if (types[block->branch->args[0].reg] == VM_TYPE_NIL) {
+                    if (block->branch->targets[0]->id <= block->id) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                    } else {
+                        block = block->branch->targets[0];
+                        goto inline_jump;
+                    }
+                } else {
+                    if (block->branch->targets[1]->id <= block->id) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        block = block->branch->targets[1];
+                        goto inline_jump;
+                    }
+                }
+            }
+            break;
+        }
+        case VM_IR_BOP_LESS: {
+            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
+                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
+                    // jump l
+                    vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                    vm_int_block_comp_put_target(
+                        block->branch->targets[block->branch->args[0].num < block->branch->args[1].num]);
+                } else {
+                    // blt i r l l
+                    if (types[block->branch->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(block->branch->args[0].num)) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BLT_IRTT);
+                        vm_int_block_comp_put_ival(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[1].reg);
+                        vm_int_block_comp_put_ptr(VM_INT_OP_FBLT_FRTT);
+                        vm_int_block_comp_put_fval(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    }
+                }
+            } else {
+                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
+                    // blt r i l l
+                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(block->branch->args[1].num)) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BLT_RITT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_ival(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
+                        vm_int_block_comp_put_ptr(VM_INT_OP_FBLT_RFTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_fval(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    }
+                } else {
+                    // blt r r l l
+                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && types[block->branch->args[1].reg] == VM_TYPE_I32) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BLT_RRTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[1].reg);
+                        vm_int_block_comp_put_ptr(VM_INT_OP_FBLT_RRTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    }
+                }
+            }
+            break;
+        }
+        case VM_IR_BOP_EQUAL: {
+            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
+                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
+                    // jump l
+                    vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                    vm_int_block_comp_put_target(
+                        block->branch->targets[block->branch->args[0].num == block->branch->args[1].num]);
+                } else {
+                    // beq i r l l
+                    if (types[block->branch->args[1].reg] == VM_TYPE_I32 && vm_int_is_int(block->branch->args[0].num)) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BEQ_IRTT);
+                        vm_int_block_comp_put_ival(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else if (types[block->branch->args[1].reg] == VM_TYPE_I32 || types[block->branch->args[1].reg] == VM_TYPE_F64) {
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
+                        vm_int_block_comp_put_ptr(VM_INT_OP_FBEQ_FRTT);
+                        vm_int_block_comp_put_fval(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                    }
+                }
+            } else {
+                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
+                    // beq r i l l
+                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && vm_int_is_int(block->branch->args[1].num)) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BEQ_RITT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_ival(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else if (types[block->branch->args[0].reg] == VM_TYPE_I32 || types[block->branch->args[0].reg] == VM_TYPE_F64) {
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
+                        vm_int_block_comp_put_ptr(VM_INT_OP_FBEQ_RFTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_fval(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                    }
+                } else {
+                    // beq r r l l
+                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && types[block->branch->args[1].reg] == VM_TYPE_I32) {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BEQ_RRTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else if ((types[block->branch->args[0].reg] == VM_TYPE_I32 || types[block->branch->args[0].reg] == VM_TYPE_F64) && (types[block->branch->args[1].reg] == VM_TYPE_I32 || types[block->branch->args[1].reg] == VM_TYPE_F64)) {
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
+                        vm_int_block_comp_ensure_float_reg(block->branch->args[1].reg);
+                        vm_int_block_comp_put_ptr(VM_INT_OP_FBEQ_RRTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    } else {
+                        vm_int_block_comp_put_ptr(VM_INT_OP_DYNBEQ_RRTT);
+                        vm_int_block_comp_put_reg(block->branch->args[0]);
+                        vm_int_block_comp_put_reg(block->branch->args[1]);
+                        vm_int_block_comp_put_target(block->branch->targets[0]);
+                        vm_int_block_comp_put_target(block->branch->targets[1]);
+                    }
+                }
+            }
+            break;
+        }
+        case VM_IR_BOP_RET: {
+            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
+                // ret i
+                if (fmod(block->branch->args[0].num, 1) == 0) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_I);
+                    vm_int_block_comp_put_ival(block->branch->args[0]);
+                } else {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_F);
+                    vm_int_block_comp_put_fval(block->branch->args[0]);
+                }
+            } else {
+                uint8_t type = types[block->branch->args[0].reg];
+                if (type == VM_TYPE_NIL) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RV);
+                }
+                if (type == VM_TYPE_BOOL) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RB);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                }
+                if (type == VM_TYPE_I32) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RI);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                }
+                if (type == VM_TYPE_F64) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RF);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                }
+                if (type == VM_TYPE_FUNC) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RF);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                }
+                if (type == VM_TYPE_ARRAY) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RA);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                }
+                if (type == VM_TYPE_TABLE) {
+                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RT);
+                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                }
+                // ret r
+            }
+            if (state->precomp != NULL) {
+                if (block->branch->args[0].type == VM_IR_ARG_NUM) {
+                    state->precomp->rets |= 1u << (fmod(block->branch->args[0].num, 1) == 0 ? VM_TYPE_I32 : VM_TYPE_F64);
+                } else {
+                    state->precomp->rets |= 1u << types[block->branch->args[0].reg];
+                }
+            }
+            break;
+        }
+        case VM_IR_BOP_EXIT: {
+            // exit
+            vm_int_block_comp_put_ptr(VM_INT_OP_EXIT);
+            break;
+        }
+    }
+retv:
+#if defined(VM_DEBUG_COMP)
+    fprintf(stderr, "  ");
+    vm_ir_print_branch(stderr, block->branch);
+    fprintf(stderr, "\n}\n\n");
+#endif
+    for (size_t a = 0; a < state->framesize; a++) {
+        types[a] = vm_typeof(state->locals[a]);
+    }
+    // a backend with no generic version to fall back to keeps compiling
+    // versions past the cap, they are only no longer compiled ahead of time
+    if (VM_INT_MAX_VERSIONS != 0 && data->len == VM_INT_MAX_VERSIONS) {
+        state->comp_megamorphic += 1;
+    }
+    if (data->len == 0) {
+        state->comp_blocks += 1;
+    } else {
+        state->comp_hist[vm_int_comp_bucket(data->len)] -= 1;
+    }
+    state->comp_hist[vm_int_comp_bucket(data->len + 1)] += 1;
+    state->comp_bytes += sizeof(vm_int_opcode_t) * buf.len;
+    vm_int_data_push(data, buf, types, key);
+    for (size_t i = regions_at; i < state->sample_regions_len; i++) {
+        state->sample_regions[i].ops = buf.ops;
+        state->sample_regions[i].len = buf.len;
+    }
+    for (size_t i = 0; i < nexits; i++) {
+        vm_int_exit_add(state, &buf.ops[exits[i]], exit_blocks[i]);
+    }
+    vm_free(exits);
+    vm_free(exit_blocks);
+    vm_free(konst);
+    if (state->comp_eager) {
+        state->precomp_versions += 1;
+    } else {
+        state->comp_versions += 1;
+        state->comp_ns += vm_int_now() - comp_begin;
+    }
+    if (state->use_spall) {
+        vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
+    }
+    return buf.ops;
+fail:
+    state->sample_regions_len = regions_at;
+    vm_free(exits);
+    vm_free(exit_blocks);
+    vm_free(konst);
+    vm_free(types);
+    vm_free(buf.ops);
+    if (state->use_spall) {
+        vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
+    }
+    return NULL;
+}
+
+// dummy values for vm_int_precompile, only their types are ever looked at,
+// boxed pointers need the alignment of a real object
+static uint8_t vm_int_precomp_tags[VM_TYPE_MAX][8] __attribute__((aligned(8))) = {
+    [VM_TYPE_FUNC] = {VM_TYPE_FUNC},
+    [VM_TYPE_ARRAY] = {VM_TYPE_ARRAY},
+    [VM_TYPE_TABLE] = {VM_TYPE_TABLE},
+};
+
+static vm_value_t vm_int_precomp_value(uint8_t type) {
+    switch (type) {
+        case VM_TYPE_NIL:
+            return vm_value_nil();
+        case VM_TYPE_BOOL:
+            return vm_value_from_bool(false);
+        case VM_TYPE_I32:
+            return vm_value_from_int(0);
+        case VM_TYPE_F64:
+            return vm_value_from_float(0.5);
+        default:
+            return vm_box_from_pointer(&vm_int_precomp_tags[type][0]);
+    }
+}
+
+// compiles the version of block for the given types of its args before it
+// runs, NULL when it cannot be: too many versions, an arg whose type is not
+// known, or a type error in the block
+static void *vm_int_comp_typed(vm_int_state_t *state, void **ptrs, vm_ir_block_t *block, const uint8_t *types) {
+    vm_int_data_t *data = block->data;
+    if (VM_INT_MAX_VERSIONS != 0 && data != NULL && data->len >= VM_INT_MAX_VERSIONS) {
+        return NULL;
+    }
+    for (size_t i = 0; i < block->nargs; i++) {
+        uint8_t type = types[block->args[i]];
+        if (type == VM_TYPE_UNKNOWN || type == VM_TYPE_UNSET || type >= VM_TYPE_MAX) {
+            return NULL;
+        }
+    }
+    vm_value_t *saved = vm_malloc(sizeof(vm_value_t) * (block->nargs + 1));
+    for (size_t i = 0; i < block->nargs; i++) {
+        size_t reg = block->args[i];
+        saved[i] = state->locals[reg];
+        state->locals[reg] = vm_int_precomp_value(types[reg]);
+    }
+    bool eager = state->comp_eager;
+    state->comp_eager = true;
+    void *ops = vm_int_block_comp(state, ptrs, block);
+    state->comp_eager = eager;
+    for (size_t i = block->nargs; i-- > 0;) {
+        state->locals[block->args[i]] = saved[i];
+    }
+    vm_free(saved);
+    return ops;
+}
+
+// compiles the version of todo's block for its types and links it into the graph
+static void vm_int_precomp_run(vm_int_state_t *state, void **ptrs, vm_int_precomp_todo_t todo) {
+    vm_int_precomp_t *pc = state->precomp;
+    size_t ntodos = pc->ntodos;
+    size_t ncalls = pc->ncalls;
+    pc->cur = pc->nnodes;
+    pc->rets = 0;
+    void *ops = vm_int_comp_typed(state, ptrs, todo.block, todo.types);
+    if (ops == NULL) {
+        // a type error on a path that may never run traps there if it does,
+        // and one that could not be compiled yet is not linked to anything
+        while (pc->ntodos > ntodos) {
+            vm_free(pc->todos[--pc->ntodos].types);
+        }
+        while (pc->ncalls > ncalls) {
+            vm_free(pc->calls[--pc->ncalls].types);
+        }
+        return;
+    }
+    size_t node = vm_int_precomp_find(pc, ops);
+    if (node == SIZE_MAX) {
+        node = vm_int_precomp_node(pc, ops, pc->rets);
+    }
+    if (todo.from != SIZE_MAX) {
+        vm_int_precomp_edge(pc, todo.from, node);
+    }
+    if (todo.call != SIZE_MAX) {
+        pc->calls[todo.call].callee = node;
+    }
+}
+
+// compiles every version reachable from entry whose types are known before
+// running: jumps and branches are typed statically, calls to known functions
+// by their argument types, and their continuations by what the callee can
+// return. dynamic callees, typed dispatch on values and overflow exits are
+// still compiled when they first run
+void vm_int_precompile(vm_int_state_t *state, void **ptrs, vm_ir_block_t *entry) {
+    uint64_t begin = vm_int_now();
+    vm_int_precomp_t pc = {0};
+    pc.framesize = state->framesize;
+    state->precomp = &pc;
+    vm_int_precomp_todo(&pc, entry, vm_int_precomp_types(&pc, NULL), SIZE_MAX, SIZE_MAX);
+    while (pc.ntodos != 0) {
+        while (pc.ntodos != 0) {
+            vm_int_precomp_todo_t todo = pc.todos[--pc.ntodos];
+            vm_int_precomp_run(state, ptrs, todo);
+            vm_free(todo.types);
+        }
+        // what each version returns through everything it jumps to
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i = 0; i < pc.nnodes; i++) {
+                vm_int_precomp_node_t *node = &pc.nodes[i];
+                uint32_t reach = node->reach;
+                for (size_t j = 0; j < node->nsucc; j++) {
+                    reach |= pc.nodes[node->succ[j]].reach;
+                }
+                if (reach != node->reach) {
+                    node->reach = reach;
+                    changed = true;
+                }
+            }
+        }
+        // continuations for the types returned, which can find more calls
+        for (size_t i = 0; i < pc.ncalls; i++) {
+            vm_int_precomp_call_t *call = &pc.calls[i];
+            if (call->callee == SIZE_MAX) {
+                continue;
+            }
+            uint32_t rets = pc.nodes[call->callee].reach & ~call->done;
+            call->done |= rets;
+            for (uint8_t type = VM_TYPE_NIL; type < VM_TYPE_MAX; type++) {
+                if (rets & (1u << type)) {
+                    uint8_t *types = vm_int_precomp_types(&pc, call->types);
+                    if (call->out < pc.framesize) {
+                        types[call->out] = type;
+                    }
+                    vm_int_precomp_todo(&pc, call->next, types, call->from, SIZE_MAX);
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < pc.nnodes; i++) {
+        vm_free(pc.nodes[i].succ);
+    }
+    for (size_t i = 0; i < pc.ncalls; i++) {
+        vm_free(pc.calls[i].types);
+    }
+    vm_free(pc.nodes);
+    vm_free(pc.table);
+    vm_free(pc.calls);
+    vm_free(pc.todos);
+    state->precomp = NULL;
+    state->precomp_ns += vm_int_now() - begin;
+}
+
+// type profiles: every version a run compiled, one per line as the block id
+// and the types of its args, under a header with a hash of the bytecode
+#define VM_INT_PROFILE_MAGIC "minivm-profile-1"
+
+void vm_int_profile_write(const char *path, uint64_t hash, size_t nblocks, vm_ir_block_t *blocks) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "cannot write profile: %s\n", path);
+        return;
+    }
+    fprintf(out, "%s %016llx\n", VM_INT_PROFILE_MAGIC, (unsigned long long)hash);
+    for (size_t i = 0; i < nblocks; i++) {
+        vm_ir_block_t *block = &blocks[i];
+        vm_int_data_t *data = block->data;
+        if (block->id < 0 || data == NULL) {
+            continue;
+        }
+        for (size_t v = 0; v < data->len; v++) {
+            fprintf(out, "%td", block->id);
+            for (size_t a = 0; a < block->nargs; a++) {
+                fprintf(out, " %u", (unsigned)data->types[v][block->args[a]]);
+            }
+            fprintf(out, "\n");
+        }
+    }
+    fclose(out);
+}
+
+// a number on the current line, SIZE_MAX at the end of it
+static size_t vm_int_profile_num(const char **src, size_t base) {
+    const char *cur = *src;
+    while (*cur == ' ') {
+        cur += 1;
+    }
+    size_t ret = SIZE_MAX;
+    for (;;) {
+        size_t digit;
+        if ('0' <= *cur && *cur <= '9') {
+            digit = (size_t)(*cur - '0');
+        } else if (base == 16 && 'a' <= *cur && *cur <= 'f') {
+            digit = (size_t)(*cur - 'a' + 10);
+        } else {
+            break;
+        }
+        ret = (ret == SIZE_MAX ? 0 : ret * base) + digit;
+        cur += 1;
+    }
+    *src = cur;
+    return ret;
+}
+
+// queues the versions in a profile written by a run of the same bytecode,
+// anything else there is ignored
+bool vm_int_profile_read(vm_int_state_t *state, const char *path, uint64_t hash, size_t nblocks, vm_ir_block_t *blocks) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    size_t len = 0;
+    size_t alloc = 4096;
+    char *src = vm_malloc(sizeof(char) * alloc);
+    for (;;) {
+        len += fread(&src[len], sizeof(char), alloc - len - 1, file);
+        if (len + 1 < alloc) {
+            break;
+        }
+        alloc *= 2;
+        src = vm_realloc(src, sizeof(char) * alloc);
+    }
+    src[len] = '\0';
+    fclose(file);
+    const char *cur = src;
+    size_t magic = strlen(VM_INT_PROFILE_MAGIC);
+    if (strncmp(cur, VM_INT_PROFILE_MAGIC, magic) != 0) {
+        vm_free(src);
+        return false;
+    }
+    cur += magic;
+    if (vm_int_profile_num(&cur, 16) != (size_t)hash || *cur != '\n') {
+        vm_free(src);
+        return false;
+    }
+    size_t alloc_profile = state->profile_len;
+    while (*cur == '\n') {
+        cur += 1;
+        size_t id = vm_int_profile_num(&cur, 10);
+        if (id >= nblocks || blocks[id].id != (ptrdiff_t)id) {
+            while (*cur != '\n' && *cur != '\0') {
+                cur += 1;
+            }
+            continue;
+        }
+        vm_ir_block_t *block = &blocks[id];
+        uint8_t *types = vm_malloc(sizeof(uint8_t) * state->framesize);
+        memset(types, VM_TYPE_UNSET, sizeof(uint8_t) * state->framesize);
+        size_t nargs = 0;
+        for (size_t type; (type = vm_int_profile_num(&cur, 10)) != SIZE_MAX; nargs++) {
+            if (nargs < block->nargs && type < VM_TYPE_MAX) {
+                types[block->args[nargs]] = (uint8_t)type;
+            }
+        }
+        if (nargs != block->nargs) {
+            vm_free(types);
+            continue;
+        }
+        if (state->profile_len + 1 >= alloc_profile) {
+            alloc_profile = (state->profile_len + 1) * 2;
+            state->profile_blocks = vm_realloc(state->profile_blocks, sizeof(vm_ir_block_t *) * alloc_profile);
+            state->profile_types = vm_realloc(state->profile_types, sizeof(uint8_t *) * alloc_profile);
+        }
+        state->profile_blocks[state->profile_len] = block;
+        state->profile_types[state->profile_len] = types;
+        state->profile_len += 1;
+    }
+    vm_free(src);
+    return true;
+}
+
+// compiles what vm_int_profile_read queued
+static void vm_int_profile_comp(vm_int_state_t *state, void **ptrs) {
+    uint64_t begin = vm_int_now();
+    for (size_t i = 0; i < state->profile_len; i++) {
+        vm_int_comp_typed(state, ptrs, state->profile_blocks[i], state->profile_types[i]);
+        vm_free(state->profile_types[i]);
+    }
+    vm_free(state->profile_blocks);
+    vm_free(state->profile_types);
+    state->profile_blocks = NULL;
+    state->profile_types = NULL;
+    state->profile_len = 0;
+    state->precomp_ns += vm_int_now() - begin;
+}
+
+#define vm_int_run_read() (*(head += 1, head - 1))
+
+#define vm_int_run_read_wide() (*(head += VM_INT_WIDE, vm_int_wide(head - VM_INT_WIDE)))
+
+#if VM_INT_TAIL
+// each handler is its own function and dispatch is a sibling call, so head,
+// locals, heads, state and framesize stay in argument registers throughout
+#if !defined(__has_attribute)
+#define __has_attribute(x) 0
+#endif
+
+#if __has_attribute(musttail)
+#define VM_INT_RUN_MUSTTAIL __attribute__((musttail))
+#elif defined(__OPTIMIZE__)
+#define VM_INT_RUN_MUSTTAIL
+#else
+#error "VM_INT_TAIL needs musttail or an optimized build for sibling calls"
+#endif
+
+#if __has_attribute(preserve_none)
+#define VM_INT_RUN_CC __attribute__((preserve_none))
+#else
+#define VM_INT_RUN_CC
+#endif
+
+#define VM_INT_RUN_PARAMS                            \
+    vm_int_opcode_t *head __attribute__((unused)),   \
+    vm_value_t *locals __attribute__((unused)),      \
+    vm_int_opcode_t **heads __attribute__((unused)), \
+    vm_int_state_t *state __attribute__((unused)),   \
+    size_t framesize __attribute__((unused))
+
+typedef vm_value_t(VM_INT_RUN_CC *vm_int_run_func_t)(VM_INT_RUN_PARAMS);
+
+#define vm_int_run_op(name_) VM_INT_RUN_CC static vm_value_t vm_int_run_op_##name_(VM_INT_RUN_PARAMS)
+
+#define vm_int_run_label(name_) ((void *)&vm_int_run_op_##name_)
+
+#define vm_int_run_jump(name_) \
+    VM_INT_RUN_MUSTTAIL return vm_int_run_op_##name_(head, locals, heads, state, framesize)
+
+#define vm_int_run_next()                                                         \
+    do {                                                                          \
+        vm_int_run_func_t next__ = (vm_int_run_func_t)vm_int_run_read_wide().ptr;      \
+        VM_INT_RUN_MUSTTAIL return next__(head, locals, heads, state, framesize); \
+    } while (0)
+
+#define vm_int_run_comp(block_) vm_int_block_comp(vm_int_run_save(), vm_int_run_ptrs, (block_))
+
+#define vm_int_run_exit(at_, out_, val_) vm_int_exit_comp(vm_int_run_save(), vm_int_run_ptrs, (at_), (out_), (val_))
+#elif VM_INT_SWITCH
+// for compilers without labels as values: the stream holds opcode numbers,
+// offset by one so none is NULL, and every handler jumps back to one switch
+#define vm_int_run_op(name_) do_##name_:
+
+#define vm_int_run_label(name_) ((void *)(size_t)VM_INT_RUN_CODE_##name_)
+
+#define vm_int_run_jump(name_) goto do_##name_
+
+#define vm_int_run_next() goto vm_int_run_dispatch
+
+#define vm_int_run_comp(block_) vm_int_block_comp(vm_int_run_save(), ptrs, (block_))
+
+#define vm_int_run_exit(at_, out_, val_) vm_int_exit_comp(vm_int_run_save(), ptrs, (at_), (out_), (val_))
+#else
+#define vm_int_run_op(name_) do_##name_:
+
+#define vm_int_run_label(name_) (&&do_##name_)
+
+#define vm_int_run_jump(name_) goto do_##name_
+
+#define vm_int_run_next() goto *vm_int_run_read_wide().ptr
+
+#define vm_int_run_comp(block_) vm_int_block_comp(vm_int_run_save(), ptrs, (block_))
+
+#define vm_int_run_exit(at_, out_, val_) vm_int_exit_comp(vm_int_run_save(), ptrs, (at_), (out_), (val_))
+#endif
+
+#define vm_int_run_read_store() (&locals[vm_int_run_read().reg])
+
+#define vm_int_run_read_load() (locals[vm_int_run_read().reg])
+
+#define vm_int_run_save() (state->locals = locals, state->heads = heads, state)
+
+// pushes the return head and moves past the caller's frame, the head is
+// left on the frame size so the ret handlers can read it back
+#define vm_int_run_enter(fsize_)                                \
+    do {                                                        \
+        if (__builtin_expect(locals >= state->gc.limit, 0)) {   \
+            vm_int_stack_limit(vm_int_run_save());              \
+            locals = state->locals;                             \
+            heads = state->heads;                               \
+        }                                                       \
+        *heads++ = head;                                        \
+        locals += (fsize_);                                     \
+    } while (0)
+
+// leaves a call site for the version of its continuation that expects the
+// returned type, a site links one slot per type it has seen returned so the
+// common case is a load and a predicted branch with no lookup by type
+#define vm_int_run_ret_link(type_)                                                  \
+    do {                                                                            \
+        void *pblock__ = vm_int_wide(head)[(type_)].ptr;                            \
+        if (__builtin_expect(pblock__ == NULL, 0)) {                                \
+            vm_int_ret_site(state, vm_int_wide(head));                              \
+            pblock__ = vm_int_run_comp(vm_int_wide(head)[0].block);                 \
+            vm_int_wide(head)[(type_)].ptr = pblock__;                              \
+        }                                                                           \
+        head = pblock__;                                                            \
+    } while (0)
+
+// out = lhs op rhs on ints, unless that overflows: then the exact result is
+// stored as a float and the op leaves for the version of its continuation
+// that expects one, found by the op's first operand three reads back
+#define vm_int_run_i32_checked(out_, lhs_, rhs_, check_, fop_)                            \
+    do {                                                                                    \
+        vm_int_t lhs__ = (lhs_);                                                            \
+        vm_int_t rhs__ = (rhs_);                                                            \
+        vm_int_t res__;                                                                     \
+        bool over__ = check_(lhs__, rhs__, &res__);                                         \
+        if (VM_INT_OVERFLOW && __builtin_expect(over__, false)) {                           \
+            vm_int_opcode_t *exit__ = vm_int_run_exit(head - 3, (out_), (double)lhs__ fop_(double) rhs__); \
+            if (exit__ != NULL) {                                                           \
+                head = exit__;                                                              \
+                vm_int_run_next();                                                          \
+            }                                                                               \
+        }                                                                                   \
+        *(out_) = vm_value_from_int(res__);                                                 \
+    } while (0)
+
+void vm_main_spall_init(vm_int_state_t *state, const char *name) {
+    state->use_spall = true;
+    state->spall_ctx = vm_trace_init(name, 0.000303);
+    vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "MiniVM Invocation");
+}
+
+void vm_main_spall_deinit(vm_int_state_t *state) {
+    vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
+    vm_trace_quit(&state->spall_ctx);
+}
+
+// frames are sized per function, so the stack is measured in the largest
+// one: a frame at or before locals_max can enter any callee, and that callee
+// can still stage a call's args past its own frame
+static vm_value_t *vm_int_stack_max(vm_int_state_t *state) {
+    return state->stack + state->framesize * state->stack_frames - 2 * (state->framesize + state->call_args);
+}
+
+void vm_int_stack_init(vm_int_state_t *state, size_t nblocks, vm_ir_block_t *blocks) {
+    state->framesize = 1;
+    state->call_args = 16;
+    for (size_t i = 0; i < nblocks; i++) {
+        vm_ir_block_t *block = &blocks[i];
+        if (block->id < 0) {
+            continue;
+        }
+        if (block->nregs >= state->framesize) {
+            state->framesize = block->nregs + 1;
+        }
+        for (size_t j = 0; j < block->len; j++) {
+            vm_ir_instr_t *instr = block->instrs[j];
+            if (instr->op != VM_IR_IOP_CALL && instr->op != VM_IR_IOP_TCALL) {
+                continue;
+            }
+            // a closure's array goes before the args
+            size_t nargs = 1;
+            while (instr->args[nargs].type != VM_IR_ARG_NONE) {
+                nargs += 1;
+            }
+            if (nargs > state->call_args) {
+                state->call_args = nargs;
+            }
+        }
+    }
+    size_t nframes = VM_CONFIG_NUM_FRAMES;
+    size_t margin = 2 * (state->framesize + state->call_args);
+    if (nframes < 4 + margin / state->framesize) {
+        nframes = 4 + margin / state->framesize;
+    }
+    state->stack_frames = nframes;
+    state->stack = vm_alloc0(sizeof(vm_value_t) * state->framesize * nframes);
+    // no frame is smaller than two slots
+    state->stack_heads = vm_malloc(sizeof(vm_int_opcode_t *) * (state->framesize * nframes / 2 + 1));
+    state->locals = state->stack;
+    state->heads = state->stack_heads;
+    state->locals_max = vm_int_stack_max(state);
+}
+
+// called with state->locals and state->heads saved, moves both stacks and
+// everything that points into them
+void vm_int_stack_grow(vm_int_state_t *state) {
+#if VM_CONFIG_GROW_STACK
+    size_t framesize = state->framesize;
+    size_t old_frames = state->stack_frames;
+    size_t nframes = old_frames * 2;
+    size_t locals_at = (size_t)(state->locals - state->stack);
+    size_t heads_at = (size_t)(state->heads - state->stack_heads);
+    size_t limit_at = (size_t)(state->gc.limit - state->stack);
+    vm_value_t *stack = vm_realloc(state->stack, sizeof(vm_value_t) * framesize * nframes);
+    state->sample_heads = NULL;
+    vm_int_opcode_t **heads = vm_realloc(state->stack_heads, sizeof(vm_int_opcode_t *) * (framesize * nframes / 2 + 1));
+    if (stack == NULL || heads == NULL) {
+        fprintf(stderr, "stack overflow: cannot grow past %zu registers\n", framesize * old_frames);
+        __builtin_trap();
+    }
+    memset(&stack[framesize * old_frames], 0, sizeof(vm_value_t) * framesize * (nframes - old_frames));
+    state->stack_frames = nframes;
+    state->stack = stack;
+    state->stack_heads = heads;
+    state->locals = stack + locals_at;
+    state->heads = heads + heads_at;
+    state->locals_max = vm_int_stack_max(state);
+    state->gc.stack = stack;
+    state->gc.nstack = framesize * nframes;
+    state->gc.limit = stack + limit_at;
+#else
+    fprintf(stderr, "stack overflow: more than %zu registers\n", state->framesize * state->stack_frames);
+    __builtin_trap();
+#endif
+}
+
+// called with state->locals and state->heads saved when a call would pass
+// gc.limit, calls go a few frames further before stopping again so the
+// collector only forgets registers a frame since its last run could write
+void vm_int_stack_limit(vm_int_state_t *state) {
+    if (state->locals >= state->locals_max) {
+        vm_int_stack_grow(state);
+    }
+    size_t room = (size_t)(state->locals_max - state->locals);
+    size_t step = state->framesize * VM_CONFIG_STACK_LIMIT_FRAMES;
+    state->gc.limit = state->locals + (room < step ? room : step);
+    state->gc.margin = 2 * (state->framesize + state->call_args);
+}
+
+void vm_int_stack_deinit(vm_int_state_t *state) {
+    vm_free(state->stack);
+    vm_free(state->stack_heads);
+}
+
+void vm_int_pairs_init(vm_int_state_t *state) {
+    state->pair_counts = vm_alloc0(sizeof(size_t) * VM_INT_MAX_OP * VM_INT_MAX_OP);
+    state->pair_last = VM_INT_OP_EXIT;
+}
+
+static int vm_int_pairs_cmp(const void *lhs, const void *rhs) {
+    size_t l = **(size_t *const *)lhs;
+    size_t r = **(size_t *const *)rhs;
+    return (l < r) - (l > r);
+}
+
+void vm_int_pairs_print(vm_int_state_t *state, FILE *out, size_t max) {
+    size_t len = 0;
+    size_t **sorted = vm_malloc(sizeof(size_t *) * VM_INT_MAX_OP * VM_INT_MAX_OP);
+    size_t total = 0;
+    for (size_t i = 0; i < VM_INT_MAX_OP * VM_INT_MAX_OP; i++) {
+        if (state->pair_counts[i] != 0) {
+            sorted[len++] = &state->pair_counts[i];
+            total += state->pair_counts[i];
+        }
+    }
+    qsort(sorted, len, sizeof(size_t *), vm_int_pairs_cmp);
+    fprintf(out, "%12s %6s  pair\n", "count", "share");
+    for (size_t i = 0; i < len && i < max; i++) {
+        size_t index = (size_t)(sorted[i] - state->pair_counts);
+        size_t first = index / VM_INT_MAX_OP;
+        size_t second = index % VM_INT_MAX_OP;
+        fprintf(out, "%12zu %5.1f%%  %s %s -> %s %s\n", *sorted[i], 100.0 * (double)*sorted[i] / (double)total,
+                vm_int_debug_instr_name(first), vm_int_debug_instr_format(first),
+                vm_int_debug_instr_name(second), vm_int_debug_instr_format(second));
+    }
+    vm_free(sorted);
+}
+
+// every block entered is counted and, if asked, every op run, op by op
+// rather than by superinstruction since the prologue keeps ops from fusing
+void vm_int_counts_init(vm_int_state_t *state, size_t nblocks, bool ops) {
+    if (ops) {
+        state->op_counts = vm_alloc0(sizeof(size_t) * VM_INT_MAX_OP);
+    }
+    state->block_counts = vm_alloc0(sizeof(size_t) * nblocks);
+    state->block_counts_len = nblocks;
+}
+
+static size_t vm_int_counts_sort(size_t *counts, size_t len, size_t **sorted, size_t *total) {
+    size_t nsorted = 0;
+    *total = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (counts[i] != 0) {
+            sorted[nsorted++] = &counts[i];
+            *total += counts[i];
+        }
+    }
+    qsort(sorted, nsorted, sizeof(size_t *), vm_int_pairs_cmp);
+    return nsorted;
+}
+
+void vm_int_counts_print(vm_int_state_t *state, FILE *out, size_t max) {
+    size_t total;
+    size_t **sorted = vm_malloc(sizeof(size_t *) * (VM_INT_MAX_OP + state->block_counts_len));
+    if (state->op_counts != NULL) {
+        size_t len = vm_int_counts_sort(state->op_counts, VM_INT_MAX_OP, sorted, &total);
+        fprintf(out, "%12s %6s  op\n", "count", "share");
+        for (size_t i = 0; i < len && i < max; i++) {
+            size_t op = (size_t)(sorted[i] - state->op_counts);
+            fprintf(out, "%12zu %5.1f%%  %s %s\n", *sorted[i], 100.0 * (double)*sorted[i] / (double)total,
+                    vm_int_debug_instr_name(op), vm_int_debug_instr_format(op));
+        }
+        fprintf(out, "%12zu %6s  total\n", total, "");
+    }
+    size_t len = vm_int_counts_sort(state->block_counts, state->block_counts_len, sorted, &total);
+    fprintf(out, "%12s %6s  block\n", "count", "share");
+    for (size_t i = 0; i < len && i < max; i++) {
+        size_t id = (size_t)(sorted[i] - state->block_counts);
+        fprintf(out, "%12zu %5.1f%%  .L%zu\n", *sorted[i], 100.0 * (double)*sorted[i] / (double)total, id);
+    }
+    fprintf(out, "%12zu %6s  total\n", total, "");
+    vm_free(sorted);
+}
+
+// a sample is its depth, the head of the block it was taken in and the
+// return heads of its callers from the innermost out, all written by the
+// SIGPROF handler into a buffer allocated up front
+static vm_int_state_t *vm_int_sample_state;
+
+void vm_int_sample_region(vm_int_state_t *state, size_t at, ptrdiff_t id) {
+    if (state->sample_regions_len + 1 >= state->sample_regions_alloc) {
+        state->sample_regions_alloc = (state->sample_regions_len + 1) * 2;
+        state->sample_regions = vm_realloc(state->sample_regions, sizeof(vm_int_sample_region_t) * state->sample_regions_alloc);
+    }
+    state->sample_regions[state->sample_regions_len++] = (vm_int_sample_region_t){
+        .at = at,
+        .id = id,
+    };
+}
+
+#if !defined(_WIN32) && !defined(VM_WASM)
+#if defined(__linux__)
+static timer_t vm_int_sample_timer;
+static bool vm_int_sample_timed;
+#endif
+
+static void vm_int_sample_signal(int sig) {
+    (void)sig;
+    vm_int_state_t *state = vm_int_sample_state;
+    vm_int_opcode_t *head = state->sample_head;
+    vm_int_opcode_t **heads = state->sample_heads;
+    if (head == NULL || heads == NULL) {
+        state->samples_missed += 1;
+        return;
+    }
+    size_t depth = (size_t)(heads - state->stack_heads);
+    if (depth > VM_CONFIG_SAMPLE_DEPTH) {
+        depth = VM_CONFIG_SAMPLE_DEPTH;
+    }
+    if (state->samples_len + depth + 2 > VM_CONFIG_SAMPLE_SLOTS) {
+        state->samples_dropped += 1;
+        return;
+    }
+    void **out = &state->samples[state->samples_len];
+    *out++ = (void *)depth;
+    *out++ = head;
+    for (size_t i = 1; i <= depth; i++) {
+        *out++ = heads[-(ptrdiff_t)i];
+    }
+    state->samples_len += depth + 2;
+}
+#endif
+
+bool vm_int_sample_init(vm_int_state_t *state, const char *path) {
+#if !defined(_WIN32) && !defined(VM_WASM)
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        return false;
+    }
+    state->sample = out;
+    state->samples = vm_malloc(sizeof(void *) * VM_CONFIG_SAMPLE_SLOTS);
+    vm_int_sample_state = state;
+    struct sigaction action = {0};
+    action.sa_handler = &vm_int_sample_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+#if defined(__linux__)
+    // cpu time timers only fire on scheduler ticks, often 250 hz, so the
+    // rate asked for is kept by sampling wall time instead
+    struct sigevent event = {0};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if (timer_create(CLOCK_MONOTONIC, &event, &vm_int_sample_timer) == 0) {
+        struct itimerspec spec = {0};
+        spec.it_interval.tv_nsec = 1000000000 / VM_CONFIG_SAMPLE_HZ;
+        spec.it_value = spec.it_interval;
+        timer_settime(vm_int_sample_timer, 0, &spec, NULL);
+        vm_int_sample_timed = true;
+        return true;
+    }
+#endif
+    struct itimerval timer = {0};
+    timer.it_interval.tv_usec = 1000000 / VM_CONFIG_SAMPLE_HZ;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+    return true;
+#else
+    (void)state;
+    (void)path;
+    return false;
+#endif
+}
+
+static const char *vm_int_sample_name(vm_int_state_t *state, void *ptr, char *buf) {
+    vm_int_opcode_t *op = ptr;
+    size_t lo = 0;
+    size_t hi = state->sample_regions_len;
+    // the last region that starts at or before the op, which is in the same
+    // buffer as the op whenever any region is
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        vm_int_sample_region_t *region = &state->sample_regions[mid];
+        if (&region->ops[region->at] <= op) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo != 0) {
+        vm_int_sample_region_t *region = &state->sample_regions[lo - 1];
+        if (op < &region->ops[region->len]) {
+            snprintf(buf, 32, ".L%td", region->id);
+            return buf;
+        }
+    }
+    return "?";
+}
+
+static int vm_int_sample_region_cmp(const void *lhs, const void *rhs) {
+    const vm_int_sample_region_t *l = lhs;
+    const vm_int_sample_region_t *r = rhs;
+    const vm_int_opcode_t *lop = &l->ops[l->at];
+    const vm_int_opcode_t *rop = &r->ops[r->at];
+    return (lop > rop) - (lop < rop);
+}
+
+static int vm_int_sample_line_cmp(const void *lhs, const void *rhs) {
+    return strcmp(*(char *const *)lhs, *(char *const *)rhs);
+}
+
+// writes one folded stack per line, callers first, with how often it was seen
+void vm_int_sample_deinit(vm_int_state_t *state) {
+#if !defined(_WIN32) && !defined(VM_WASM)
+#if defined(__linux__)
+    if (vm_int_sample_timed) {
+        timer_delete(vm_int_sample_timer);
+        vm_int_sample_timed = false;
+    }
+#endif
+    struct itimerval timer = {0};
+    setitimer(ITIMER_PROF, &timer, NULL);
+    // a tick can still be pending, ignoring it rather than taking the
+    // default action keeps it from killing the process
+    signal(SIGPROF, SIG_IGN);
+#endif
+    qsort(state->sample_regions, state->sample_regions_len, sizeof(vm_int_sample_region_t), vm_int_sample_region_cmp);
+    size_t nlines = 0;
+    size_t alloc = 16;
+    char **lines = vm_malloc(sizeof(char *) * alloc);
+    for (size_t i = 0; i < state->samples_len;) {
+        size_t depth = (size_t)state->samples[i];
+        void **frames = &state->samples[i + 1];
+        i += depth + 2;
+        size_t len = 0;
+        size_t cap = 32 * (depth + 1);
+        char *line = vm_malloc(sizeof(char) * cap);
+        for (size_t j = depth + 1; j-- > 0;) {
+            char name[32];
+            len += (size_t)snprintf(&line[len], cap - len, "%s%s", len == 0 ? "" : ";", vm_int_sample_name(state, frames[j], name));
+        }
+        if (nlines + 1 >= alloc) {
+            alloc *= 2;
+            lines = vm_realloc(lines, sizeof(char *) * alloc);
+        }
+        lines[nlines++] = line;
+    }
+    qsort(lines, nlines, sizeof(char *), vm_int_sample_line_cmp);
+    for (size_t i = 0; i < nlines;) {
+        size_t j = i + 1;
+        while (j < nlines && !strcmp(lines[i], lines[j])) {
+            j += 1;
+        }
+        fprintf(state->sample, "%s %zu\n", lines[i], j - i);
+        i = j;
+    }
+    for (size_t i = 0; i < nlines; i++) {
+        vm_free(lines[i]);
+    }
+    vm_free(lines);
+    fclose(state->sample);
+    fprintf(stderr, "samples: %zu (%zu outside a block, %zu dropped)\n", nlines + state->samples_missed + state->samples_dropped, state->samples_missed, state->samples_dropped);
+    vm_free(state->samples);
+    vm_free(state->sample_regions);
+    state->sample = NULL;
+    vm_int_sample_state = NULL;
+}
+
+// counts call sites by how many return types they have linked, a site that
+// links a second type is no longer monomorphic
+static void __attribute__((noinline)) vm_int_ret_site(vm_int_state_t *state, vm_int_wide_t *site) {
+    size_t linked = 0;
+    for (size_t type = 1; type < VM_TYPE_MAX; type++) {
+        if (site[type].ptr != NULL) {
+            linked += 1;
+        }
+    }
+    if (linked == 0) {
+        state->ret_sites += 1;
+    } else if (linked == 1) {
+        state->ret_poly += 1;
+    }
+}
+
+// where the generic version of a block leaves to once its instrs have run
+enum {
+    VM_INT_GENERIC_JUMP,
+    VM_INT_GENERIC_CALL,
+    VM_INT_GENERIC_TCALL,
+    VM_INT_GENERIC_RET,
+    VM_INT_GENERIC_EXIT,
+};
+
+typedef struct {
+    uint8_t kind;
+    vm_ir_block_t *block;
+    vm_value_t value;
+} vm_int_generic_t;
+
+static void vm_int_generic_type_error(size_t reg, uint8_t type) {
+    fprintf(stderr, "TYPE ERROR (reg: %zu) (type: %zu)\n", reg, (size_t)type);
+    __builtin_trap();
+}
+
+// a number as vm_int_block_comp_mov would load it
+static vm_value_t vm_int_generic_num(double num) {
+    if (vm_int_is_int(num)) {
+        return vm_value_from_int((vm_int_t)num);
+    }
+    return vm_value_from_float(num);
+}
+
+static vm_value_t vm_int_generic_load(vm_value_t *locals, vm_ir_arg_t arg) {
+    switch (arg.type) {
+        case VM_IR_ARG_REG: {
+            return locals[arg.reg];
+        }
+        case VM_IR_ARG_NUM: {
+            return vm_int_generic_num(arg.num);
+        }
+        case VM_IR_ARG_BOOL: {
+            return vm_value_from_bool(arg.logic);
+        }
+        case VM_IR_ARG_FUNC: {
+            return vm_value_from_block(arg.func);
+        }
+        default: {
+            return vm_value_nil();
+        }
+    }
+}
+
+static bool vm_int_generic_is_int(vm_value_t *locals, vm_ir_arg_t arg) {
+    if (arg.type == VM_IR_ARG_REG) {
+        return vm_typeof(locals[arg.reg]) == VM_TYPE_I32;
+    }
+    return vm_int_is_int(arg.num);
+}
+
+static bool vm_int_generic_is_number(vm_value_t *locals, vm_ir_arg_t arg) {
+    if (arg.type == VM_IR_ARG_REG) {
+        uint8_t type = vm_typeof(locals[arg.reg]);
+        return type == VM_TYPE_I32 || type == VM_TYPE_F64;
+    }
+    return true;
+}
+
+// an operand the typed versions would ensure_float, an int register is
+// turned into a float in place so the registers end up holding the same
+static double vm_int_generic_float(vm_value_t *locals, vm_ir_arg_t arg) {
+    if (arg.type != VM_IR_ARG_REG) {
+        return arg.num;
+    }
+    vm_value_t *reg = &locals[arg.reg];
+    uint8_t type = vm_typeof(*reg);
+    if (type == VM_TYPE_I32) {
+        *reg = vm_value_from_float((vm_number_t)vm_value_to_int(*reg));
+    } else if (type != VM_TYPE_F64) {
+        vm_int_generic_type_error(arg.reg, type);
+    }
+    return vm_value_to_float(*reg);
+}
+
+// and one they would ensure_int
+static vm_int_t vm_int_generic_int(vm_value_t *locals, vm_ir_arg_t arg) {
+    if (arg.type != VM_IR_ARG_REG) {
+        return (vm_int_t)arg.num;
+    }
+    vm_value_t *reg = &locals[arg.reg];
+    uint8_t type = vm_typeof(*reg);
+    if (type == VM_TYPE_F64) {
+        *reg = vm_value_from_int((vm_int_t)vm_value_to_float(*reg));
+    } else if (type != VM_TYPE_I32) {
+        vm_int_generic_type_error(arg.reg, type);
+    }
+    return vm_value_to_int(*reg);
+}
+
+// add, sub, mul, div and mod on ints when both operands are, an add, sub or
+// mul that overflows gives a float only where a typed version would leave
+// for one, see vm_int_block_comp_exit
+static vm_value_t vm_int_generic_arith(vm_value_t *locals, vm_ir_block_t *block, vm_ir_instr_t *instr) {
+    vm_ir_arg_t lhs = instr->args[0];
+    vm_ir_arg_t rhs = instr->args[1];
+    if (lhs.type != VM_IR_ARG_REG && rhs.type != VM_IR_ARG_REG) {
+        switch (instr->op) {
+            case VM_IR_IOP_ADD: {
+                return vm_int_generic_num(lhs.num + rhs.num);
+            }
+            case VM_IR_IOP_SUB: {
+                return vm_int_generic_num(lhs.num - rhs.num);
+            }
+            case VM_IR_IOP_MUL: {
+                return vm_int_generic_num(lhs.num * rhs.num);
+            }
+            case VM_IR_IOP_DIV: {
+                return vm_int_generic_num(lhs.num / rhs.num);
+            }
+            default: {
+                return vm_int_generic_num(fmod(lhs.num, rhs.num));
+            }
+        }
+    }
+    if (vm_int_generic_is_int(locals, lhs) && vm_int_generic_is_int(locals, rhs)) {
+        vm_int_t a = vm_int_generic_int(locals, lhs);
+        vm_int_t b = vm_int_generic_int(locals, rhs);
+        bool exits = VM_INT_OVERFLOW && block->branch->op == VM_IR_BOP_JUMP && block->instrs[block->len - 1] == instr;
+        vm_int_t res;
+        switch (instr->op) {
+            case VM_IR_IOP_ADD: {
+                if (__builtin_add_overflow(a, b, &res) && exits) {
+                    return vm_value_from_float((double)a + (double)b);
+                }
+                return vm_value_from_int(res);
             }
-            case VM_IR_IOP_TYPE: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    if (instr->args[0].type == VM_IR_ARG_REG) {
-                        // r = type r
-                        vm_int_block_comp_mov(instr->out.reg, types[instr->args[0].reg]);
-                    } else {
-                        // r = move i
-                        vm_int_block_comp_mov(instr->out.reg, VM_TYPE_F64);
-                    }
+            case VM_IR_IOP_SUB: {
+                if (__builtin_sub_overflow(a, b, &res) && exits) {
+                    return vm_value_from_float((double)a - (double)b);
                 }
-                break;
+                return vm_value_from_int(res);
             }
-            case VM_IR_IOP_IN: {
-                if (instr->out.type == VM_IR_ARG_REG) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_IN_V);
-                    vm_int_block_comp_put_out(instr->out.reg);
-                    types[instr->out.reg] = VM_TYPE_I32;
+            case VM_IR_IOP_MUL: {
+                if (__builtin_mul_overflow(a, b, &res) && exits) {
+                    return vm_value_from_float((double)a * (double)b);
                 }
-                break;
+                return vm_value_from_int(res);
             }
-            case VM_IR_IOP_OUT: {
-                if (instr->args[0].type == VM_IR_ARG_NUM) {
-                    // out i
-                    vm_int_block_comp_put_ptr(VM_INT_OP_OUT_I);
-                    vm_int_block_comp_put_ival(instr->args[0]);
-                } else {
-                    // out r
-                    vm_int_block_comp_ensure_float_reg(instr->args[0].reg);
-                    vm_int_block_comp_put_ptr(VM_INT_OP_OUT_R);
-                    vm_int_block_comp_put_reg(instr->args[0]);
+            case VM_IR_IOP_DIV: {
+                if (a % b == 0) {
+                    return vm_value_from_int(a / b);
                 }
-                break;
+                return vm_value_from_float((double)a / (double)b);
             }
             default: {
-                fprintf(stderr, "unimplemented op: %zu\n", (size_t)instr->op);
-                __builtin_trap();
+                return vm_value_from_int(a % b);
             }
         }
     }
-    vm_int_block_comp_buf_check();
-    switch (block->branch->op) {
-        case VM_IR_BOP_JUMP: {
-            // jump l
-            if (block->branch->targets[0]->id <= block->id || !VM_ALLOW_INLINE_JUMPS) {
-                vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                vm_int_block_comp_put_block(block->branch->targets[0]);
-            } else {
-                block = block->branch->targets[0];
-                goto inline_jump;
-            }
+    double a = vm_int_generic_float(locals, lhs);
+    double b = vm_int_generic_float(locals, rhs);
+    switch (instr->op) {
+        case VM_IR_IOP_ADD: {
+            return vm_value_from_float(a + b);
+        }
+        case VM_IR_IOP_SUB: {
+            return vm_value_from_float(a - b);
+        }
+        case VM_IR_IOP_MUL: {
+            return vm_value_from_float(a * b);
+        }
+        case VM_IR_IOP_DIV: {
+            return vm_value_from_float(a / b);
+        }
+        default: {
+            return vm_value_from_float(fmod(a, b));
+        }
+    }
+}
+
+static vm_value_t vm_int_generic_bits(vm_value_t *locals, vm_ir_instr_t *instr) {
+    vm_ir_arg_t lhs = instr->args[0];
+    vm_ir_arg_t rhs = instr->args[1];
+    vm_int_t a = vm_int_generic_int(locals, lhs);
+    vm_int_t b = vm_int_generic_int(locals, rhs);
+    vm_int_t res;
+    switch (instr->op) {
+        case VM_IR_IOP_BOR: {
+            res = a | b;
+            break;
+        }
+        case VM_IR_IOP_BAND: {
+            res = a & b;
             break;
         }
+        case VM_IR_IOP_BXOR: {
+            res = a ^ b;
+            break;
+        }
+        case VM_IR_IOP_BSHL: {
+            res = a << b;
+            break;
+        }
+        default: {
+            res = a >> b;
+            break;
+        }
+    }
+    if (lhs.type != VM_IR_ARG_REG && rhs.type != VM_IR_ARG_REG) {
+        return vm_int_generic_num((double)res);
+    }
+    return vm_value_from_int(res);
+}
+
+static vm_int_generic_t vm_int_generic_branch(vm_value_t *locals, vm_ir_branch_t *branch) {
+    vm_ir_arg_t lhs = branch->args[0];
+    vm_ir_arg_t rhs = branch->args[1];
+    switch (branch->op) {
+        case VM_IR_BOP_JUMP: {
+            return (vm_int_generic_t){.kind = VM_INT_GENERIC_JUMP, .block = branch->targets[0]};
+        }
         case VM_IR_BOP_BOOL: {
-            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
-                // jump l
-                vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                vm_int_block_comp_put_block(block->branch->targets[block->branch->args[0].num != 0]);
+            bool truthy;
+            if (lhs.type == VM_IR_ARG_NUM) {
+                truthy = lhs.num != 0;
             } else {
-                // bb r l l
-                if (types[block->branch->args[0].reg] == VM_TYPE_BOOL) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_BB_RTT);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
-                    vm_int_block_comp_put_block(block->branch->targets[0]);
-                    vm_int_block_comp_put_block(block->branch->targets[1]);
-                } else if (types[block->branch->args[0].reg] == VM_TYPE_NIL) {
-                    if (block->branch->targets[0]->id <= block->id) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                    } else {
-                        block = block->branch->targets[0];
-                        goto inline_jump;
-                    }
+                vm_value_t value = locals[lhs.reg];
+                uint8_t type = vm_typeof(value);
+                if (type == VM_TYPE_BOOL) {
+                    truthy = vm_value_to_bool(value);
                 } else {
-                    if (block->branch->targets[1]->id <= block->id) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else {
-                        block = block->branch->targets[1];
-                        goto inline_jump;
-                    }
+                    truthy = type != VM_TYPE_NIL;
                 }
             }
-            break;
+            return (vm_int_generic_t){.kind = VM_INT_GENERIC_JUMP, .block = branch->targets[truthy]};
         }
         case VM_IR_BOP_LESS: {
-            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
-                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
-                    // jump l
-                    vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                    vm_int_block_comp_put_block(
-                        block->branch->targets[block->branch->args[0].num < block->branch->args[1].num]);
+            bool less;
+            if (lhs.type == VM_IR_ARG_NUM && rhs.type == VM_IR_ARG_NUM) {
+                less = lhs.num < rhs.num;
+            } else if (vm_int_generic_is_int(locals, lhs) && vm_int_generic_is_int(locals, rhs)) {
+                less = vm_int_generic_int(locals, lhs) < vm_int_generic_int(locals, rhs);
+            } else {
+                double a = vm_int_generic_float(locals, lhs);
+                double b = vm_int_generic_float(locals, rhs);
+                less = a < b;
+            }
+            return (vm_int_generic_t){.kind = VM_INT_GENERIC_JUMP, .block = branch->targets[less]};
+        }
+        case VM_IR_BOP_EQUAL: {
+            bool equal;
+            if (lhs.type == VM_IR_ARG_NUM && rhs.type == VM_IR_ARG_NUM) {
+                equal = lhs.num == rhs.num;
+            } else if (vm_int_generic_is_number(locals, lhs) && vm_int_generic_is_number(locals, rhs)) {
+                if (vm_int_generic_is_int(locals, lhs) && vm_int_generic_is_int(locals, rhs)) {
+                    equal = vm_int_generic_int(locals, lhs) == vm_int_generic_int(locals, rhs);
                 } else {
-                    // blt i r l l
-                    if (types[block->branch->args[1].reg] == VM_TYPE_I32 && fmod(block->branch->args[0].num, 1) == 0.0) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BLT_IRTT);
-                        vm_int_block_comp_put_ival(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else {
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[1].reg);
-                        vm_int_block_comp_put_ptr(VM_INT_OP_FBLT_FRTT);
-                        vm_int_block_comp_put_fval(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    }
+                    double a = vm_int_generic_float(locals, lhs);
+                    double b = vm_int_generic_float(locals, rhs);
+                    equal = a == b;
                 }
+            } else if (lhs.type != VM_IR_ARG_REG || rhs.type != VM_IR_ARG_REG) {
+                equal = false;
             } else {
-                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
-                    // blt r i l l
-                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && fmod(block->branch->args[1].num, 1) == 0.0) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BLT_RITT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_ival(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else {
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
-                        vm_int_block_comp_put_ptr(VM_INT_OP_FBLT_RFTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_fval(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    }
+                equal = vm_gc_eq(locals[lhs.reg], locals[rhs.reg]);
+            }
+            return (vm_int_generic_t){.kind = VM_INT_GENERIC_JUMP, .block = branch->targets[equal]};
+        }
+        case VM_IR_BOP_RET: {
+            vm_value_t value;
+            if (lhs.type == VM_IR_ARG_NUM) {
+                if (fmod(lhs.num, 1) == 0) {
+                    value = vm_value_from_int((int32_t)lhs.num);
                 } else {
-                    // blt r r l l
-                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && types[block->branch->args[1].reg] == VM_TYPE_I32) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BLT_RRTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else {
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[1].reg);
-                        vm_int_block_comp_put_ptr(VM_INT_OP_FBLT_RRTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    }
+                    value = vm_value_from_float(lhs.num);
                 }
+            } else {
+                value = locals[lhs.reg];
             }
-            break;
+            return (vm_int_generic_t){.kind = VM_INT_GENERIC_RET, .value = value};
         }
-        case VM_IR_BOP_EQUAL: {
-            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
-                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
-                    // jump l
-                    vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                    vm_int_block_comp_put_block(
-                        block->branch->targets[block->branch->args[0].num == block->branch->args[1].num]);
-                } else {
-                    // beq i r l l
-                    if (types[block->branch->args[1].reg] == VM_TYPE_I32 && fmod(block->branch->args[0].num, 1) == 0.0) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BEQ_IRTT);
-                        vm_int_block_comp_put_ival(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else if (types[block->branch->args[1].reg] == VM_TYPE_I32 || types[block->branch->args[1].reg] == VM_TYPE_F64) {
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
-                        vm_int_block_comp_put_ptr(VM_INT_OP_FBEQ_FRTT);
-                        vm_int_block_comp_put_fval(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
+        default: {
+            return (vm_int_generic_t){.kind = VM_INT_GENERIC_EXIT};
+        }
+    }
+}
+
+// runs a block for whatever its registers hold, making at each instr the
+// choice vm_int_block_comp would make for their types: calls are staged past
+// the frame the way the call ops stage them and left to the caller to enter
+static vm_int_generic_t __attribute__((noinline)) vm_int_generic_run(vm_int_state_t *state, vm_ir_block_t *block) {
+    vm_value_t *locals = state->locals;
+    size_t fsize = block->nregs + 1;
+    for (size_t i = 0; i < block->len; i++) {
+        vm_ir_instr_t *instr = block->instrs[i];
+        vm_ir_arg_t *args = instr->args;
+        bool has_out = instr->out.type == VM_IR_ARG_REG;
+        size_t out = instr->out.reg;
+        switch (instr->op) {
+            case VM_IR_IOP_NOP: {
+                break;
+            }
+            case VM_IR_IOP_MOVE: {
+                if (has_out) {
+                    if (args[0].type == VM_IR_ARG_STR) {
+                        fprintf(stderr, "NO STRINGS YET\n");
+                        __builtin_trap();
                     }
+                    locals[out] = vm_int_generic_load(locals, args[0]);
                 }
-            } else {
-                if (block->branch->args[1].type == VM_IR_ARG_NUM) {
-                    // beq r i l l
-                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && fmod(block->branch->args[1].num, 1) == 0.0) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BEQ_RITT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_ival(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else if (types[block->branch->args[0].reg] == VM_TYPE_I32 || types[block->branch->args[0].reg] == VM_TYPE_F64) {
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
-                        vm_int_block_comp_put_ptr(VM_INT_OP_FBEQ_RFTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_fval(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_JUMP_T);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
+                break;
+            }
+            case VM_IR_IOP_ADD:
+            case VM_IR_IOP_SUB:
+            case VM_IR_IOP_MUL:
+            case VM_IR_IOP_DIV:
+            case VM_IR_IOP_MOD: {
+                if (has_out) {
+                    locals[out] = vm_int_generic_arith(locals, block, instr);
+                }
+                break;
+            }
+            case VM_IR_IOP_BOR:
+            case VM_IR_IOP_BAND:
+            case VM_IR_IOP_BXOR:
+            case VM_IR_IOP_BSHL:
+            case VM_IR_IOP_BSHR: {
+                if (has_out) {
+                    locals[out] = vm_int_generic_bits(locals, instr);
+                }
+                break;
+            }
+            case VM_IR_IOP_CALL:
+            case VM_IR_IOP_TCALL: {
+                size_t nargs = 0;
+                while (args[nargs + 1].type != VM_IR_ARG_NONE) {
+                    nargs += 1;
+                }
+                if (args[0].type == VM_IR_ARG_EXTERN) {
+                    vm_int_func_t ptr = state->funcs[(int32_t)args[0].num];
+                    vm_value_t small[8];
+                    vm_value_t *values = nargs <= 8 ? &small[0] : vm_malloc(sizeof(vm_value_t) * nargs);
+                    for (size_t j = 0; j < nargs; j++) {
+                        values[j] = vm_int_generic_load(locals, args[j + 1]);
+                    }
+                    state->locals = locals + state->framesize;
+                    vm_value_t ret = ptr.func(ptr.data, state, nargs, values);
+                    state->locals = locals;
+                    if (values != &small[0]) {
+                        vm_free(values);
                     }
+                    locals[has_out ? out : fsize] = ret;
+                    break;
+                }
+                vm_ir_block_t *func;
+                size_t first = 0;
+                vm_value_t *to = &locals[fsize + 1];
+                if (args[0].type == VM_IR_ARG_FUNC) {
+                    func = args[0].func;
                 } else {
-                    // beq r r l l
-                    if (types[block->branch->args[0].reg] == VM_TYPE_I32 && types[block->branch->args[1].reg] == VM_TYPE_I32) {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_I32BEQ_RRTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
-                    } else if ((types[block->branch->args[0].reg] == VM_TYPE_I32 || types[block->branch->args[0].reg] == VM_TYPE_F64) && (types[block->branch->args[1].reg] == VM_TYPE_I32 || types[block->branch->args[1].reg] == VM_TYPE_F64)) {
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[0].reg);
-                        vm_int_block_comp_ensure_float_reg(block->branch->args[1].reg);
-                        vm_int_block_comp_put_ptr(VM_INT_OP_FBEQ_RRTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
+                    vm_value_t value = locals[args[0].reg];
+                    uint8_t type = vm_typeof(value);
+                    if (type == VM_TYPE_FUNC) {
+                        func = vm_value_to_block(value);
+                    } else if (type == VM_TYPE_ARRAY) {
+                        func = vm_value_to_block(vm_gc_get_i(value, 0));
+                        to[0] = value;
+                        first = 1;
                     } else {
-                        vm_int_block_comp_put_ptr(VM_INT_OP_DYNBEQ_RRTT);
-                        vm_int_block_comp_put_reg(block->branch->args[0]);
-                        vm_int_block_comp_put_reg(block->branch->args[1]);
-                        vm_int_block_comp_put_block(block->branch->targets[0]);
-                        vm_int_block_comp_put_block(block->branch->targets[1]);
+                        fprintf(stderr, "type error on call r%zu (type %zu)\n", args[0].reg, (size_t)type);
+                        __builtin_trap();
                     }
                 }
-            }
-            break;
-        }
-        case VM_IR_BOP_RET: {
-            if (block->branch->args[0].type == VM_IR_ARG_NUM) {
-                // ret i
-                if (fmod(block->branch->args[0].num, 1) == 0) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_I);
-                    vm_int_block_comp_put_ival(block->branch->args[0]);
-                } else {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_F);
-                    vm_int_block_comp_put_fval(block->branch->args[0]);
+                for (size_t j = 0; j < nargs; j++) {
+                    to[first + j] = vm_int_generic_load(locals, args[j + 1]);
                 }
-            } else {
-                uint8_t type = types[block->branch->args[0].reg];
-                if (type == VM_TYPE_NIL) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RV);
+                if (instr->op == VM_IR_IOP_TCALL) {
+                    for (size_t j = 0; j < first + nargs; j++) {
+                        locals[1 + j] = to[j];
+                    }
+                    return (vm_int_generic_t){.kind = VM_INT_GENERIC_TCALL, .block = func};
                 }
-                if (type == VM_TYPE_BOOL) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RB);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                return (vm_int_generic_t){.kind = VM_INT_GENERIC_CALL, .block = func};
+            }
+            case VM_IR_IOP_ARR: {
+                if (has_out) {
+                    vm_int_t len = (vm_int_t)vm_int_generic_float(locals, args[0]);
+                    vm_gc_run(&state->gc, locals + fsize);
+                    locals[out] = vm_gc_arr(&state->gc, len);
                 }
-                if (type == VM_TYPE_I32) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RI);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                break;
+            }
+            case VM_IR_IOP_TAB: {
+                if (has_out) {
+                    vm_gc_run(&state->gc, locals + fsize);
+                    locals[out] = vm_gc_tab(&state->gc);
+                }
+                break;
+            }
+            case VM_IR_IOP_GET: {
+                if (has_out && args[0].type == VM_IR_ARG_REG) {
+                    vm_value_t obj = locals[args[0].reg];
+                    uint8_t type = vm_typeof(obj);
+                    if (type == VM_TYPE_TABLE) {
+                        vm_value_t key = args[1].type == VM_IR_ARG_REG ? locals[args[1].reg] : vm_value_from_float(args[1].num);
+                        locals[out] = vm_gc_table_get(vm_value_to_table(obj), key);
+                    } else if (type == VM_TYPE_ARRAY) {
+                        double key = vm_int_generic_float(locals, args[1]);
+                        locals[out] = vm_gc_get_i(obj, key);
+                    } else {
+                        fprintf(stderr, "cannot get: r%zu (tag: %zu)\n", args[0].reg, (size_t)type);
+                        __builtin_trap();
+                    }
                 }
-                if (type == VM_TYPE_F64) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RF);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                break;
+            }
+            case VM_IR_IOP_SET: {
+                if (args[0].type == VM_IR_ARG_REG) {
+                    vm_value_t obj = locals[args[0].reg];
+                    uint8_t type = vm_typeof(obj);
+                    vm_value_t value = args[2].type == VM_IR_ARG_REG ? locals[args[2].reg] : vm_value_from_float(args[2].num);
+                    if (type == VM_TYPE_TABLE) {
+                        vm_value_t key = args[1].type == VM_IR_ARG_REG ? locals[args[1].reg] : vm_value_from_float(args[1].num);
+                        vm_gc_table_set(&state->gc, vm_value_to_table(obj), key, value);
+                    } else if (type == VM_TYPE_ARRAY) {
+                        double key = vm_int_generic_float(locals, args[1]);
+                        vm_gc_set_iv(&state->gc, obj, key, value);
+                    } else {
+                        fprintf(stderr, "cannot set: r%zu\n", args[0].reg);
+                        __builtin_trap();
+                    }
                 }
-                if (type == VM_TYPE_FUNC) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RF);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                break;
+            }
+            case VM_IR_IOP_LEN: {
+                if (has_out && args[0].type == VM_IR_ARG_REG) {
+                    vm_value_t obj = locals[args[0].reg];
+                    if (vm_typeof(obj) != VM_TYPE_ARRAY) {
+                        fprintf(stderr, "cannot len: r%zu\n", args[0].reg);
+                        __builtin_trap();
+                    }
+                    locals[out] = vm_value_from_int(vm_gc_len(obj));
                 }
-                if (type == VM_TYPE_ARRAY) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RA);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                break;
+            }
+            case VM_IR_IOP_TYPE: {
+                if (has_out) {
+                    uint8_t type = args[0].type == VM_IR_ARG_REG ? vm_typeof(locals[args[0].reg]) : VM_TYPE_F64;
+                    locals[out] = vm_int_generic_num(type);
                 }
-                if (type == VM_TYPE_TABLE) {
-                    vm_int_block_comp_put_ptr(VM_INT_OP_RET_RT);
-                    vm_int_block_comp_put_reg(block->branch->args[0]);
+                break;
+            }
+            case VM_IR_IOP_IN: {
+                if (has_out) {
+                    locals[out] = vm_value_from_int(fgetc(stdin));
                 }
-                // ret r
+                break;
+            }
+            case VM_IR_IOP_OUT: {
+                if (args[0].type == VM_IR_ARG_NUM) {
+                    fprintf(stdout, "%c", (int)(int32_t)args[0].num);
+                } else {
+                    fprintf(stdout, "%c", (int)vm_int_generic_float(locals, args[0]));
+                }
+                break;
+            }
+            default: {
+                fprintf(stderr, "unimplemented op: %zu\n", (size_t)instr->op);
+                __builtin_trap();
             }
-            break;
-        }
-        case VM_IR_BOP_EXIT: {
-            // exit
-            vm_int_block_comp_put_ptr(VM_INT_OP_EXIT);
-            break;
         }
     }
-retv:
-#if defined(VM_DEBUG_COMP)
-    fprintf(stderr, "  ");
-    vm_ir_print_branch(stderr, block->branch);
-    fprintf(stderr, "\n}\n\n");
-#endif
-    for (size_t a = 0; a < state->framesize; a++) {
-        types[a] = vm_typeof(state->locals[a]);
+    return vm_int_generic_branch(locals, block->branch);
+}
+
+// the argument array lives in this frame rather than the handler's, which
+// keeps the handler free of addressable locals so its dispatch can be a tail call
+static vm_value_t __attribute__((noinline)) vm_int_run_extern(vm_int_state_t *state, vm_int_func_t ptr, size_t nargs, vm_int_opcode_t *args) {
+    vm_value_t small[8];
+    vm_value_t *values = nargs <= 8 ? &small[0] : vm_malloc(sizeof(vm_value_t) * nargs);
+    for (size_t i = 0; i < nargs; i++) {
+        values[i] = state->locals[args[i].reg];
     }
-    vm_int_data_push(data, buf, types);
-    if (state->use_spall) {
-        vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
+    state->locals += state->framesize;
+    vm_value_t ret = ptr.func(ptr.data, state, nargs, values);
+    if (values != &small[0]) {
+        vm_free(values);
     }
-    return buf.ops;
+    return ret;
 }
 
-#define vm_int_run_read()              \
-    (*({                               \
-        vm_int_opcode_t *ret = (head); \
-        head += 1;                     \
-        ret;                           \
-    }))
-
-#define vm_int_run_next() goto *vm_int_run_read().ptr
+#define VM_INT_RUN_OPS(X)                                   \
+    X(EXIT, exit)                                           \
+    X(MOV_V, mov_v)                                         \
+    X(MOV_B, mov_b)                                         \
+    X(MOV_I, mov_i)                                         \
+    X(MOV_F, mov_f)                                         \
+    X(MOV_R, mov_r)                                         \
+    X(MOV_T, mov_t)                                         \
+    X(FMOV_R, fmov_r)                                       \
+    X(IMOV_R, imov_r)                                       \
+    X(DYNBEQ_RRLL, dynbeq_rrll)                             \
+    X(DYNBEQ_RRTT, dynbeq_rrtt)                             \
+    X(I32BOR_RR, i32bor_rr)                                 \
+    X(I32BOR_RI, i32bor_ri)                                 \
+    X(I32BAND_RR, i32band_rr)                               \
+    X(I32BAND_RI, i32band_ri)                               \
+    X(I32BXOR_RR, i32bxor_rr)                               \
+    X(I32BXOR_RI, i32bxor_ri)                               \
+    X(I32BSHL_RR, i32bshl_rr)                               \
+    X(I32BSHL_RI, i32bshl_ri)                               \
+    X(I32BSHR_RR, i32bshr_rr)                               \
+    X(I32BSHR_RI, i32bshr_ri)                               \
+    X(I32ADD_RR, i32add_rr)                                 \
+    X(I32ADD_RI, i32add_ri)                                 \
+    X(I32SUB_RR, i32sub_rr)                                 \
+    X(I32SUB_RI, i32sub_ri)                                 \
+    X(I32SUB_IR, i32sub_ir)                                 \
+    X(I32MUL_RR, i32mul_rr)                                 \
+    X(I32MUL_RI, i32mul_ri)                                 \
+    X(I32DIV_RR, i32div_rr)                                 \
+    X(I32DIV_RI, i32div_ri)                                 \
+    X(I32DIV_IR, i32div_ir)                                 \
+    X(I32MOD_RR, i32mod_rr)                                 \
+    X(I32MOD_RI, i32mod_ri)                                 \
+    X(I32MOD_IR, i32mod_ir)                                 \
+    X(I32BLT_RRLL, i32blt_rrll)                             \
+    X(I32BLT_RILL, i32blt_rill)                             \
+    X(I32BLT_IRLL, i32blt_irll)                             \
+    X(I32BEQ_RRLL, i32beq_rrll)                             \
+    X(I32BEQ_RILL, i32beq_rill)                             \
+    X(I32BEQ_IRLL, i32beq_irll)                             \
+    X(I32BLT_RRTT, i32blt_rrtt)                             \
+    X(I32BLT_RITT, i32blt_ritt)                             \
+    X(I32BLT_IRTT, i32blt_irtt)                             \
+    X(I32BEQ_RRTT, i32beq_rrtt)                             \
+    X(I32BEQ_RITT, i32beq_ritt)                             \
+    X(I32BEQ_IRTT, i32beq_irtt)                             \
+    X(FADD_RR, fadd_rr)                                     \
+    X(FADD_RF, fadd_rf)                                     \
+    X(FSUB_RR, fsub_rr)                                     \
+    X(FSUB_RF, fsub_rf)                                     \
+    X(FSUB_FR, fsub_fr)                                     \
+    X(FMUL_RR, fmul_rr)                                     \
+    X(FMUL_RF, fmul_rf)                                     \
+    X(FDIV_RR, fdiv_rr)                                     \
+    X(FDIV_RF, fdiv_rf)                                     \
+    X(FDIV_FR, fdiv_fr)                                     \
+    X(FMOD_RR, fmod_rr)                                     \
+    X(FMOD_RF, fmod_rf)                                     \
+    X(FMOD_FR, fmod_fr)                                     \
+    X(FBLT_RRLL, fblt_rrll)                                 \
+    X(FBLT_RFLL, fblt_rfll)                                 \
+    X(FBLT_FRLL, fblt_frll)                                 \
+    X(FBEQ_RRLL, fbeq_rrll)                                 \
+    X(FBEQ_RFLL, fbeq_rfll)                                 \
+    X(FBEQ_FRLL, fbeq_frll)                                 \
+    X(FBLT_RRTT, fblt_rrtt)                                 \
+    X(FBLT_RFTT, fblt_rftt)                                 \
+    X(FBLT_FRTT, fblt_frtt)                                 \
+    X(FBEQ_RRTT, fbeq_rrtt)                                 \
+    X(FBEQ_RFTT, fbeq_rftt)                                 \
+    X(FBEQ_FRTT, fbeq_frtt)                                 \
+    X(CALL_L0, call_l0)                                     \
+    X(CALL_L1, call_l1)                                     \
+    X(CALL_L2, call_l2)                                     \
+    X(CALL_L3, call_l3)                                     \
+    X(CALL_L4, call_l4)                                     \
+    X(CALL_L5, call_l5)                                     \
+    X(CALL_L6, call_l6)                                     \
+    X(CALL_L7, call_l7)                                     \
+    X(CALL_L8, call_l8)                                     \
+    X(CALL_LN, call_ln)                                     \
+    X(CALL_R0, call_r0)                                     \
+    X(CALL_R1, call_r1)                                     \
+    X(CALL_R2, call_r2)                                     \
+    X(CALL_R3, call_r3)                                     \
+    X(CALL_R4, call_r4)                                     \
+    X(CALL_R5, call_r5)                                     \
+    X(CALL_R6, call_r6)                                     \
+    X(CALL_R7, call_r7)                                     \
+    X(CALL_R8, call_r8)                                     \
+    X(CALL_RN, call_rn)                                     \
+    X(CALL_X0, call_x0)                                     \
+    X(CALL_X1, call_x1)                                     \
+    X(CALL_X2, call_x2)                                     \
+    X(CALL_X3, call_x3)                                     \
+    X(CALL_X4, call_x4)                                     \
+    X(CALL_X5, call_x5)                                     \
+    X(CALL_X6, call_x6)                                     \
+    X(CALL_X7, call_x7)                                     \
+    X(CALL_X8, call_x8)                                     \
+    X(CALL_XN, call_xn)                                     \
+    X(CALL_C0, call_c0)                                     \
+    X(CALL_C1, call_c1)                                     \
+    X(CALL_C2, call_c2)                                     \
+    X(CALL_C3, call_c3)                                     \
+    X(CALL_C4, call_c4)                                     \
+    X(CALL_C5, call_c5)                                     \
+    X(CALL_C6, call_c6)                                     \
+    X(CALL_C7, call_c7)                                     \
+    X(CALL_CN, call_cn)                                     \
+    X(ARR_F, arr_f)                                         \
+    X(ARR_R, arr_r)                                         \
+    X(SET_RRR, set_rrr)                                     \
+    X(SET_RRI, set_rri)                                     \
+    X(SET_RIR, set_rir)                                     \
+    X(SET_RII, set_rii)                                     \
+    X(GET_RR, get_rr)                                       \
+    X(GET_RI, get_ri)                                       \
+    X(LEN_R, len_r)                                         \
+    X(IN_V, in_v)                                           \
+    X(OUT_I, out_i)                                         \
+    X(OUT_R, out_r)                                         \
+    X(JUMP_L, jump_l)                                       \
+    X(BB_RLL, bb_rll)                                       \
+    X(RET_I, ret_i)                                         \
+    X(RET_F, ret_f)                                         \
+    X(RET_RV, ret_rv)                                       \
+    X(RET_RB, ret_rb)                                       \
+    X(RET_RI, ret_ri)                                       \
+    X(RET_RIF, ret_rif)                                     \
+    X(RET_RF, ret_rf)                                       \
+    X(RET_RA, ret_ra)                                       \
+    X(RET_RT, ret_rt)                                       \
+    X(CALL_T0, call_t0)                                     \
+    X(CALL_T1, call_t1)                                     \
+    X(CALL_T2, call_t2)                                     \
+    X(CALL_T3, call_t3)                                     \
+    X(CALL_T4, call_t4)                                     \
+    X(CALL_T5, call_t5)                                     \
+    X(CALL_T6, call_t6)                                     \
+    X(CALL_T7, call_t7)                                     \
+    X(CALL_T8, call_t8)                                     \
+    X(CALL_TN, call_tn)                                     \
+    X(JUMP_T, jump_t)                                       \
+    X(BB_RTT, bb_rtt)                                       \
+    X(TAB, tab)                                             \
+    X(TSET_RRR, tset_rrr)                                   \
+    X(TSET_RRF, tset_rrf)                                   \
+    X(TSET_RFR, tset_rfr)                                   \
+    X(TSET_RFF, tset_rff)                                   \
+    X(TGET_RR, tget_rr)                                     \
+    X(TGET_RF, tget_rf)                                     \
+    X(DEBUG_PRINT_INSTRS, debug_print_instrs)               \
+    X(COUNT, count)                                         \
+    X(COUNT_BLOCK, count_block)                             \
+    X(SAMPLE, sample)                                       \
+    X(TCALL_L, tcall_l)                                     \
+    X(TCALL_T, tcall_t)                                     \
+    X(TCALL_R, tcall_r)                                     \
+    X(TCALL_C, tcall_c)                                     \
+    X(GENERIC, generic)                                     \
+    X(GENERIC_JUMP, generic_jump)                           \
+    X(I32MOD_RR_BEQ_RILL, i32mod_rr_beq_rill)               \
+    X(I32MOD_RR_BEQ_RITT, i32mod_rr_beq_ritt)               \
+    X(I32MUL_RR_BLT_RRLL, i32mul_rr_blt_rrll)               \
+    X(I32MUL_RR_BLT_RRTT, i32mul_rr_blt_rrtt)               \
+    X(I32ADD_RI_BLT_RRLL, i32add_ri_blt_rrll)               \
+    X(I32ADD_RI_BLT_RRTT, i32add_ri_blt_rrtt)               \
+    X(I32ADD_RI_MUL_RR, i32add_ri_mul_rr)                   \
+    X(I32ADD_RI_MUL_RR_BLT_RRLL, i32add_ri_mul_rr_blt_rrll) \
+    X(I32ADD_RI_MUL_RR_BLT_RRTT, i32add_ri_mul_rr_blt_rrtt) \
+    X(I32SUB_RI_SUB_RR, i32sub_ri_sub_rr)                   \
+    X(LEN_R_I32BEQ_RILL, len_r_i32beq_rill)                 \
+    X(LEN_R_I32BEQ_RITT, len_r_i32beq_ritt)                 \
+    X(MOV_I_I32SUB_RI, mov_i_i32sub_ri)
 
-#define vm_int_run_read_store() (&locals[vm_int_run_read().reg])
-
-#define vm_int_run_read_load() (locals[vm_int_run_read().reg])
+#define vm_int_run_ptr(op_, name_) [VM_INT_OP_##op_] = vm_int_run_label(name_),
 
-#define vm_int_run_save()       \
-    ({                          \
-        state->locals = locals; \
-        state->heads = heads;   \
-        state;                  \
-    })
+#if VM_INT_TAIL
+#define vm_int_run_decl(op_, name_) vm_int_run_op(name_);
+VM_INT_RUN_OPS(vm_int_run_decl)
+vm_int_run_op(call_x_check);
 
-void vm_main_spall_init(vm_int_state_t *state, const char *name) {
-    state->use_spall = true;
-    state->spall_ctx = vm_trace_init(name, 0.000303);
-    vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "MiniVM Invocation");
-}
+static void *vm_int_run_ptrs[VM_INT_MAX_OP] = {VM_INT_RUN_OPS(vm_int_run_ptr)};
+#else
+#if VM_INT_SWITCH
+#define vm_int_run_code(op_, name_) VM_INT_RUN_CODE_##name_ = VM_INT_OP_##op_ + 1,
+enum {
+    VM_INT_RUN_OPS(vm_int_run_code)
+};
 
-void vm_main_spall_deinit(vm_int_state_t *state) {
-    vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
-    vm_trace_quit(&state->spall_ctx);
-}
+#define vm_int_run_case(op_, name_) \
+    case VM_INT_RUN_CODE_##name_:   \
+        goto do_##name_;
+#endif
 
 vm_value_t vm_int_run(vm_int_state_t *state, vm_ir_block_t *block0) {
-    static void *ptrs[VM_INT_MAX_OP] = {
-        [VM_INT_OP_EXIT] = &&do_exit,
-        [VM_INT_OP_MOV_V] = &&do_mov_v,
-        [VM_INT_OP_MOV_B] = &&do_mov_b,
-        [VM_INT_OP_MOV_I] = &&do_mov_i,
-        [VM_INT_OP_MOV_F] = &&do_mov_f,
-        [VM_INT_OP_MOV_R] = &&do_mov_r,
-        [VM_INT_OP_MOV_T] = &&do_mov_t,
-        [VM_INT_OP_FMOV_R] = &&do_fmov_r,
-        [VM_INT_OP_IMOV_R] = &&do_imov_r,
-        [VM_INT_OP_DYNBEQ_RRLL] = &&do_dynbeq_rrll,
-        [VM_INT_OP_DYNBEQ_RRTT] = &&do_dynbeq_rrtt,
-        [VM_INT_OP_I32BOR_RR] = &&do_i32bor_rr,
-        [VM_INT_OP_I32BOR_RI] = &&do_i32bor_ri,
-        [VM_INT_OP_I32BAND_RR] = &&do_i32band_rr,
-        [VM_INT_OP_I32BAND_RI] = &&do_i32band_ri,
-        [VM_INT_OP_I32BXOR_RR] = &&do_i32bxor_rr,
-        [VM_INT_OP_I32BXOR_RI] = &&do_i32bxor_ri,
-        [VM_INT_OP_I32BSHL_RR] = &&do_i32bshl_rr,
-        [VM_INT_OP_I32BSHL_RI] = &&do_i32bshl_ri,
-        [VM_INT_OP_I32BSHR_RR] = &&do_i32bshr_rr,
-        [VM_INT_OP_I32BSHR_RI] = &&do_i32bshr_ri,
-        [VM_INT_OP_I32ADD_RR] = &&do_i32add_rr,
-        [VM_INT_OP_I32ADD_RI] = &&do_i32add_ri,
-        [VM_INT_OP_I32SUB_RR] = &&do_i32sub_rr,
-        [VM_INT_OP_I32SUB_RI] = &&do_i32sub_ri,
-        [VM_INT_OP_I32SUB_IR] = &&do_i32sub_ir,
-        [VM_INT_OP_I32MUL_RR] = &&do_i32mul_rr,
-        [VM_INT_OP_I32MUL_RI] = &&do_i32mul_ri,
-        [VM_INT_OP_I32DIV_RR] = &&do_i32div_rr,
-        [VM_INT_OP_I32DIV_RI] = &&do_i32div_ri,
-        [VM_INT_OP_I32DIV_IR] = &&do_i32div_ir,
-        [VM_INT_OP_I32MOD_RR] = &&do_i32mod_rr,
-        [VM_INT_OP_I32MOD_RI] = &&do_i32mod_ri,
-        [VM_INT_OP_I32MOD_IR] = &&do_i32mod_ir,
-        [VM_INT_OP_I32BLT_RRLL] = &&do_i32blt_rrll,
-        [VM_INT_OP_I32BLT_RILL] = &&do_i32blt_rill,
-        [VM_INT_OP_I32BLT_IRLL] = &&do_i32blt_irll,
-        [VM_INT_OP_I32BEQ_RRLL] = &&do_i32beq_rrll,
-        [VM_INT_OP_I32BEQ_RILL] = &&do_i32beq_rill,
-        [VM_INT_OP_I32BEQ_IRLL] = &&do_i32beq_irll,
-        [VM_INT_OP_I32BLT_RRTT] = &&do_i32blt_rrtt,
-        [VM_INT_OP_I32BLT_RITT] = &&do_i32blt_ritt,
-        [VM_INT_OP_I32BLT_IRTT] = &&do_i32blt_irtt,
-        [VM_INT_OP_I32BEQ_RRTT] = &&do_i32beq_rrtt,
-        [VM_INT_OP_I32BEQ_RITT] = &&do_i32beq_ritt,
-        [VM_INT_OP_I32BEQ_IRTT] = &&do_i32beq_irtt,
-        [VM_INT_OP_FADD_RR] = &&do_fadd_rr,
-        [VM_INT_OP_FADD_RF] = &&do_fadd_rf,
-        [VM_INT_OP_FSUB_RR] = &&do_fsub_rr,
-        [VM_INT_OP_FSUB_RF] = &&do_fsub_rf,
-        [VM_INT_OP_FSUB_FR] = &&do_fsub_fr,
-        [VM_INT_OP_FMUL_RR] = &&do_fmul_rr,
-        [VM_INT_OP_FMUL_RF] = &&do_fmul_rf,
-        [VM_INT_OP_FDIV_RR] = &&do_fdiv_rr,
-        [VM_INT_OP_FDIV_RF] = &&do_fdiv_rf,
-        [VM_INT_OP_FDIV_FR] = &&do_fdiv_fr,
-        [VM_INT_OP_FMOD_RR] = &&do_fmod_rr,
-        [VM_INT_OP_FMOD_RF] = &&do_fmod_rf,
-        [VM_INT_OP_FMOD_FR] = &&do_fmod_fr,
-        [VM_INT_OP_FBLT_RRLL] = &&do_fblt_rrll,
-        [VM_INT_OP_FBLT_RFLL] = &&do_fblt_rfll,
-        [VM_INT_OP_FBLT_FRLL] = &&do_fblt_frll,
-        [VM_INT_OP_FBEQ_RRLL] = &&do_fbeq_rrll,
-        [VM_INT_OP_FBEQ_RFLL] = &&do_fbeq_rfll,
-        [VM_INT_OP_FBEQ_FRLL] = &&do_fbeq_frll,
-        [VM_INT_OP_FBLT_RRTT] = &&do_fblt_rrtt,
-        [VM_INT_OP_FBLT_RFTT] = &&do_fblt_rftt,
-        [VM_INT_OP_FBLT_FRTT] = &&do_fblt_frtt,
-        [VM_INT_OP_FBEQ_RRTT] = &&do_fbeq_rrtt,
-        [VM_INT_OP_FBEQ_RFTT] = &&do_fbeq_rftt,
-        [VM_INT_OP_FBEQ_FRTT] = &&do_fbeq_frtt,
-        [VM_INT_OP_CALL_L0] = &&do_call_l0,
-        [VM_INT_OP_CALL_L1] = &&do_call_l1,
-        [VM_INT_OP_CALL_L2] = &&do_call_l2,
-        [VM_INT_OP_CALL_L3] = &&do_call_l3,
-        [VM_INT_OP_CALL_L4] = &&do_call_l4,
-        [VM_INT_OP_CALL_L5] = &&do_call_l5,
-        [VM_INT_OP_CALL_L6] = &&do_call_l6,
-        [VM_INT_OP_CALL_L7] = &&do_call_l7,
-        [VM_INT_OP_CALL_L8] = &&do_call_l8,
-        [VM_INT_OP_CALL_R0] = &&do_call_r0,
-        [VM_INT_OP_CALL_R1] = &&do_call_r1,
-        [VM_INT_OP_CALL_R2] = &&do_call_r2,
-        [VM_INT_OP_CALL_R3] = &&do_call_r3,
-        [VM_INT_OP_CALL_R4] = &&do_call_r4,
-        [VM_INT_OP_CALL_R5] = &&do_call_r5,
-        [VM_INT_OP_CALL_R6] = &&do_call_r6,
-        [VM_INT_OP_CALL_R7] = &&do_call_r7,
-        [VM_INT_OP_CALL_R8] = &&do_call_r8,
-        [VM_INT_OP_CALL_X0] = &&do_call_x0,
-        [VM_INT_OP_CALL_X1] = &&do_call_x1,
-        [VM_INT_OP_CALL_X2] = &&do_call_x2,
-        [VM_INT_OP_CALL_X3] = &&do_call_x3,
-        [VM_INT_OP_CALL_X4] = &&do_call_x4,
-        [VM_INT_OP_CALL_X5] = &&do_call_x5,
-        [VM_INT_OP_CALL_X6] = &&do_call_x6,
-        [VM_INT_OP_CALL_X7] = &&do_call_x7,
-        [VM_INT_OP_CALL_X8] = &&do_call_x8,
-        [VM_INT_OP_CALL_C0] = &&do_call_c0,
-        [VM_INT_OP_CALL_C1] = &&do_call_c1,
-        [VM_INT_OP_CALL_C2] = &&do_call_c2,
-        [VM_INT_OP_CALL_C3] = &&do_call_c3,
-        [VM_INT_OP_CALL_C4] = &&do_call_c4,
-        [VM_INT_OP_CALL_C5] = &&do_call_c5,
-        [VM_INT_OP_CALL_C6] = &&do_call_c6,
-        [VM_INT_OP_CALL_C7] = &&do_call_c7,
-        [VM_INT_OP_ARR_F] = &&do_arr_f,
-        [VM_INT_OP_ARR_R] = &&do_arr_r,
-        [VM_INT_OP_SET_RRR] = &&do_set_rrr,
-        [VM_INT_OP_SET_RRI] = &&do_set_rri,
-        [VM_INT_OP_SET_RIR] = &&do_set_rir,
-        [VM_INT_OP_SET_RII] = &&do_set_rii,
-        [VM_INT_OP_GET_RR] = &&do_get_rr,
-        [VM_INT_OP_GET_RI] = &&do_get_ri,
-        [VM_INT_OP_LEN_R] = &&do_len_r,
-        [VM_INT_OP_IN_V] = &&do_in_v,
-        [VM_INT_OP_OUT_I] = &&do_out_i,
-        [VM_INT_OP_OUT_R] = &&do_out_r,
-        [VM_INT_OP_JUMP_L] = &&do_jump_l,
-        [VM_INT_OP_BB_RLL] = &&do_bb_rll,
-        [VM_INT_OP_RET_I] = &&do_ret_i,
-        [VM_INT_OP_RET_F] = &&do_ret_f,
-        [VM_INT_OP_RET_RV] = &&do_ret_rv,
-        [VM_INT_OP_RET_RB] = &&do_ret_rb,
-        [VM_INT_OP_RET_RI] = &&do_ret_ri,
-        [VM_INT_OP_RET_RIF] = &&do_ret_rif,
-        [VM_INT_OP_RET_RF] = &&do_ret_rf,
-        [VM_INT_OP_RET_RA] = &&do_ret_ra,
-        [VM_INT_OP_RET_RT] = &&do_ret_rt,
-        [VM_INT_OP_CALL_T0] = &&do_call_t0,
-        [VM_INT_OP_CALL_T1] = &&do_call_t1,
-        [VM_INT_OP_CALL_T2] = &&do_call_t2,
-        [VM_INT_OP_CALL_T3] = &&do_call_t3,
-        [VM_INT_OP_CALL_T4] = &&do_call_t4,
-        [VM_INT_OP_CALL_T5] = &&do_call_t5,
-        [VM_INT_OP_CALL_T6] = &&do_call_t6,
-        [VM_INT_OP_CALL_T7] = &&do_call_t7,
-        [VM_INT_OP_CALL_T8] = &&do_call_t8,
-        [VM_INT_OP_JUMP_T] = &&do_jump_t,
-        [VM_INT_OP_BB_RTT] = &&do_bb_rtt,
-        [VM_INT_OP_TAB] = &&do_tab,
-        [VM_INT_OP_TSET_RRR] = &&do_tset_rrr,
-        [VM_INT_OP_TSET_RRF] = &&do_tset_rrf,
-        [VM_INT_OP_TSET_RFR] = &&do_tset_rfr,
-        [VM_INT_OP_TSET_RFF] = &&do_tset_rff,
-        [VM_INT_OP_TGET_RR] = &&do_tget_rr,
-        [VM_INT_OP_TGET_RF] = &&do_tget_rf,
-        [VM_INT_OP_DEBUG_PRINT_INSTRS] = &&do_debug_print_instrs,
-    };
+    static void *ptrs[VM_INT_MAX_OP] = {VM_INT_RUN_OPS(vm_int_run_ptr)};
+    vm_int_stack_limit(state);
     vm_value_t *init_locals = state->locals;
     vm_value_t *locals = init_locals;
     vm_int_opcode_t **init_heads = state->heads;
     vm_int_opcode_t **heads = init_heads;
     size_t framesize = state->framesize;
-    vm_int_opcode_t *head = vm_int_block_comp(vm_int_run_save(), ptrs, block0);
+    if (state->profile_len != 0) {
+        vm_int_profile_comp(state, ptrs);
+    }
+    if (state->precompile) {
+        vm_int_precompile(state, ptrs, block0);
+    }
+    vm_int_opcode_t *head = vm_int_run_comp(block0);
     if (state->use_spall) {
         vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "init");
     }
+#if VM_INT_SWITCH
+vm_int_run_dispatch:
+    switch ((size_t)vm_int_run_read_wide().ptr) {
+        VM_INT_RUN_OPS(vm_int_run_case)
+        default:
+            __builtin_unreachable();
+    }
+#else
     vm_int_run_next();
-do_debug_print_instrs : {
+#endif
+#endif
+vm_int_run_op(debug_print_instrs) {
     if (state->use_spall) {
         vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
     }
     size_t opcode = vm_int_run_read().reg;
+    if (state->pair_counts != NULL) {
+        state->pair_counts[state->pair_last * VM_INT_MAX_OP + opcode] += 1;
+        state->pair_last = opcode;
+    }
+    if (state->op_counts != NULL) {
+        state->op_counts[opcode] += 1;
+    }
     void *head0 = head;
-    head += 1;
+    head += VM_INT_WIDE;
     const char *opname = vm_int_debug_instr_name(opcode);
     if (state->debug_print_instrs) {
         const char *fmt = vm_int_debug_instr_format(opcode);
         switch (*fmt) {
             case ';': {
-                fprintf(state->debug_print_instrs, "r%zu <- ", vm_int_run_read().reg);
+                fprintf(state->debug_print_instrs, "r%zu <- ", (size_t)vm_int_run_read().reg);
                 fmt += 1;
                 head -= 1;
                 break;
             }
             case ':': {
-                fprintf(state->debug_print_instrs, "r%zu <- ", vm_int_run_read().reg);
+                fprintf(state->debug_print_instrs, "r%zu <- ", (size_t)vm_int_run_read().reg);
                 fmt += 1;
                 break;
             }
@@ -1513,7 +3976,7 @@ do_debug_print_instrs : {
                             fprintf(state->debug_print_instrs, "[any float %lf]", vm_value_to_float(dyn));
                             break;
                         case VM_TYPE_FUNC:
-                            fprintf(state->debug_print_instrs, "[any func %p]", vm_value_to_block(dyn));
+                            fprintf(state->debug_print_instrs, "[any func %p]", (void *)vm_value_to_block(dyn));
                             break;
                         case VM_TYPE_ARRAY:
                             fprintf(state->debug_print_instrs, "[any array %p]", (void *)vm_value_to_array(dyn));
@@ -1545,15 +4008,15 @@ do_debug_print_instrs : {
                     break;
                 }
                 case 'L': {
-                    fprintf(state->debug_print_instrs, "[const func %p]", vm_int_run_read().block);
+                    fprintf(state->debug_print_instrs, "[const func %p]", (void *)vm_int_run_read_wide().block);
                     break;
                 }
                 case 'T': {
-                    fprintf(state->debug_print_instrs, "[const block %p]", vm_int_run_read().ptr);
+                    fprintf(state->debug_print_instrs, "[const block %p]", vm_int_run_read_wide().ptr);
                     break;
                 }
                 case 'F': {
-                    fprintf(state->debug_print_instrs, "[const float %lf]", vm_int_run_read().fval);
+                    fprintf(state->debug_print_instrs, "[const float %lf]", vm_int_run_read_wide().fval);
                     break;
                 }
                 case 'N': {
@@ -1565,7 +4028,7 @@ do_debug_print_instrs : {
                     break;
                 }
                 case ':': {
-                    fprintf(state->debug_print_instrs, "-> r%zu", vm_int_run_read().reg);
+                    fprintf(state->debug_print_instrs, "-> r%zu", (size_t)vm_int_run_read().reg);
                     break;
                 }
                 default: {
@@ -1579,21 +4042,21 @@ do_debug_print_instrs : {
         fflush(state->debug_print_instrs);
     }
     head = head0;
-    head += 1;
+    head += VM_INT_WIDE;
     if (state->use_spall) {
-        if (VM_INT_OP_CALL_C0 <= opcode && opcode <= VM_INT_OP_CALL_C7) {
+        if (VM_INT_OP_CALL_C0 <= opcode && opcode <= VM_INT_OP_CALL_CN) {
             vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "call/c");
         }
-        // if (VM_INT_OP_CALL_X0 <= opcode && opcode <= VM_INT_OP_CALL_X8) {
+        // if (VM_INT_OP_CALL_X0 <= opcode && opcode <= VM_INT_OP_CALL_XN) {
         //     vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "call/x");
         // }
-        if (VM_INT_OP_CALL_L0 <= opcode && opcode <= VM_INT_OP_CALL_L8) {
+        if (VM_INT_OP_CALL_L0 <= opcode && opcode <= VM_INT_OP_CALL_LN) {
             vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "call/l");
         }
-        if (VM_INT_OP_CALL_R0 <= opcode && opcode <= VM_INT_OP_CALL_R8) {
+        if (VM_INT_OP_CALL_R0 <= opcode && opcode <= VM_INT_OP_CALL_RN) {
             vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "call/r");
         }
-        // if (VM_INT_OP_CALL_T0 <= opcode && opcode <= VM_INT_OP_CALL_T8) {
+        // if (VM_INT_OP_CALL_T0 <= opcode && opcode <= VM_INT_OP_CALL_TN) {
         //     vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "call/t");
         // }
         if (VM_OPCODE_EXIT == opcode) {
@@ -1610,7 +4073,7 @@ do_debug_print_instrs : {
         const char *fmt = vm_int_debug_instr_format(opcode);
         switch (*fmt) {
             case ':': {
-                name += snprintf(name, 48, "r%zu <- ", vm_int_run_read().reg);
+                name += snprintf(name, 48, "r%zu <- ", (size_t)vm_int_run_read().reg);
                 fmt += 1;
                 break;
             }
@@ -1694,7 +4157,7 @@ do_debug_print_instrs : {
                     break;
                 }
                 case 'F': {
-                    name += snprintf(name, 48, "%lf", vm_int_run_read().fval);
+                    name += snprintf(name, 48, "%lf", vm_int_run_read_wide().fval);
                     break;
                 }
                 default: {
@@ -1711,1634 +4174,1813 @@ do_debug_print_instrs : {
     head = head0;
     vm_int_run_next();
 }
+// counting, see vm_int_counts_init
+vm_int_run_op(count) {
+    state->op_counts[vm_int_run_read().reg] += 1;
+    vm_int_run_next();
+}
+vm_int_run_op(count_block) {
+    state->block_counts[vm_int_run_read().reg] += 1;
+    vm_int_run_next();
+}
+vm_int_run_op(sample) {
+    state->sample_head = head;
+    state->sample_heads = heads;
+    vm_int_run_next();
+}
 // movs
-do_mov_v : {
+vm_int_run_op(mov_v) {
     vm_value_t *out = vm_int_run_read_store();
     *out = vm_value_nil();
     vm_int_run_next();
 }
-do_mov_b : {
+vm_int_run_op(mov_b) {
     vm_value_t *out = vm_int_run_read_store();
     bool value = vm_int_run_read().bval;
     *out = vm_value_from_bool(value);
     vm_int_run_next();
 }
-do_mov_i : {
+vm_int_run_op(mov_i) {
     vm_value_t *out = vm_int_run_read_store();
     vm_int_t value = vm_int_run_read().ival;
     *out = vm_value_from_int(value);
     vm_int_run_next();
 }
-do_mov_f : {
+vm_int_run_op(mov_f) {
     vm_value_t *out = vm_int_run_read_store();
-    vm_number_t value = vm_int_run_read().fval;
+    vm_number_t value = vm_int_run_read_wide().fval;
     *out = vm_value_from_float(value);
     vm_int_run_next();
 }
-do_mov_r : {
+vm_int_run_op(mov_r) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t value = vm_int_run_read_load();
     *out = value;
     vm_int_run_next();
 }
-do_mov_t : {
+vm_int_run_op(mov_t) {
     vm_value_t *out = vm_int_run_read_store();
-    vm_ir_block_t *cblock = vm_int_run_read().block;
+    vm_ir_block_t *cblock = vm_int_run_read_wide().block;
     *out = vm_value_from_block(cblock);
     vm_int_run_next();
 }
-do_fmov_r : {
+vm_int_run_op(fmov_r) {
     vm_value_t *out = vm_int_run_read_store();
     *out = vm_value_from_float((vm_number_t)vm_value_to_int(*out));
     vm_int_run_next();
 }
-do_imov_r : {
+vm_int_run_op(imov_r) {
     vm_value_t *out = vm_int_run_read_store();
     *out = vm_value_from_int((vm_int_t)vm_value_to_float(*out));
     vm_int_run_next();
 }
-do_dynbeq_rrll : {
+vm_int_run_op(dynbeq_rrll) {
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     if (vm_gc_eq(lhs, rhs)) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
     vm_int_run_next();
 }
-do_dynbeq_rrtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32beq_rrll;
+vm_int_run_op(dynbeq_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32beq_rrll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
 // int ops
-do_i32bor_rr : {
+vm_int_run_op(i32bor_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(vm_value_to_int(lhs) | vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32bor_ri : {
+vm_int_run_op(i32bor_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
     *out = vm_value_from_int(vm_value_to_int(lhs) | rhs);
     vm_int_run_next();
 }
-do_i32band_rr : {
+vm_int_run_op(i32band_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(vm_value_to_int(lhs) & vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32band_ri : {
+vm_int_run_op(i32band_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
     *out = vm_value_from_int(vm_value_to_int(lhs) & rhs);
     vm_int_run_next();
 }
-do_i32bxor_rr : {
+vm_int_run_op(i32bxor_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(vm_value_to_int(lhs) ^ vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32bxor_ri : {
+vm_int_run_op(i32bxor_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
     *out = vm_value_from_int(vm_value_to_int(lhs) ^ rhs);
     vm_int_run_next();
 }
-do_i32bshl_rr : {
+vm_int_run_op(i32bshl_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(vm_value_to_int(lhs) << vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32bshl_ri : {
+vm_int_run_op(i32bshl_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
     *out = vm_value_from_int(vm_value_to_int(lhs) << rhs);
     vm_int_run_next();
 }
-do_i32bshr_rr : {
+vm_int_run_op(i32bshr_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(vm_value_to_int(lhs) >> vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32bshr_ri : {
+vm_int_run_op(i32bshr_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
     *out = vm_value_from_int(vm_value_to_int(lhs) >> rhs);
     vm_int_run_next();
 }
-do_i32add_rr : {
+vm_int_run_op(i32add_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
-    *out = vm_value_from_int(vm_value_to_int(lhs) + vm_value_to_int(rhs));
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), vm_value_to_int(rhs), __builtin_add_overflow, +);
     vm_int_run_next();
 }
-do_i32add_ri : {
+vm_int_run_op(i32add_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
-    *out = vm_value_from_int(vm_value_to_int(lhs) + rhs);
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_add_overflow, +);
     vm_int_run_next();
 }
-do_i32sub_rr : {
+vm_int_run_op(i32sub_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
-    *out = vm_value_from_int(vm_value_to_int(lhs) - vm_value_to_int(rhs));
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), vm_value_to_int(rhs), __builtin_sub_overflow, -);
     vm_int_run_next();
 }
-do_i32sub_ri : {
+vm_int_run_op(i32sub_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
-    *out = vm_value_from_int(vm_value_to_int(lhs) - rhs);
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_sub_overflow, -);
     vm_int_run_next();
 }
-do_i32sub_ir : {
+vm_int_run_op(i32sub_ir) {
     vm_value_t *out = vm_int_run_read_store();
     vm_int_t lhs = vm_int_run_read().ival;
     vm_value_t rhs = vm_int_run_read_load();
-    *out = vm_value_from_int(lhs - vm_value_to_int(rhs));
+    vm_int_run_i32_checked(out, lhs, vm_value_to_int(rhs), __builtin_sub_overflow, -);
     vm_int_run_next();
 }
-do_i32mul_rr : {
+vm_int_run_op(i32mul_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
-    *out = vm_value_from_int(vm_value_to_int(lhs) * vm_value_to_int(rhs));
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), vm_value_to_int(rhs), __builtin_mul_overflow, *);
     vm_int_run_next();
 }
-do_i32mul_ri : {
+vm_int_run_op(i32mul_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
-    *out = vm_value_from_int(vm_value_to_int(lhs) * rhs);
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_mul_overflow, *);
     vm_int_run_next();
 }
-do_i32div_rr : {
+vm_int_run_op(i32div_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_int_t lhs = vm_value_to_int(vm_int_run_read_load());
     vm_int_t rhs = vm_value_to_int(vm_int_run_read_load());
     if (lhs % rhs == 0) {
         *out = vm_value_from_int(lhs / rhs);
-        if (head[1].ptr == NULL) {
-            head = head[1].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+        if (vm_int_wide(head)[1].ptr == NULL) {
+            head = vm_int_wide(head)[1].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
         } else {
-            head = head[1].ptr;
+            head = vm_int_wide(head)[1].ptr;
         }
     } else {
         *out = vm_value_from_float((double)lhs / (double)rhs);
-        if (head[2].ptr == NULL) {
-            head = head[2].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+        if (vm_int_wide(head)[2].ptr == NULL) {
+            head = vm_int_wide(head)[2].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
         } else {
-            head = head[2].ptr;
+            head = vm_int_wide(head)[2].ptr;
         }
     }
     vm_int_run_next();
 }
-do_i32div_ri : {
+vm_int_run_op(i32div_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_int_t lhs = vm_value_to_int(vm_int_run_read_load());
     vm_int_t rhs = vm_int_run_read().ival;
     if (lhs % rhs == 0) {
         *out = vm_value_from_int(lhs / rhs);
-        if (head[1].ptr == NULL) {
-            head = head[1].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+        if (vm_int_wide(head)[1].ptr == NULL) {
+            head = vm_int_wide(head)[1].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
         } else {
-            head = head[1].ptr;
+            head = vm_int_wide(head)[1].ptr;
         }
     } else {
         *out = vm_value_from_float((double)lhs / (double)rhs);
-        if (head[2].ptr == NULL) {
-            head = head[2].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+        if (vm_int_wide(head)[2].ptr == NULL) {
+            head = vm_int_wide(head)[2].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
         } else {
-            head = head[2].ptr;
+            head = vm_int_wide(head)[2].ptr;
         }
     }
     vm_int_run_next();
 }
-do_i32div_ir : {
+vm_int_run_op(i32div_ir) {
     vm_value_t *out = vm_int_run_read_store();
     vm_int_t lhs = vm_int_run_read().ival;
     vm_int_t rhs = vm_value_to_int(vm_int_run_read_load());
     if (lhs % rhs == 0) {
         *out = vm_value_from_int(lhs / rhs);
-        if (head[1].ptr == NULL) {
-            head = head[1].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+        if (vm_int_wide(head)[1].ptr == NULL) {
+            head = vm_int_wide(head)[1].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
         } else {
-            head = head[1].ptr;
+            head = vm_int_wide(head)[1].ptr;
         }
     } else {
         *out = vm_value_from_float((double)lhs / (double)rhs);
-        if (head[2].ptr == NULL) {
-            head = head[2].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+        if (vm_int_wide(head)[2].ptr == NULL) {
+            head = vm_int_wide(head)[2].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
         } else {
-            head = head[2].ptr;
+            head = vm_int_wide(head)[2].ptr;
         }
     }
     vm_int_run_next();
 }
-do_i32mod_rr : {
+vm_int_run_op(i32mod_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(vm_value_to_int(lhs) % vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32mod_ri : {
+vm_int_run_op(i32mod_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_int_t rhs = vm_int_run_read().ival;
     *out = vm_value_from_int(vm_value_to_int(lhs) % rhs);
     vm_int_run_next();
 }
-do_i32mod_ir : {
+vm_int_run_op(i32mod_ir) {
     vm_value_t *out = vm_int_run_read_store();
     vm_int_t lhs = vm_int_run_read().ival;
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_int(lhs % vm_value_to_int(rhs));
     vm_int_run_next();
 }
-do_i32blt_rrll : {
+vm_int_run_op(i32blt_rrll) {
     vm_int_t lhs = vm_value_to_int(vm_int_run_read_load());
     vm_int_t rhs = vm_value_to_int(vm_int_run_read_load());
     if (lhs < rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_i32blt_rill : {
+vm_int_run_op(i32blt_rill) {
     vm_int_t lhs = vm_value_to_int(vm_int_run_read_load());
     vm_int_t rhs = vm_int_run_read().ival;
     if (lhs < rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_i32blt_irll : {
+vm_int_run_op(i32blt_irll) {
     vm_int_t lhs = vm_int_run_read().ival;
     vm_int_t rhs = vm_value_to_int(vm_int_run_read_load());
     if (lhs < rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_i32beq_rrll : {
+vm_int_run_op(i32beq_rrll) {
     vm_int_t lhs = vm_value_to_int(vm_int_run_read_load());
     vm_int_t rhs = vm_value_to_int(vm_int_run_read_load());
     if (lhs == rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_i32beq_rill : {
+vm_int_run_op(i32beq_rill) {
     vm_int_t lhs = vm_value_to_int(vm_int_run_read_load());
     vm_int_t rhs = vm_int_run_read().ival;
     if (lhs == rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_i32beq_irll : {
+vm_int_run_op(i32beq_irll) {
     vm_int_t lhs = vm_int_run_read().ival;
     vm_int_t rhs = vm_value_to_int(vm_int_run_read_load());
     if (lhs == rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_i32blt_rrtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32blt_rrll;
+vm_int_run_op(i32blt_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32blt_rrll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_i32blt_ritt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32blt_rill;
+vm_int_run_op(i32blt_ritt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32blt_rill);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_i32blt_irtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32blt_irll;
+vm_int_run_op(i32blt_irtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32blt_irll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_i32beq_rrtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32beq_rrll;
+vm_int_run_op(i32beq_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32beq_rrll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_i32beq_ritt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32beq_rill;
+vm_int_run_op(i32beq_ritt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32beq_rill);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_i32beq_irtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_i32beq_irll;
+vm_int_run_op(i32beq_irtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32beq_irll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
 
 // float ops
-do_fadd_rr : {
+vm_int_run_op(fadd_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(vm_value_to_float(lhs) + vm_value_to_float(rhs));
     vm_int_run_next();
 }
-do_fadd_rf : {
+vm_int_run_op(fadd_rf) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     *out = vm_value_from_float(vm_value_to_float(lhs) + rhs);
     vm_int_run_next();
 }
-do_fsub_rr : {
+vm_int_run_op(fsub_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(vm_value_to_float(lhs) - vm_value_to_float(rhs));
     vm_int_run_next();
 }
-do_fsub_rf : {
+vm_int_run_op(fsub_rf) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     *out = vm_value_from_float(vm_value_to_float(lhs) - rhs);
     vm_int_run_next();
 }
-do_fsub_fr : {
+vm_int_run_op(fsub_fr) {
     vm_value_t *out = vm_int_run_read_store();
-    vm_number_t lhs = vm_int_run_read().fval;
+    vm_number_t lhs = vm_int_run_read_wide().fval;
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(lhs - vm_value_to_float(rhs));
     vm_int_run_next();
 }
-do_fmul_rr : {
+vm_int_run_op(fmul_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(vm_value_to_float(lhs) * vm_value_to_float(rhs));
     vm_int_run_next();
 }
-do_fmul_rf : {
+vm_int_run_op(fmul_rf) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     *out = vm_value_from_float(vm_value_to_float(lhs) * rhs);
     vm_int_run_next();
 }
-do_fdiv_rr : {
+vm_int_run_op(fdiv_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(vm_value_to_float(lhs) / vm_value_to_float(rhs));
     vm_int_run_next();
 }
-do_fdiv_rf : {
+vm_int_run_op(fdiv_rf) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     *out = vm_value_from_float(vm_value_to_float(lhs) / rhs);
     vm_int_run_next();
 }
-do_fdiv_fr : {
+vm_int_run_op(fdiv_fr) {
     vm_value_t *out = vm_int_run_read_store();
-    vm_number_t lhs = vm_int_run_read().fval;
+    vm_number_t lhs = vm_int_run_read_wide().fval;
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(lhs / vm_value_to_float(rhs));
     vm_int_run_next();
 }
-do_fmod_rr : {
+vm_int_run_op(fmod_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(fmod(vm_value_to_float(lhs), vm_value_to_float(rhs)));
     vm_int_run_next();
 }
-do_fmod_rf : {
+vm_int_run_op(fmod_rf) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t lhs = vm_int_run_read_load();
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     *out = vm_value_from_float(fmod(vm_value_to_float(lhs), rhs));
     vm_int_run_next();
 }
-do_fmod_fr : {
+vm_int_run_op(fmod_fr) {
     vm_value_t *out = vm_int_run_read_store();
-    vm_number_t lhs = vm_int_run_read().fval;
+    vm_number_t lhs = vm_int_run_read_wide().fval;
     vm_value_t rhs = vm_int_run_read_load();
     *out = vm_value_from_float(fmod(lhs, vm_value_to_float(rhs)));
     vm_int_run_next();
 }
-do_fblt_rrll : {
+vm_int_run_op(fblt_rrll) {
     vm_number_t lhs = vm_value_to_float(vm_int_run_read_load());
     vm_number_t rhs = vm_value_to_float(vm_int_run_read_load());
     if (lhs < rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_fblt_rfll : {
+vm_int_run_op(fblt_rfll) {
     vm_number_t lhs = vm_value_to_float(vm_int_run_read_load());
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     if (lhs < rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_fblt_frll : {
-    vm_number_t lhs = vm_int_run_read().fval;
+vm_int_run_op(fblt_frll) {
+    vm_number_t lhs = vm_int_run_read_wide().fval;
     vm_number_t rhs = vm_value_to_float(vm_int_run_read_load());
     if (lhs < rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_fbeq_rrll : {
+vm_int_run_op(fbeq_rrll) {
     vm_number_t lhs = vm_value_to_float(vm_int_run_read_load());
     vm_number_t rhs = vm_value_to_float(vm_int_run_read_load());
     if (lhs == rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_fbeq_rfll : {
+vm_int_run_op(fbeq_rfll) {
     vm_number_t lhs = vm_value_to_float(vm_int_run_read_load());
-    vm_number_t rhs = vm_int_run_read().fval;
+    vm_number_t rhs = vm_int_run_read_wide().fval;
     if (lhs == rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_fbeq_frll : {
-    vm_number_t lhs = vm_int_run_read().fval;
+vm_int_run_op(fbeq_frll) {
+    vm_number_t lhs = vm_int_run_read_wide().fval;
     vm_number_t rhs = vm_value_to_float(vm_int_run_read_load());
     if (lhs == rhs) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-do_fblt_rrtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_fblt_rrll;
+vm_int_run_op(fblt_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(fblt_rrll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_fblt_rftt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_fblt_rfll;
-    head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+vm_int_run_op(fblt_rftt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(fblt_rfll);
+    head += 1 + VM_INT_WIDE;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_fblt_frtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_fblt_frll;
-    head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+vm_int_run_op(fblt_frtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(fblt_frll);
+    head += 1 + VM_INT_WIDE;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_fbeq_rrtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_fbeq_rrll;
+vm_int_run_op(fbeq_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(fbeq_rrll);
     head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_fbeq_rftt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_fbeq_rfll;
-    head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+vm_int_run_op(fbeq_rftt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(fbeq_rfll);
+    head += 1 + VM_INT_WIDE;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_fbeq_frtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_fbeq_frll;
-    head += 2;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+vm_int_run_op(fbeq_frtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(fbeq_frll);
+    head += 1 + VM_INT_WIDE;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
 // other
-do_bb_rll : {
+vm_int_run_op(bb_rll) {
     vm_value_t value = vm_int_run_read_load();
     if (vm_value_to_bool(value)) {
-        head = head[1].ptr;
+        head = vm_int_wide(head)[1].ptr;
     } else {
-        head = head[0].ptr;
+        head = vm_int_wide(head)[0].ptr;
     }
     vm_int_run_next();
 }
-// calls
-do_call_l0 : {
-    void *ptr = vm_int_run_read().ptr;
-    *heads++ = head;
-    locals += framesize;
+// calls, past the fixed counts the count is read first and the args
+// are staged in one pass, leaving the head on the frame size
+#define vm_int_run_call_args(fsize_, first_)                                \
+    do {                                                                    \
+        size_t nargs__ = (size_t)vm_int_run_read().ival;                    \
+        (fsize_) = head[nargs__].reg;                                       \
+        vm_value_t *to__ = &locals[(fsize_) + 1 + (first_)];                \
+        for (size_t i = 0; i < nargs__; i++) {                              \
+            to__[i] = locals[head[i].reg];                                  \
+        }                                                                   \
+        head += nargs__;                                                    \
+    } while (0)
+vm_int_run_op(call_l0) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[0].reg;
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l1 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l1) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[1].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l2 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l2) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[2].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l3 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l3) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[3].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l4 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l4) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[4].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l5 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l5) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[5].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l6 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l6) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[6].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l7 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l7) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[7].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_l8 : {
-    void *ptr = vm_int_run_read().ptr;
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals[framesize + 1 + 7] = vm_int_run_read_load();
-    *heads++ = head;
-    locals += framesize;
+vm_int_run_op(call_l8) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize = head[8].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    locals[fsize + 1 + 7] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = ptr;
+    vm_int_run_next();
+}
+vm_int_run_op(call_ln) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    size_t fsize;
+    vm_int_run_call_args(fsize, 0);
+    vm_int_run_enter(fsize);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r0 : {
+vm_int_run_op(call_r0) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[0].reg;
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r1 : {
+vm_int_run_op(call_r1) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[1].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r2 : {
+vm_int_run_op(call_r2) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[2].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r3 : {
+vm_int_run_op(call_r3) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[3].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r4 : {
+vm_int_run_op(call_r4) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[4].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r5 : {
+vm_int_run_op(call_r5) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[5].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r6 : {
+vm_int_run_op(call_r6) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[6].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r7 : {
+vm_int_run_op(call_r7) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[7].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_r8 : {
+vm_int_run_op(call_r8) {
     vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals[framesize + 1 + 7] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    size_t fsize = head[8].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    locals[fsize + 1 + 7] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
+    head = ptr;
+    vm_int_run_next();
+}
+vm_int_run_op(call_rn) {
+    vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
+    size_t fsize;
+    vm_int_run_call_args(fsize, 0);
+    vm_int_run_enter(fsize);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
 // extern
-do_call_x_check : {
+vm_int_run_op(call_x_check) {
     vm_value_t data = vm_int_run_read_load();
     uint8_t type = vm_typeof(data);
-    if (head[type].ptr == NULL) {
-        head[type].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+    if (vm_int_wide(head)[type].ptr == NULL) {
+        vm_int_wide(head)[type].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
     }
     switch (type) {
         case VM_TYPE_UNSET:
             __builtin_trap();
         case VM_TYPE_NIL:
-            head = head[VM_TYPE_NIL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_NIL].ptr;
             vm_int_run_next();
         case VM_TYPE_BOOL:
-            head = head[VM_TYPE_BOOL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_BOOL].ptr;
             vm_int_run_next();
         case VM_TYPE_I32:
-            head = head[VM_TYPE_I32].ptr;
+            head = vm_int_wide(head)[VM_TYPE_I32].ptr;
             vm_int_run_next();
         case VM_TYPE_F64:
-            head = head[VM_TYPE_F64].ptr;
+            head = vm_int_wide(head)[VM_TYPE_F64].ptr;
             vm_int_run_next();
         case VM_TYPE_FUNC:
-            head = head[VM_TYPE_FUNC].ptr;
+            head = vm_int_wide(head)[VM_TYPE_FUNC].ptr;
             vm_int_run_next();
         case VM_TYPE_ARRAY:
-            head = head[VM_TYPE_ARRAY].ptr;
+            head = vm_int_wide(head)[VM_TYPE_ARRAY].ptr;
             vm_int_run_next();
         case VM_TYPE_TABLE:
-            head = head[VM_TYPE_TABLE].ptr;
+            head = vm_int_wide(head)[VM_TYPE_TABLE].ptr;
             vm_int_run_next();
     }
+    __builtin_unreachable();
 }
-do_call_x0 : {
+vm_int_run_op(call_x0) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
     vm_value_t *out = &locals[head->reg];
     locals += framesize;
     *out = ptr.func(ptr.data, vm_int_run_save(), 0, NULL);
     locals -= framesize;
-    goto do_call_x_check;
+    vm_int_run_jump(call_x_check);
 }
-do_call_x1 : {
+vm_int_run_op(call_x1) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[1];
-    values[0] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 1;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 1, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 1, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x2 : {
+vm_int_run_op(call_x2) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[2];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 2;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 2, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 2, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x3 : {
+vm_int_run_op(call_x3) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[3];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
-    values[2] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 3;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 3, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 3, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x4 : {
+vm_int_run_op(call_x4) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[4];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
-    values[2] = vm_int_run_read_load();
-    values[3] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 4;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 4, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 4, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x5 : {
+vm_int_run_op(call_x5) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[5];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
-    values[2] = vm_int_run_read_load();
-    values[3] = vm_int_run_read_load();
-    values[4] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 5;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 5, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 5, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x6 : {
+vm_int_run_op(call_x6) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[6];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
-    values[2] = vm_int_run_read_load();
-    values[3] = vm_int_run_read_load();
-    values[4] = vm_int_run_read_load();
-    values[5] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 6;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 6, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 6, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x7 : {
+vm_int_run_op(call_x7) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[7];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
-    values[2] = vm_int_run_read_load();
-    values[3] = vm_int_run_read_load();
-    values[4] = vm_int_run_read_load();
-    values[5] = vm_int_run_read_load();
-    values[6] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 7;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 7, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 7, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_x8 : {
+vm_int_run_op(call_x8) {
     vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
-    vm_value_t values[8];
-    values[0] = vm_int_run_read_load();
-    values[1] = vm_int_run_read_load();
-    values[2] = vm_int_run_read_load();
-    values[3] = vm_int_run_read_load();
-    values[4] = vm_int_run_read_load();
-    values[5] = vm_int_run_read_load();
-    values[6] = vm_int_run_read_load();
-    values[7] = vm_int_run_read_load();
+    vm_int_opcode_t *args = head;
+    head += 8;
     vm_value_t *out = &locals[head->reg];
-    locals += framesize;
-    *out = ptr.func(ptr.data, vm_int_run_save(), 8, &values[0]);
-    locals -= framesize;
-    goto do_call_x_check;
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, 8, args);
+    vm_int_run_jump(call_x_check);
 }
-do_call_c0 : {
+vm_int_run_op(call_xn) {
+    vm_int_func_t ptr = state->funcs[vm_int_run_read().ival];
+    size_t nargs = (size_t)vm_int_run_read().ival;
+    vm_int_opcode_t *args = head;
+    head += nargs;
+    vm_value_t *out = &locals[head->reg];
+    *out = vm_int_run_extern(vm_int_run_save(), ptr, nargs, args);
+    vm_int_run_jump(call_x_check);
+}
+vm_int_run_op(call_c0) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[0].reg;
+    locals[fsize + 1 + 0] = obj;
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c1 : {
+vm_int_run_op(call_c1) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[1].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c2 : {
+vm_int_run_op(call_c2) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[2].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c3 : {
+vm_int_run_op(call_c3) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[3].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c4 : {
+vm_int_run_op(call_c4) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[4].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c5 : {
+vm_int_run_op(call_c5) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[5].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c6 : {
+vm_int_run_op(call_c6) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[6].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
-do_call_c7 : {
+vm_int_run_op(call_c7) {
     vm_value_t obj = vm_int_run_read_load();
-    locals[framesize + 1 + 0] = obj;
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals[framesize + 1 + 7] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
+    size_t fsize = head[7].reg;
+    locals[fsize + 1 + 0] = obj;
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    locals[fsize + 1 + 7] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
+    void *ptr = vm_int_run_comp(func);
+    head = ptr;
+    vm_int_run_next();
+}
+vm_int_run_op(call_cn) {
+    vm_value_t obj = vm_int_run_read_load();
+    size_t fsize;
+    vm_int_run_call_args(fsize, 1);
+    locals[fsize + 1 + 0] = obj;
+    vm_int_run_enter(fsize);
     vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
-    void *ptr = vm_int_block_comp(vm_int_run_save(), ptrs, func);
+    void *ptr = vm_int_run_comp(func);
     head = ptr;
     vm_int_run_next();
 }
 // memorys
-do_arr_f : {
+vm_int_run_op(arr_f) {
     vm_value_t *out = vm_int_run_read_store();
-    double len = vm_int_run_read().fval;
+    double len = vm_int_run_read_wide().fval;
+    size_t fsize = vm_int_run_read().reg;
     if (state->use_spall) {
         vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "gc");
     }
-    vm_gc_run(&state->gc, locals + state->framesize);
+    vm_gc_run(&state->gc, locals + fsize);
     if (state->use_spall) {
         vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
     }
     *out = vm_gc_arr(&state->gc, (vm_int_t)len);
     vm_int_run_next();
 }
-do_arr_r : {
+vm_int_run_op(arr_r) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t len = vm_int_run_read_load();
+    size_t fsize = vm_int_run_read().reg;
     if (state->use_spall) {
         vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "gc");
     }
-    vm_gc_run(&state->gc, locals + state->framesize);
+    vm_gc_run(&state->gc, locals + fsize);
     if (state->use_spall) {
         vm_trace_end(&state->spall_ctx, NULL, vm_trace_time());
     }
     *out = vm_gc_arr(&state->gc, (vm_int_t)vm_value_to_float(len));
     vm_int_run_next();
 }
-do_set_rrr : {
+vm_int_run_op(set_rrr) {
     vm_value_t obj = vm_int_run_read_load();
     vm_value_t key = vm_int_run_read_load();
     vm_value_t val = vm_int_run_read_load();
-    vm_gc_set_vv(obj, key, val);
+    vm_gc_set_vv(&state->gc, obj, key, val);
     vm_int_run_next();
 }
-do_set_rri : {
+vm_int_run_op(set_rri) {
     vm_value_t obj = vm_int_run_read_load();
     vm_value_t key = vm_int_run_read_load();
-    double val = vm_int_run_read().fval;
-    vm_gc_set_vi(obj, key, (double)val);
+    double val = vm_int_run_read_wide().fval;
+    vm_gc_set_vi(&state->gc, obj, key, (double)val);
     vm_int_run_next();
 }
-do_set_rir : {
+vm_int_run_op(set_rir) {
     vm_value_t obj = vm_int_run_read_load();
-    double key = vm_int_run_read().fval;
+    double key = vm_int_run_read_wide().fval;
     vm_value_t val = vm_int_run_read_load();
-    vm_gc_set_iv(obj, (double)key, val);
+    vm_gc_set_iv(&state->gc, obj, (double)key, val);
     vm_int_run_next();
 }
-do_set_rii : {
+vm_int_run_op(set_rii) {
     vm_value_t obj = vm_int_run_read_load();
-    double key = vm_int_run_read().fval;
-    double val = vm_int_run_read().fval;
-    vm_gc_set_ii(obj, (double)key, (double)val);
+    double key = vm_int_run_read_wide().fval;
+    double val = vm_int_run_read_wide().fval;
+    vm_gc_set_ii(&state->gc, obj, (double)key, (double)val);
     vm_int_run_next();
 }
-do_get_rr : {
+vm_int_run_op(get_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t obj = vm_int_run_read_load();
     vm_value_t key = vm_int_run_read_load();
     vm_value_t data = vm_gc_get_v(obj, key);
     *out = data;
     uint8_t type = vm_typeof(data);
-    if (head[type].ptr == NULL) {
-        head[type].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+    if (vm_int_wide(head)[type].ptr == NULL) {
+        vm_int_wide(head)[type].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
     }
     switch (type) {
         case VM_TYPE_UNSET:
             __builtin_trap();
         case VM_TYPE_NIL:
-            head = head[VM_TYPE_NIL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_NIL].ptr;
             vm_int_run_next();
         case VM_TYPE_BOOL:
-            head = head[VM_TYPE_BOOL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_BOOL].ptr;
             vm_int_run_next();
         case VM_TYPE_I32:
-            head = head[VM_TYPE_I32].ptr;
+            head = vm_int_wide(head)[VM_TYPE_I32].ptr;
             vm_int_run_next();
         case VM_TYPE_F64:
-            head = head[VM_TYPE_F64].ptr;
+            head = vm_int_wide(head)[VM_TYPE_F64].ptr;
             vm_int_run_next();
         case VM_TYPE_FUNC:
-            head = head[VM_TYPE_FUNC].ptr;
+            head = vm_int_wide(head)[VM_TYPE_FUNC].ptr;
             vm_int_run_next();
         case VM_TYPE_ARRAY:
-            head = head[VM_TYPE_ARRAY].ptr;
+            head = vm_int_wide(head)[VM_TYPE_ARRAY].ptr;
             vm_int_run_next();
         case VM_TYPE_TABLE:
-            head = head[VM_TYPE_TABLE].ptr;
+            head = vm_int_wide(head)[VM_TYPE_TABLE].ptr;
             vm_int_run_next();
     }
     __builtin_unreachable();
 }
-do_get_ri : {
+vm_int_run_op(get_ri) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t obj = vm_int_run_read_load();
-    double key = vm_int_run_read().fval;
+    double key = vm_int_run_read_wide().fval;
     vm_value_t data = vm_gc_get_i(obj, (double)key);
     *out = data;
     uint8_t type = vm_typeof(data);
-    if (head[type].ptr == NULL) {
-        head[type].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+    if (vm_int_wide(head)[type].ptr == NULL) {
+        vm_int_wide(head)[type].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
     }
     switch (type) {
         case VM_TYPE_UNSET:
             __builtin_trap();
         case VM_TYPE_NIL:
-            head = head[VM_TYPE_NIL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_NIL].ptr;
             vm_int_run_next();
         case VM_TYPE_BOOL:
-            head = head[VM_TYPE_BOOL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_BOOL].ptr;
             vm_int_run_next();
         case VM_TYPE_I32:
-            head = head[VM_TYPE_I32].ptr;
+            head = vm_int_wide(head)[VM_TYPE_I32].ptr;
             vm_int_run_next();
         case VM_TYPE_F64:
-            head = head[VM_TYPE_F64].ptr;
+            head = vm_int_wide(head)[VM_TYPE_F64].ptr;
             vm_int_run_next();
         case VM_TYPE_FUNC:
-            head = head[VM_TYPE_FUNC].ptr;
+            head = vm_int_wide(head)[VM_TYPE_FUNC].ptr;
             vm_int_run_next();
         case VM_TYPE_ARRAY:
-            head = head[VM_TYPE_ARRAY].ptr;
+            head = vm_int_wide(head)[VM_TYPE_ARRAY].ptr;
             vm_int_run_next();
         case VM_TYPE_TABLE:
-            head = head[VM_TYPE_TABLE].ptr;
+            head = vm_int_wide(head)[VM_TYPE_TABLE].ptr;
             vm_int_run_next();
     }
     __builtin_unreachable();
 }
-do_len_r : {
+vm_int_run_op(len_r) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t obj = vm_int_run_read_load();
     *out = vm_value_from_int(vm_gc_len(obj));
     vm_int_run_next();
 }
 // io
-do_in_v : {
+vm_int_run_op(in_v) {
     vm_value_t *out = vm_int_run_read_store();
     *out = vm_value_from_int((int)fgetc(stdin));
     vm_int_run_next();
 }
-do_out_i : {
+vm_int_run_op(out_i) {
     fprintf(stdout, "%c", (int)vm_int_run_read().ival);
     vm_int_run_next();
 }
-do_out_r : {
+vm_int_run_op(out_r) {
     fprintf(stdout, "%c", (int)vm_value_to_float(vm_int_run_read_load()));
     vm_int_run_next();
 }
 // jump compiled
-do_jump_l : {
-    head = head->ptr;
+vm_int_run_op(jump_l) {
+    head = vm_int_wide(head)->ptr;
     vm_int_run_next();
 }
 // float branch compiled
 // ret
-do_ret_i : {
+vm_int_run_op(ret_i) {
     vm_value_t value = vm_value_from_int(vm_int_run_read().ival);
     head = *--heads;
-    locals -= framesize;
+    locals -= vm_int_run_read().reg;
     vm_int_opcode_t out = vm_int_run_read();
     locals[out.reg] = value;
-    void *pblock = head[VM_TYPE_I32].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_I32].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_I32);
     vm_int_run_next();
 }
-do_ret_f : {
-    vm_value_t value = vm_value_from_float(vm_int_run_read().fval);
+vm_int_run_op(ret_f) {
+    vm_value_t value = vm_value_from_float(vm_int_run_read_wide().fval);
     head = *--heads;
-    locals -= framesize;
+    locals -= vm_int_run_read().reg;
     vm_int_opcode_t out = vm_int_run_read();
     locals[out.reg] = value;
-    void *pblock = head[VM_TYPE_F64].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_F64].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_F64);
     vm_int_run_next();
 }
-do_ret_rv : {
-    locals -= framesize;
+vm_int_run_op(ret_rv) {
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = vm_value_nil();
-    void *pblock = head[VM_TYPE_NIL].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_NIL].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_NIL);
     vm_int_run_next();
 }
-do_ret_rb : {
+vm_int_run_op(ret_rb) {
     vm_value_t value = locals[head->reg];
-    locals -= framesize;
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = value;
-    void *pblock = head[VM_TYPE_BOOL].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_BOOL].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_BOOL);
     vm_int_run_next();
 }
-do_ret_ri : {
+vm_int_run_op(ret_ri) {
     vm_value_t value = locals[head->reg];
-    locals -= framesize;
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = value;
-    void *pblock = head[VM_TYPE_I32].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_I32].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_I32);
     vm_int_run_next();
 }
-do_ret_rif : {
+vm_int_run_op(ret_rif) {
     vm_value_t value = locals[head->reg];
-    locals -= framesize;
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = value;
-    void *pblock = head[VM_TYPE_F64].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_F64].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_F64);
     vm_int_run_next();
 }
-do_ret_rf : {
+vm_int_run_op(ret_rf) {
     vm_value_t value = locals[head->reg];
-    locals -= framesize;
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = value;
-    void *pblock = head[VM_TYPE_FUNC].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_FUNC].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_FUNC);
     vm_int_run_next();
 }
-do_ret_ra : {
+vm_int_run_op(ret_ra) {
     vm_value_t value = locals[head->reg];
-    locals -= framesize;
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = value;
-    void *pblock = head[VM_TYPE_ARRAY].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_ARRAY].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_ARRAY);
     vm_int_run_next();
 }
-do_ret_rt : {
+vm_int_run_op(ret_rt) {
     vm_value_t value = locals[head->reg];
-    locals -= framesize;
     head = *--heads;
+    locals -= vm_int_run_read().reg;
     locals[vm_int_run_read().reg] = value;
-    void *pblock = head[VM_TYPE_TABLE].ptr;
-    if (pblock == NULL) {
-        head = head[VM_TYPE_TABLE].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
-    } else {
-        head = pblock;
-    }
+    vm_int_run_ret_link(VM_TYPE_TABLE);
     vm_int_run_next();
 }
-do_exit : {
+vm_int_run_op(exit) {
     return vm_value_nil();
 }
 // jmp/call tmp
-do_call_t0 : {
-    head[-1].ptr = &&do_call_l0;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
+vm_int_run_op(call_t0) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l0);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[0].reg;
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t1) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l1);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[1].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t2) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l2);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[2].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t3) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l3);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[3].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t4) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l4);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[4].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t5) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l5);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[5].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t6) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l6);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[6].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t7) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l7);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[7].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_t8) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_l8);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize = head[8].reg;
+    locals[fsize + 1 + 0] = vm_int_run_read_load();
+    locals[fsize + 1 + 1] = vm_int_run_read_load();
+    locals[fsize + 1 + 2] = vm_int_run_read_load();
+    locals[fsize + 1 + 3] = vm_int_run_read_load();
+    locals[fsize + 1 + 4] = vm_int_run_read_load();
+    locals[fsize + 1 + 5] = vm_int_run_read_load();
+    locals[fsize + 1 + 6] = vm_int_run_read_load();
+    locals[fsize + 1 + 7] = vm_int_run_read_load();
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+vm_int_run_op(call_tn) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(call_ln);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    size_t fsize;
+    vm_int_run_call_args(fsize, 0);
+    vm_int_run_enter(fsize);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
+    vm_int_run_next();
+}
+// tail calls, the args are staged above the frame first since they can
+// read registers that the move into this frame overwrites
+#define vm_int_run_tail_args(first_)                                \
+    do {                                                            \
+        size_t fsize__ = vm_int_run_read().reg;                     \
+        size_t nargs__ = (first_) + (size_t)vm_int_run_read().ival; \
+        for (size_t i = (first_); i < nargs__; i++) {               \
+            locals[fsize__ + 1 + i] = vm_int_run_read_load();       \
+        }                                                           \
+        for (size_t i = (first_); i < nargs__; i++) {               \
+            locals[1 + i] = locals[fsize__ + 1 + i];                \
+        }                                                           \
+    } while (0)
+vm_int_run_op(tcall_l) {
+    void *ptr = vm_int_run_read_wide().ptr;
+    vm_int_run_tail_args(0);
+    head = ptr;
     vm_int_run_next();
 }
-do_call_t1 : {
-    head[-1].ptr = &&do_call_l1;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
+vm_int_run_op(tcall_t) {
+    vm_int_wide(head)[-1].ptr = vm_int_run_label(tcall_l);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    vm_int_run_tail_args(0);
+    head = cblock->ptr = vm_int_run_comp(cblock->block);
     vm_int_run_next();
 }
-do_call_t2 : {
-    head[-1].ptr = &&do_call_l2;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
+vm_int_run_op(tcall_r) {
+    vm_ir_block_t *func = vm_value_to_block(vm_int_run_read_load());
+    vm_int_run_tail_args(0);
+    head = vm_int_run_comp(func);
     vm_int_run_next();
 }
-do_call_t3 : {
-    head[-1].ptr = &&do_call_l3;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
+vm_int_run_op(tcall_c) {
+    vm_value_t obj = vm_int_run_read_load();
+    vm_int_run_tail_args(1);
+    locals[1] = obj;
+    vm_ir_block_t *func = vm_value_to_block(vm_gc_get_i(obj, 0));
+    head = vm_int_run_comp(func);
+    vm_int_run_next();
+}
+// the one version of a block past the cap, a call made from it is entered
+// here and returns to the frame, out and ret slots that follow the block
+vm_int_run_op(generic) {
+    vm_ir_block_t *block = vm_int_run_read_wide().block;
+    size_t fsize = head[0].reg;
+    vm_int_generic_t next = vm_int_generic_run(vm_int_run_save(), block);
+    if (next.kind == VM_INT_GENERIC_CALL) {
+        vm_int_run_enter(fsize);
+        head = vm_int_run_comp(next.block);
+        vm_int_run_next();
+    }
+    if (next.kind == VM_INT_GENERIC_RET) {
+        uint8_t type = vm_typeof(next.value);
+        head = *--heads;
+        locals -= vm_int_run_read().reg;
+        locals[vm_int_run_read().reg] = next.value;
+        vm_int_run_ret_link(type);
+        vm_int_run_next();
+    }
+    if (next.kind == VM_INT_GENERIC_EXIT) {
+        return vm_value_nil();
+    }
+    head = vm_int_run_comp(next.block);
     vm_int_run_next();
 }
-do_call_t4 : {
-    head[-1].ptr = &&do_call_l4;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
-    vm_int_run_next();
-}
-do_call_t5 : {
-    head[-1].ptr = &&do_call_l5;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
-    vm_int_run_next();
-}
-do_call_t6 : {
-    head[-1].ptr = &&do_call_l6;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
-    vm_int_run_next();
-}
-do_call_t7 : {
-    head[-1].ptr = &&do_call_l7;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
-    vm_int_run_next();
-}
-do_call_t8 : {
-    head[-1].ptr = &&do_call_l8;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    locals[framesize + 1 + 0] = vm_int_run_read_load();
-    locals[framesize + 1 + 1] = vm_int_run_read_load();
-    locals[framesize + 1 + 2] = vm_int_run_read_load();
-    locals[framesize + 1 + 3] = vm_int_run_read_load();
-    locals[framesize + 1 + 4] = vm_int_run_read_load();
-    locals[framesize + 1 + 5] = vm_int_run_read_load();
-    locals[framesize + 1 + 6] = vm_int_run_read_load();
-    locals[framesize + 1 + 7] = vm_int_run_read_load();
-    locals += framesize;
-    *heads++ = head;
-    head = cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
+vm_int_run_op(generic_jump) {
+    vm_ir_block_t *next = vm_int_run_read_wide().block;
+    head = vm_int_run_comp(next);
     vm_int_run_next();
 }
-do_jump_t : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_jump_l;
-    vm_int_opcode_t *cblock = &vm_int_run_read();
-    cblock->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, cblock->block);
+vm_int_run_op(jump_t) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(jump_l);
+    vm_int_wide_t *cblock = &vm_int_run_read_wide();
+    cblock->ptr = vm_int_run_comp(cblock->block);
     head = loc;
     vm_int_run_next();
 }
-do_bb_rtt : {
-    vm_int_opcode_t *loc = --head;
-    vm_int_run_read().ptr = &&do_bb_rll;
+vm_int_run_op(bb_rtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(bb_rll);
     head += 1;
-    vm_int_opcode_t *block1 = &vm_int_run_read();
-    vm_int_opcode_t *block2 = &vm_int_run_read();
-    block1->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block1->block);
-    block2->ptr = vm_int_block_comp(vm_int_run_save(), ptrs, block2->block);
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
     head = loc;
     vm_int_run_next();
 }
-do_tab : {
+vm_int_run_op(tab) {
     vm_value_t *out = vm_int_run_read_store();
-    vm_gc_run(&state->gc, locals + state->framesize);
+    size_t fsize = vm_int_run_read().reg;
+    vm_gc_run(&state->gc, locals + fsize);
     *out = vm_gc_tab(&state->gc);
     vm_int_run_next();
 }
-do_tget_rr : {
+vm_int_run_op(tget_rr) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t obj = vm_int_run_read_load();
     vm_value_t ind = vm_int_run_read_load();
     vm_value_t data = vm_gc_table_get(vm_value_to_table(obj), ind);
     *out = data;
     uint8_t type = vm_typeof(data);
-    if (head[type].ptr == NULL) {
-        head[type].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+    if (vm_int_wide(head)[type].ptr == NULL) {
+        vm_int_wide(head)[type].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
     }
     switch (type) {
         case VM_TYPE_UNSET:
-            head = head[VM_TYPE_UNSET].ptr;
+            head = vm_int_wide(head)[VM_TYPE_UNSET].ptr;
             vm_int_run_next();
         case VM_TYPE_NIL:
-            head = head[VM_TYPE_NIL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_NIL].ptr;
             vm_int_run_next();
         case VM_TYPE_BOOL:
-            head = head[VM_TYPE_BOOL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_BOOL].ptr;
             vm_int_run_next();
         case VM_TYPE_I32:
-            head = head[VM_TYPE_I32].ptr;
+            head = vm_int_wide(head)[VM_TYPE_I32].ptr;
             vm_int_run_next();
         case VM_TYPE_F64:
-            head = head[VM_TYPE_F64].ptr;
+            head = vm_int_wide(head)[VM_TYPE_F64].ptr;
             vm_int_run_next();
         case VM_TYPE_FUNC:
-            head = head[VM_TYPE_FUNC].ptr;
+            head = vm_int_wide(head)[VM_TYPE_FUNC].ptr;
             vm_int_run_next();
         case VM_TYPE_ARRAY:
-            head = head[VM_TYPE_ARRAY].ptr;
+            head = vm_int_wide(head)[VM_TYPE_ARRAY].ptr;
             vm_int_run_next();
         case VM_TYPE_TABLE:
-            head = head[VM_TYPE_TABLE].ptr;
+            head = vm_int_wide(head)[VM_TYPE_TABLE].ptr;
             vm_int_run_next();
     }
     __builtin_unreachable();
 }
-do_tget_rf : {
+vm_int_run_op(tget_rf) {
     vm_value_t *out = vm_int_run_read_store();
     vm_value_t obj = vm_int_run_read_load();
-    vm_value_t ind = vm_value_from_float(vm_int_run_read().fval);
+    vm_value_t ind = vm_value_from_float(vm_int_run_read_wide().fval);
     vm_value_t data = vm_gc_table_get(vm_value_to_table(obj), ind);
     *out = data;
     uint8_t type = vm_typeof(data);
-    if (head[type].ptr == NULL) {
-        head[type].ptr = vm_int_block_comp(vm_int_run_save(), ptrs, head[0].block);
+    if (vm_int_wide(head)[type].ptr == NULL) {
+        vm_int_wide(head)[type].ptr = vm_int_run_comp(vm_int_wide(head)[0].block);
     }
     switch (type) {
         case VM_TYPE_UNSET:
-            head = head[VM_TYPE_UNSET].ptr;
+            head = vm_int_wide(head)[VM_TYPE_UNSET].ptr;
             vm_int_run_next();
         case VM_TYPE_NIL:
-            head = head[VM_TYPE_NIL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_NIL].ptr;
             vm_int_run_next();
         case VM_TYPE_BOOL:
-            head = head[VM_TYPE_BOOL].ptr;
+            head = vm_int_wide(head)[VM_TYPE_BOOL].ptr;
             vm_int_run_next();
         case VM_TYPE_I32:
-            head = head[VM_TYPE_I32].ptr;
+            head = vm_int_wide(head)[VM_TYPE_I32].ptr;
             vm_int_run_next();
         case VM_TYPE_F64:
-            head = head[VM_TYPE_F64].ptr;
+            head = vm_int_wide(head)[VM_TYPE_F64].ptr;
             vm_int_run_next();
         case VM_TYPE_FUNC:
-            head = head[VM_TYPE_FUNC].ptr;
+            head = vm_int_wide(head)[VM_TYPE_FUNC].ptr;
             vm_int_run_next();
         case VM_TYPE_ARRAY:
-            head = head[VM_TYPE_ARRAY].ptr;
+            head = vm_int_wide(head)[VM_TYPE_ARRAY].ptr;
             vm_int_run_next();
         case VM_TYPE_TABLE:
-            head = head[VM_TYPE_TABLE].ptr;
+            head = vm_int_wide(head)[VM_TYPE_TABLE].ptr;
             vm_int_run_next();
     }
     __builtin_unreachable();
 }
-do_tset_rrr : {
+vm_int_run_op(tset_rrr) {
     vm_value_t obj = vm_int_run_read_load();
     vm_value_t ind = vm_int_run_read_load();
     vm_value_t val = vm_int_run_read_load();
-    vm_gc_table_set(vm_value_to_table(obj), ind, val);
+    vm_gc_table_set(&state->gc, vm_value_to_table(obj), ind, val);
     vm_int_run_next();
 }
-do_tset_rrf : {
+vm_int_run_op(tset_rrf) {
     vm_value_t obj = vm_int_run_read_load();
     vm_value_t ind = vm_int_run_read_load();
-    vm_value_t val = vm_value_from_float(vm_int_run_read().fval);
-    vm_gc_table_set(vm_value_to_table(obj), ind, val);
+    vm_value_t val = vm_value_from_float(vm_int_run_read_wide().fval);
+    vm_gc_table_set(&state->gc, vm_value_to_table(obj), ind, val);
     vm_int_run_next();
 }
-do_tset_rfr : {
+vm_int_run_op(tset_rfr) {
     vm_value_t obj = vm_int_run_read_load();
-    vm_value_t ind = vm_value_from_float(vm_int_run_read().fval);
+    vm_value_t ind = vm_value_from_float(vm_int_run_read_wide().fval);
     vm_value_t val = vm_int_run_read_load();
-    vm_gc_table_set(vm_value_to_table(obj), ind, val);
+    vm_gc_table_set(&state->gc, vm_value_to_table(obj), ind, val);
+    vm_int_run_next();
+}
+vm_int_run_op(tset_rff) {
+    vm_value_t obj = vm_int_run_read_load();
+    vm_value_t ind = vm_value_from_float(vm_int_run_read_wide().fval);
+    vm_value_t val = vm_value_from_float(vm_int_run_read_wide().fval);
+    vm_gc_table_set(&state->gc, vm_value_to_table(obj), ind, val);
+    vm_int_run_next();
+}
+// superinstructions
+vm_int_run_op(i32mod_rr_beq_rill) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_value_t lhs = vm_int_run_read_load();
+    vm_value_t rhs = vm_int_run_read_load();
+    *out = vm_value_from_int(vm_value_to_int(lhs) % vm_value_to_int(rhs));
+    vm_int_run_jump(i32beq_rill);
+}
+vm_int_run_op(i32mod_rr_beq_ritt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32mod_rr_beq_rill);
+    head += 5;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
+    head = loc;
+    vm_int_run_next();
+}
+vm_int_run_op(i32mul_rr_blt_rrll) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_value_t lhs = vm_int_run_read_load();
+    vm_value_t rhs = vm_int_run_read_load();
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), vm_value_to_int(rhs), __builtin_mul_overflow, *);
+    vm_int_run_jump(i32blt_rrll);
+}
+vm_int_run_op(i32mul_rr_blt_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32mul_rr_blt_rrll);
+    head += 5;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
+    head = loc;
+    vm_int_run_next();
+}
+vm_int_run_op(i32add_ri_blt_rrll) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_value_t lhs = vm_int_run_read_load();
+    vm_int_t rhs = vm_int_run_read().ival;
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_add_overflow, +);
+    vm_int_run_jump(i32blt_rrll);
+}
+vm_int_run_op(i32add_ri_blt_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32add_ri_blt_rrll);
+    head += 5;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
+    head = loc;
+    vm_int_run_next();
+}
+vm_int_run_op(i32add_ri_mul_rr) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_value_t lhs = vm_int_run_read_load();
+    vm_int_t rhs = vm_int_run_read().ival;
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_add_overflow, +);
+    vm_int_run_jump(i32mul_rr);
+}
+vm_int_run_op(i32add_ri_mul_rr_blt_rrll) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_value_t lhs = vm_int_run_read_load();
+    vm_int_t rhs = vm_int_run_read().ival;
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_add_overflow, +);
+    vm_int_run_jump(i32mul_rr_blt_rrll);
+}
+vm_int_run_op(i32add_ri_mul_rr_blt_rrtt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(i32add_ri_mul_rr_blt_rrll);
+    head += 8;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
+    head = loc;
     vm_int_run_next();
 }
-do_tset_rff : {
+vm_int_run_op(i32sub_ri_sub_rr) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_value_t lhs = vm_int_run_read_load();
+    vm_int_t rhs = vm_int_run_read().ival;
+    vm_int_run_i32_checked(out, vm_value_to_int(lhs), rhs, __builtin_sub_overflow, -);
+    vm_int_run_jump(i32sub_rr);
+}
+vm_int_run_op(len_r_i32beq_rill) {
+    vm_value_t *out = vm_int_run_read_store();
     vm_value_t obj = vm_int_run_read_load();
-    vm_value_t ind = vm_value_from_float(vm_int_run_read().fval);
-    vm_value_t val = vm_value_from_float(vm_int_run_read().fval);
-    vm_gc_table_set(vm_value_to_table(obj), ind, val);
+    *out = vm_value_from_int(vm_gc_len(obj));
+    vm_int_run_jump(i32beq_rill);
+}
+vm_int_run_op(len_r_i32beq_ritt) {
+    vm_int_opcode_t *loc = head -= VM_INT_WIDE;
+    vm_int_run_read_wide().ptr = vm_int_run_label(len_r_i32beq_rill);
+    head += 4;
+    vm_int_wide_t *block1 = &vm_int_run_read_wide();
+    vm_int_wide_t *block2 = &vm_int_run_read_wide();
+    block1->ptr = vm_int_run_comp(block1->block);
+    block2->ptr = vm_int_run_comp(block2->block);
+    head = loc;
     vm_int_run_next();
 }
+vm_int_run_op(mov_i_i32sub_ri) {
+    vm_value_t *out = vm_int_run_read_store();
+    vm_int_t value = vm_int_run_read().ival;
+    *out = vm_value_from_int(value);
+    vm_int_run_jump(i32sub_ri);
+}
+#if VM_INT_TAIL
+vm_value_t vm_int_run(vm_int_state_t *state, vm_ir_block_t *block0) {
+    vm_int_stack_limit(state);
+    vm_value_t *locals = state->locals;
+    vm_int_opcode_t **heads = state->heads;
+    size_t framesize = state->framesize;
+    if (state->profile_len != 0) {
+        vm_int_profile_comp(state, vm_int_run_ptrs);
+    }
+    if (state->precompile) {
+        vm_int_precompile(state, vm_int_run_ptrs, block0);
+    }
+    vm_int_opcode_t *head = vm_int_run_comp(block0);
+    if (state->use_spall) {
+        vm_trace_begin(&state->spall_ctx, NULL, vm_trace_time(), "init");
+    }
+    // the entry is a plain call, every handler after it tail calls the next
+    vm_int_run_func_t first = (vm_int_run_func_t)vm_int_run_read_wide().ptr;
+    return first(head, locals, heads, state, framesize);
+}
+#else
 }
+#endif
 
 vm_value_t vm_ir_be_int3(size_t nblocks, vm_ir_block_t *blocks, vm_int_func_t *funcs) {
     vm_ir_block_t *cur = &blocks[0];
     vm_int_state_t state = (vm_int_state_t){0};
-    size_t nregs = 1 << 16;
-    vm_value_t *locals = vm_alloc0(sizeof(vm_value_t) * nregs);
-    state.framesize = 1;
     state.funcs = funcs;
-    for (size_t i = 0; i < nblocks; i++) {
-        if (blocks[i].id >= 0) {
-            if (blocks[i].nregs >= state.framesize) {
-                state.framesize = blocks[i].nregs + 1;
-            }
-        }
-    }
-    state.locals = locals;
-    state.heads = vm_malloc(sizeof(vm_int_opcode_t *) * (nregs / state.framesize + 1));
-    vm_gc_init(&state.gc, nregs, locals);
+    state.inline_budget = VM_INT_INLINE_BUDGET;
+    vm_int_stack_init(&state, nblocks, blocks);
+    vm_gc_init(&state.gc, state.framesize * state.stack_frames, state.stack);
     vm_value_t ret = vm_int_run(&state, cur);
     vm_gc_deinit(&state.gc);
+    vm_int_stack_deinit(&state);
     return ret;
 }
 
@@ -6,6 +6,9 @@
 #include "../ir.h"
 #include "spall.h"
 
+// buckets in the versions per block histogram of -icomp-stats
+#define VM_INT_COMP_HIST 8
+
 /// I = Int Value
 /// R = Reg Local
 /// T = Tmp Block
@@ -99,6 +102,7 @@ enum {
     VM_INT_OP_CALL_L6,
     VM_INT_OP_CALL_L7,
     VM_INT_OP_CALL_L8,
+    VM_INT_OP_CALL_LN,
     VM_INT_OP_CALL_R0,
     VM_INT_OP_CALL_R1,
     VM_INT_OP_CALL_R2,
@@ -108,6 +112,7 @@ enum {
     VM_INT_OP_CALL_R6,
     VM_INT_OP_CALL_R7,
     VM_INT_OP_CALL_R8,
+    VM_INT_OP_CALL_RN,
     VM_INT_OP_CALL_X0,
     VM_INT_OP_CALL_X1,
     VM_INT_OP_CALL_X2,
@@ -117,6 +122,7 @@ enum {
     VM_INT_OP_CALL_X6,
     VM_INT_OP_CALL_X7,
     VM_INT_OP_CALL_X8,
+    VM_INT_OP_CALL_XN,
     VM_INT_OP_CALL_C0,
     VM_INT_OP_CALL_C1,
     VM_INT_OP_CALL_C2,
@@ -125,6 +131,7 @@ enum {
     VM_INT_OP_CALL_C5,
     VM_INT_OP_CALL_C6,
     VM_INT_OP_CALL_C7,
+    VM_INT_OP_CALL_CN,
 
     VM_INT_OP_ARR_F,
     VM_INT_OP_ARR_R,
@@ -162,6 +169,7 @@ enum {
     VM_INT_OP_CALL_T6,
     VM_INT_OP_CALL_T7,
     VM_INT_OP_CALL_T8,
+    VM_INT_OP_CALL_TN,
 
     VM_INT_OP_JUMP_T,
     VM_INT_OP_BB_RTT,
@@ -175,6 +183,35 @@ enum {
     VM_INT_OP_TGET_RF,
 
     VM_INT_OP_DEBUG_PRINT_INSTRS,
+    VM_INT_OP_COUNT,
+    VM_INT_OP_COUNT_BLOCK,
+    VM_INT_OP_SAMPLE,
+
+    // tail calls, only emitted when the backend has a handler for them
+    VM_INT_OP_TCALL_L,
+    VM_INT_OP_TCALL_T,
+    VM_INT_OP_TCALL_R,
+    VM_INT_OP_TCALL_C,
+
+    // the one version of a block past VM_INT_MAX_VERSIONS and where its calls
+    // return to, only emitted when the backend has a handler for them
+    VM_INT_OP_GENERIC,
+    VM_INT_OP_GENERIC_JUMP,
+
+    // superinstructions, only emitted when the backend has a handler for them
+    VM_INT_OP_I32MOD_RR_BEQ_RILL,
+    VM_INT_OP_I32MOD_RR_BEQ_RITT,
+    VM_INT_OP_I32MUL_RR_BLT_RRLL,
+    VM_INT_OP_I32MUL_RR_BLT_RRTT,
+    VM_INT_OP_I32ADD_RI_BLT_RRLL,
+    VM_INT_OP_I32ADD_RI_BLT_RRTT,
+    VM_INT_OP_I32ADD_RI_MUL_RR,
+    VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRLL,
+    VM_INT_OP_I32ADD_RI_MUL_RR_BLT_RRTT,
+    VM_INT_OP_I32SUB_RI_SUB_RR,
+    VM_INT_OP_LEN_R_I32BEQ_RILL,
+    VM_INT_OP_LEN_R_I32BEQ_RITT,
+    VM_INT_OP_MOV_I_I32SUB_RI,
 
     VM_INT_MAX_OP,
 };
@@ -188,6 +225,17 @@ typedef struct vm_int_buf_t vm_int_buf_t;
 union vm_int_opcode_t;
 typedef union vm_int_opcode_t vm_int_opcode_t;
 
+struct vm_int_precomp_t;
+typedef struct vm_int_precomp_t vm_int_precomp_t;
+
+// where a block starts in a compiled buffer, so sampled heads map back to it
+typedef struct {
+    vm_int_opcode_t *ops;
+    size_t at;
+    size_t len;
+    ptrdiff_t id;
+} vm_int_sample_region_t;
+
 typedef vm_value_t (*vm_int_func_ptr_t)(void *ptr, vm_int_state_t *state, size_t nargs, vm_value_t *args);
 
 typedef struct {
@@ -197,13 +245,78 @@ typedef struct {
 
 struct vm_int_state_t {
     vm_int_opcode_t **heads;
+    // the largest frame, each call moves locals by its own function's size
     size_t framesize;
     vm_int_func_t *funcs;
     vm_value_t *locals;
+    // register and return stacks, a call from a frame at or past locals_max
+    // grows them first so the callee's frame and its arg space both fit
+    vm_value_t *stack;
+    vm_int_opcode_t **stack_heads;
+    // length of the register stack in frames of the largest size
+    size_t stack_frames;
+    // the most args any one call passes, calls stage them past their frame
+    size_t call_args;
+    vm_value_t *locals_max;
     vm_gc_t gc;
     FILE *debug_print_instrs;
     vm_trace_profile_t spall_ctx;
     bool use_spall;
+    size_t *pair_counts;
+    size_t pair_last;
+    // times each op ran and each block was entered, by opcode and block id
+    size_t *op_counts;
+    size_t *block_counts;
+    size_t block_counts_len;
+    // sampling profiler, the function or continuation entered last and the
+    // call stack under it are published for the SIGPROF handler, see
+    // vm_int_sample_init
+    FILE *sample;
+    vm_int_opcode_t *volatile sample_head;
+    vm_int_opcode_t **volatile sample_heads;
+    void **samples;
+    volatile size_t samples_len;
+    volatile size_t samples_missed;
+    volatile size_t samples_dropped;
+    vm_int_sample_region_t *sample_regions;
+    size_t sample_regions_len;
+    size_t sample_regions_alloc;
+    size_t inline_budget;
+    size_t inlined;
+    // continuation of each int op that leaves on overflow, by first operand
+    vm_int_opcode_t **exit_keys;
+    vm_ir_block_t **exit_blocks;
+    size_t exit_len;
+    size_t exit_alloc;
+    // compile what can be typed statically before running, see vm_int_precompile
+    bool precompile;
+    vm_int_precomp_t *precomp;
+    // versions to compile before running, read by vm_int_profile_read
+    vm_ir_block_t **profile_blocks;
+    uint8_t **profile_types;
+    size_t profile_len;
+    // set while compiling ahead of time, where a type error drops the version
+    bool comp_eager;
+    // versions compiled by the precompile and lazily on first execution,
+    // with the time spent on each in nanoseconds
+    size_t precomp_versions;
+    uint64_t precomp_ns;
+    size_t comp_versions;
+    uint64_t comp_ns;
+    // what the version lookup in vm_int_block_comp found and what compiling
+    // made, versions per block are kept as a histogram, see vm_int_comp_bucket
+    size_t comp_lookups;
+    size_t comp_hits;
+    size_t comp_blocks;
+    size_t comp_bytes;
+    size_t comp_hist[VM_INT_COMP_HIST];
+    // blocks that went past VM_INT_MAX_VERSIONS, each then runs a generic
+    // version where the backend has one, see vm_int_generic_comp
+    size_t comp_megamorphic;
+    // call sites that linked a continuation on return, and those of them
+    // that went on to link one for a second return type
+    size_t ret_sites;
+    size_t ret_poly;
 };
 
 struct vm_int_buf_t {
@@ -212,6 +325,23 @@ struct vm_int_buf_t {
     vm_int_opcode_t *ops;
 };
 
+#if VM_INT_COMPACT
+// registers and small immediates take 4 bytes, handlers, blocks and floats
+// take two of those and are read and written through vm_int_wide
+union vm_int_opcode_t {
+    uint32_t reg;
+    int32_t ival;
+    bool bval;
+};
+
+typedef union {
+    void *ptr;
+    vm_ir_block_t *block;
+    vm_number_t fval;
+} __attribute__((packed, aligned(4), may_alias)) vm_int_wide_t;
+
+#define VM_INT_WIDE 2
+#else
 union vm_int_opcode_t {
     void *ptr;
     vm_ir_block_t *block;
@@ -221,7 +351,31 @@ union vm_int_opcode_t {
     bool bval;
 };
 
+typedef vm_int_opcode_t vm_int_wide_t;
+
+#define VM_INT_WIDE 1
+#endif
+
+#define vm_int_wide(ops_) ((vm_int_wide_t *)(ops_))
+
+void *vm_int_block_comp(vm_int_state_t *state, void **ptrs, vm_ir_block_t *block);
+void vm_int_precompile(vm_int_state_t *state, void **ptrs, vm_ir_block_t *entry);
+bool vm_int_profile_read(vm_int_state_t *state, const char *path, uint64_t hash, size_t nblocks, vm_ir_block_t *blocks);
+void vm_int_profile_write(const char *path, uint64_t hash, size_t nblocks, vm_ir_block_t *blocks);
+vm_ir_block_t *vm_int_exit_find(vm_int_state_t *state, vm_int_opcode_t *key);
 vm_value_t vm_int_run(vm_int_state_t *state, vm_ir_block_t *block);
+void vm_int_stack_init(vm_int_state_t *state, size_t nblocks, vm_ir_block_t *blocks);
+void vm_int_stack_grow(vm_int_state_t *state);
+void vm_int_stack_limit(vm_int_state_t *state);
+void vm_int_stack_deinit(vm_int_state_t *state);
+void vm_int_pairs_init(vm_int_state_t *state);
+void vm_int_pairs_print(vm_int_state_t *state, FILE *out, size_t max);
+void vm_int_comp_stats_print(vm_int_state_t *state, FILE *out);
+void vm_int_counts_init(vm_int_state_t *state, size_t nblocks, bool ops);
+void vm_int_counts_print(vm_int_state_t *state, FILE *out, size_t max);
+void vm_int_sample_region(vm_int_state_t *state, size_t at, ptrdiff_t id);
+bool vm_int_sample_init(vm_int_state_t *state, const char *path);
+void vm_int_sample_deinit(vm_int_state_t *state);
 vm_value_t vm_ir_be_int3(size_t nblocks, vm_ir_block_t *blocks, vm_int_func_t *funcs);
 vm_value_t vm_run_arch_int(size_t nops, vm_opcode_t *opcodes, vm_int_func_t *funcs);
 
@@ -124,7 +124,8 @@ void vm_ir_be_js_block_raw(FILE *of, vm_ir_block_t *block) {
                 fprintf(of, ";");
                 break;
             }
-            case VM_IR_IOP_CALL: {
+            case VM_IR_IOP_CALL:
+            case VM_IR_IOP_TCALL: {
                 fprintf(of, "var ");
                 vm_ir_be_js_arg(of, instr->out);
                 fprintf(of, "=call(");
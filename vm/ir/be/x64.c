@@ -0,0 +1,1344 @@
+// MAP_ANONYMOUS is outside strict c11 and posix, so ask for it before any
+// system header is read
+#if !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
+
+#include "x64.h"
+
+#include "../../lib.h"
+#include "../build.h"
+
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(VM_WASM)
+
+#include <sys/mman.h>
+
+#if !defined(MAP_ANON)
+#define MAP_ANON MAP_ANONYMOUS
+#endif
+
+/// the x64 backend does not have its own block compiler:
+/// vm_int_block_comp is handed a table of tags instead of labels,
+/// and each finished block version is translated to machine code once.
+///
+/// rbx = locals, r12 = vm_x64_t, r13 = double bias, r14 = int tag
+/// values returned from calls and typed lookups come back in rax,
+/// with their type in edx for the continuation's inline cache.
+
+enum {
+    VM_X64_RAX,
+    VM_X64_RCX,
+    VM_X64_RDX,
+    VM_X64_RBX,
+    VM_X64_RSP,
+    VM_X64_RBP,
+    VM_X64_RSI,
+    VM_X64_RDI,
+    VM_X64_R8,
+    VM_X64_R9,
+    VM_X64_R10,
+    VM_X64_R11,
+    VM_X64_R12,
+    VM_X64_R13,
+    VM_X64_R14,
+    VM_X64_R15,
+};
+
+enum {
+    VM_X64_CC_B = 0x2,
+    VM_X64_CC_E = 0x4,
+    VM_X64_CC_NE = 0x5,
+    VM_X64_CC_A = 0x7,
+    VM_X64_CC_P = 0xA,
+    VM_X64_CC_L = 0xC,
+};
+
+enum {
+    // jmp/jcc/call rel32 to a block version that is not compiled yet
+    VM_X64_FIXUP_LINK,
+    // cmp edx, type; jne slow; jmp version
+    VM_X64_FIXUP_TYPED,
+    // mov rax, block; cmp rcx, rax; jne slow; call version
+    VM_X64_FIXUP_CALL,
+};
+
+struct vm_x64_t;
+typedef struct vm_x64_t vm_x64_t;
+
+typedef struct {
+    size_t at;
+    size_t kind;
+    vm_ir_block_t *block;
+} vm_x64_fixup_t;
+
+typedef struct {
+    uint64_t value;
+    uint64_t type;
+} vm_x64_pair_t;
+
+typedef void (*vm_x64_enter_t)(vm_x64_t *x64, vm_value_t *locals, void *code, void *rsp);
+
+struct vm_x64_t {
+    vm_int_state_t *state;
+    void *exit_rsp;
+    uint8_t *code;
+    size_t len;
+    size_t alloc;
+    uint8_t *exit;
+    uint8_t *stack_overflow;
+    void *rsp_min;
+    void **cache_keys;
+    void **cache_values;
+    size_t cache_len;
+    size_t cache_alloc;
+    vm_x64_fixup_t *fixups;
+    size_t nfixups;
+    size_t afixups;
+    // the collector lowers gc.limit, copied here after each call into it
+    vm_value_t *limit;
+    void *ptrs[VM_INT_MAX_OP];
+};
+
+static uint8_t vm_x64_tags[VM_INT_MAX_OP];
+
+#define vm_x64_emit(x64_, ...)                                      \
+    do {                                                            \
+        const uint8_t bytes_[] = {__VA_ARGS__};                     \
+        memcpy(&(x64_)->code[(x64_)->len], bytes_, sizeof(bytes_)); \
+        (x64_)->len += sizeof(bytes_);                              \
+    } while (0)
+
+#define vm_x64_call_c(x64_, func_) vm_x64_call_addr(x64_, (uint64_t)(size_t) & (func_))
+
+static void vm_x64_reserve(vm_x64_t *x64, size_t size) {
+    if (x64->len + size >= x64->alloc) {
+        fprintf(stderr, "x64: out of code space (%zu bytes)\n", x64->alloc);
+        __builtin_trap();
+    }
+}
+
+static void vm_x64_byte(vm_x64_t *x64, uint8_t byte) {
+    x64->code[x64->len++] = byte;
+}
+
+static void vm_x64_imm32(vm_x64_t *x64, int32_t val) {
+    memcpy(&x64->code[x64->len], &val, sizeof(int32_t));
+    x64->len += sizeof(int32_t);
+}
+
+static void vm_x64_imm64(vm_x64_t *x64, uint64_t val) {
+    memcpy(&x64->code[x64->len], &val, sizeof(uint64_t));
+    x64->len += sizeof(uint64_t);
+}
+
+static void vm_x64_patch(uint8_t *site, void *target) {
+    int32_t rel = (int32_t)((uint8_t *)target - (site + sizeof(int32_t)));
+    memcpy(site, &rel, sizeof(int32_t));
+}
+
+static void vm_x64_rex(vm_x64_t *x64, bool wide, size_t reg, size_t rm) {
+    uint8_t rex = 0x40 | (wide ? 0x8 : 0) | ((reg & 8) ? 0x4 : 0) | ((rm & 8) ? 0x1 : 0);
+    if (rex != 0x40) {
+        vm_x64_byte(x64, rex);
+    }
+}
+
+// modrm for [rbx + slot * 8]
+static void vm_x64_modrm_mem(vm_x64_t *x64, size_t reg, size_t slot) {
+    vm_x64_byte(x64, 0x80 | ((reg & 7) << 3) | VM_X64_RBX);
+    vm_x64_imm32(x64, (int32_t)(slot * sizeof(vm_value_t)));
+}
+
+static void vm_x64_op_mem(vm_x64_t *x64, bool wide, uint8_t op, size_t reg, size_t slot) {
+    vm_x64_rex(x64, wide, reg, VM_X64_RBX);
+    vm_x64_byte(x64, op);
+    vm_x64_modrm_mem(x64, reg, slot);
+}
+
+static void vm_x64_op_reg(vm_x64_t *x64, bool wide, uint8_t op, size_t reg, size_t rm) {
+    vm_x64_rex(x64, wide, reg, rm);
+    vm_x64_byte(x64, op);
+    vm_x64_byte(x64, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+static void vm_x64_sse(vm_x64_t *x64, uint8_t prefix, uint8_t op, size_t reg, size_t rm) {
+    vm_x64_emit(x64, prefix, 0x0F, op, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+static void vm_x64_sse_mem(vm_x64_t *x64, uint8_t prefix, uint8_t op, size_t reg, size_t slot) {
+    vm_x64_emit(x64, prefix, 0x0F, op);
+    vm_x64_modrm_mem(x64, reg, slot);
+}
+
+static void vm_x64_load(vm_x64_t *x64, size_t reg, size_t slot) {
+    vm_x64_op_mem(x64, true, 0x8B, reg, slot);
+}
+
+static void vm_x64_load32(vm_x64_t *x64, size_t reg, size_t slot) {
+    vm_x64_op_mem(x64, false, 0x8B, reg, slot);
+}
+
+static void vm_x64_store(vm_x64_t *x64, size_t slot, size_t reg) {
+    vm_x64_op_mem(x64, true, 0x89, reg, slot);
+}
+
+static void vm_x64_load_imm(vm_x64_t *x64, size_t reg, uint64_t val) {
+    if (val <= UINT32_MAX) {
+        vm_x64_rex(x64, false, 0, reg);
+        vm_x64_byte(x64, 0xB8 + (reg & 7));
+        vm_x64_imm32(x64, (int32_t)(uint32_t)val);
+    } else {
+        vm_x64_rex(x64, true, 0, reg);
+        vm_x64_byte(x64, 0xB8 + (reg & 7));
+        vm_x64_imm64(x64, val);
+    }
+}
+
+static void vm_x64_store_imm(vm_x64_t *x64, size_t slot, uint64_t val) {
+    if (val <= INT32_MAX) {
+        vm_x64_op_mem(x64, true, 0xC7, 0, slot);
+        vm_x64_imm32(x64, (int32_t)val);
+    } else {
+        vm_x64_load_imm(x64, VM_X64_RAX, val);
+        vm_x64_store(x64, slot, VM_X64_RAX);
+    }
+}
+
+static void vm_x64_mov(vm_x64_t *x64, size_t dest, size_t src) {
+    vm_x64_op_reg(x64, true, 0x89, src, dest);
+}
+
+// op eax, imm32
+static void vm_x64_alu_imm(vm_x64_t *x64, size_t ext, size_t reg, int32_t val) {
+    vm_x64_rex(x64, false, 0, reg);
+    vm_x64_byte(x64, 0x81);
+    vm_x64_byte(x64, 0xC0 | (ext << 3) | (reg & 7));
+    vm_x64_imm32(x64, val);
+}
+
+static void vm_x64_locals_add(vm_x64_t *x64, ptrdiff_t nslots) {
+    vm_x64_emit(x64, 0x48, 0x81, 0xC3);
+    vm_x64_imm32(x64, (int32_t)(nslots * (ptrdiff_t)sizeof(vm_value_t)));
+}
+
+// rax = eax | int tag
+static void vm_x64_box_int(vm_x64_t *x64) {
+    vm_x64_op_reg(x64, true, 0x09, VM_X64_R14, VM_X64_RAX);
+}
+
+static void vm_x64_load_float(vm_x64_t *x64, size_t xmm, size_t slot) {
+    vm_x64_load(x64, VM_X64_RAX, slot);
+    vm_x64_op_reg(x64, true, 0x29, VM_X64_R13, VM_X64_RAX);
+    vm_x64_emit(x64, 0x66, 0x48, 0x0F, 0x6E, 0xC0 | (xmm << 3));
+}
+
+static void vm_x64_const_float(vm_x64_t *x64, size_t xmm, double val) {
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(double));
+    vm_x64_load_imm(x64, VM_X64_RAX, bits);
+    vm_x64_emit(x64, 0x66, 0x48, 0x0F, 0x6E, 0xC0 | (xmm << 3));
+}
+
+static void vm_x64_store_float(vm_x64_t *x64, size_t slot, size_t xmm) {
+    vm_x64_emit(x64, 0x66, 0x48, 0x0F, 0x7E, 0xC0 | (xmm << 3));
+    vm_x64_op_reg(x64, true, 0x01, VM_X64_R13, VM_X64_RAX);
+    vm_x64_store(x64, slot, VM_X64_RAX);
+}
+
+// keeps the c abi happy no matter how deep the vm stack is
+static void vm_x64_call_addr(vm_x64_t *x64, uint64_t addr) {
+    vm_x64_emit(x64, 0x48, 0x89, 0xE5);
+    vm_x64_emit(x64, 0x48, 0x83, 0xE4, 0xF0);
+    vm_x64_load_imm(x64, VM_X64_RAX, addr);
+    vm_x64_emit(x64, 0xFF, 0xD0);
+    vm_x64_emit(x64, 0x48, 0x89, 0xEC);
+}
+
+static void vm_x64_fixup(vm_x64_t *x64, size_t kind, size_t at, vm_ir_block_t *block) {
+    if (x64->nfixups + 1 >= x64->afixups) {
+        x64->afixups = (x64->nfixups + 1) * 2;
+        x64->fixups = vm_realloc(x64->fixups, sizeof(vm_x64_fixup_t) * x64->afixups);
+    }
+    x64->fixups[x64->nfixups++] = (vm_x64_fixup_t){
+        .at = at,
+        .kind = kind,
+        .block = block,
+    };
+}
+
+static void vm_x64_jmp(vm_x64_t *x64, vm_ir_block_t *block) {
+    vm_x64_byte(x64, 0xE9);
+    vm_x64_fixup(x64, VM_X64_FIXUP_LINK, x64->len, block);
+    vm_x64_imm32(x64, 0);
+}
+
+static void vm_x64_jcc(vm_x64_t *x64, uint8_t cc, vm_ir_block_t *block) {
+    vm_x64_emit(x64, 0x0F, 0x80 | cc);
+    vm_x64_fixup(x64, VM_X64_FIXUP_LINK, x64->len, block);
+    vm_x64_imm32(x64, 0);
+}
+
+static void vm_x64_jmp_typed(vm_x64_t *x64, vm_ir_block_t *block) {
+    vm_x64_fixup(x64, VM_X64_FIXUP_TYPED, x64->len, block);
+    vm_x64_emit(x64, 0x81, 0xFA);
+    vm_x64_imm32(x64, -1);
+    vm_x64_emit(x64, 0x0F, 0x85);
+    vm_x64_imm32(x64, 0);
+    vm_x64_byte(x64, 0xE9);
+    vm_x64_imm32(x64, 0);
+}
+
+// after a vm call returns: pop the frame, store the result and dispatch on its type
+static void vm_x64_call_ret(vm_x64_t *x64, size_t fsize, size_t out, vm_ir_block_t *block) {
+    vm_x64_locals_add(x64, -(ptrdiff_t)fsize);
+    vm_x64_store(x64, out, VM_X64_RAX);
+    vm_x64_jmp_typed(x64, block);
+}
+
+// xmm = (double) of an int slot, or of an immediate when konst is set
+static void vm_x64_int_float(vm_x64_t *x64, size_t xmm, bool konst, int64_t val) {
+    if (konst) {
+        vm_x64_load_imm(x64, VM_X64_RAX, (uint32_t)val);
+        vm_x64_sse(x64, 0xF2, 0x2A, xmm, VM_X64_RAX);
+    } else {
+        vm_x64_sse_mem(x64, 0xF2, 0x2A, xmm, (size_t)val);
+    }
+}
+
+// after an i32 add/sub/mul: if it overflowed and int3 knows where the op
+// leaves to, redo it in doubles and jump to the float version of that block
+static void vm_x64_overflow(vm_x64_t *x64, vm_int_opcode_t *at, uint8_t fop, size_t out, bool lkonst, int64_t lhs, bool rkonst, int64_t rhs) {
+    vm_ir_block_t *next = vm_int_exit_find(x64->state, at);
+    if (next == NULL) {
+        return;
+    }
+    // jno past the exit
+    vm_x64_emit(x64, 0x0F, 0x81);
+    size_t skip = x64->len;
+    vm_x64_imm32(x64, 0);
+    vm_x64_int_float(x64, 0, lkonst, lhs);
+    vm_x64_int_float(x64, 1, rkonst, rhs);
+    vm_x64_sse(x64, 0xF2, fop, 0, 1);
+    vm_x64_store_float(x64, out, 0);
+    vm_x64_jmp(x64, next);
+    vm_x64_patch(&x64->code[skip], &x64->code[x64->len]);
+}
+
+static void vm_x64_ret(vm_x64_t *x64, uint8_t type) {
+    vm_x64_load_imm(x64, VM_X64_RDX, type);
+    vm_x64_byte(x64, 0xC3);
+}
+
+static void *vm_x64_cache_get(vm_x64_t *x64, void *key) {
+    if (x64->cache_alloc == 0) {
+        return NULL;
+    }
+    size_t mask = x64->cache_alloc - 1;
+    size_t i = ((size_t)key >> 4) & mask;
+    while (x64->cache_keys[i] != NULL) {
+        if (x64->cache_keys[i] == key) {
+            return x64->cache_values[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+static void vm_x64_cache_set(vm_x64_t *x64, void *key, void *value) {
+    if ((x64->cache_len + 1) * 2 >= x64->cache_alloc) {
+        size_t old_alloc = x64->cache_alloc;
+        void **old_keys = x64->cache_keys;
+        void **old_values = x64->cache_values;
+        x64->cache_alloc = old_alloc == 0 ? 64 : old_alloc * 2;
+        x64->cache_keys = vm_alloc0(sizeof(void *) * x64->cache_alloc);
+        x64->cache_values = vm_malloc(sizeof(void *) * x64->cache_alloc);
+        x64->cache_len = 0;
+        for (size_t i = 0; i < old_alloc; i++) {
+            if (old_keys[i] != NULL) {
+                vm_x64_cache_set(x64, old_keys[i], old_values[i]);
+            }
+        }
+        vm_free(old_keys);
+        vm_free(old_values);
+    }
+    size_t mask = x64->cache_alloc - 1;
+    size_t i = ((size_t)key >> 4) & mask;
+    while (x64->cache_keys[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    x64->cache_keys[i] = key;
+    x64->cache_values[i] = value;
+    x64->cache_len += 1;
+}
+
+static void *vm_x64_block_comp(vm_x64_t *x64, vm_ir_block_t *block);
+
+// runtime helpers called from generated code
+
+static void *vm_x64_link(vm_x64_t *x64, vm_value_t *locals, vm_ir_block_t *block, uint8_t *site) {
+    x64->state->locals = locals;
+    void *code = vm_x64_block_comp(x64, block);
+    vm_x64_patch(site, code);
+    return code;
+}
+
+static void *vm_x64_link_typed(vm_x64_t *x64, vm_value_t *locals, vm_ir_block_t *block, uint8_t *ic, uint32_t type) {
+    x64->state->locals = locals;
+    void *code = vm_x64_block_comp(x64, block);
+    int32_t cached;
+    memcpy(&cached, &ic[2], sizeof(int32_t));
+    if (cached == -1) {
+        int32_t val = (int32_t)type;
+        memcpy(&ic[2], &val, sizeof(int32_t));
+        vm_x64_patch(&ic[13], code);
+    }
+    return code;
+}
+
+static void *vm_x64_link_call(vm_x64_t *x64, vm_value_t *locals, vm_ir_block_t *block, uint8_t *ic) {
+    x64->state->locals = locals;
+    void *code = vm_x64_block_comp(x64, block);
+    uint64_t cached;
+    memcpy(&cached, &ic[2], sizeof(uint64_t));
+    if (cached == 0) {
+        uint64_t val = (uint64_t)(size_t)block;
+        memcpy(&ic[2], &val, sizeof(uint64_t));
+        vm_x64_patch(&ic[20], code);
+    }
+    return code;
+}
+
+static vm_value_t *vm_x64_limit(vm_x64_t *x64, vm_value_t *locals) {
+    x64->state->locals = locals;
+    vm_int_stack_limit(x64->state);
+    x64->limit = x64->state->gc.limit;
+    return x64->state->locals;
+}
+
+static void vm_x64_stack_overflow(void) {
+    fprintf(stderr, "stack overflow: more than %zu bytes of native stack\n", (size_t)VM_CONFIG_X64_NATIVE_STACK);
+    __builtin_trap();
+}
+
+// before a vm call: stop when the native stack is at x64->rsp_min, since
+// each vm call is a native call, then raise the vm stack's limit when this
+// frame is at x64->limit, see vm_int_stack_limit
+static void vm_x64_call_check(vm_x64_t *x64) {
+    // cmp rsp, [r12 + rsp_min]; jb overflow
+    vm_x64_emit(x64, 0x49, 0x3B, 0xA4, 0x24);
+    vm_x64_imm32(x64, (int32_t)offsetof(vm_x64_t, rsp_min));
+    vm_x64_emit(x64, 0x0F, 0x82);
+    vm_x64_patch(&x64->code[x64->len], x64->stack_overflow);
+    x64->len += sizeof(int32_t);
+    // cmp rbx, [r12 + limit]; jb done
+    vm_x64_emit(x64, 0x49, 0x3B, 0x9C, 0x24);
+    vm_x64_imm32(x64, (int32_t)offsetof(vm_x64_t, limit));
+    vm_x64_emit(x64, 0x72, 0x00);
+    size_t skip = x64->len;
+    vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+    vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+    vm_x64_call_c(x64, vm_x64_limit);
+    vm_x64_mov(x64, VM_X64_RBX, VM_X64_RAX);
+    x64->code[skip - 1] = (uint8_t)(x64->len - skip);
+}
+
+static void *vm_x64_closure(vm_x64_t *x64, vm_value_t *locals, vm_value_t obj) {
+    x64->state->locals = locals;
+    return vm_x64_block_comp(x64, vm_value_to_block(vm_gc_get_i(obj, 0)));
+}
+
+static void *vm_x64_func(vm_x64_t *x64, vm_value_t *locals, vm_value_t func) {
+    x64->state->locals = locals;
+    return vm_x64_block_comp(x64, vm_value_to_block(func));
+}
+
+static vm_x64_pair_t vm_x64_extern(vm_x64_t *x64, vm_value_t *locals, int32_t index, size_t nargs) {
+    vm_int_state_t *state = x64->state;
+    vm_int_func_t ptr = state->funcs[index];
+    vm_value_t small[8];
+    vm_value_t *values = nargs <= 8 ? &small[0] : vm_malloc(sizeof(vm_value_t) * nargs);
+    for (size_t i = 0; i < nargs; i++) {
+        values[i] = locals[state->framesize + 1 + i];
+    }
+    state->locals = locals + state->framesize;
+    vm_value_t ret = ptr.func(ptr.data, state, nargs, values);
+    state->locals = locals;
+    if (values != &small[0]) {
+        vm_free(values);
+    }
+    return (vm_x64_pair_t){ret.as_int64, vm_typeof(ret)};
+}
+
+static uint64_t vm_x64_arr(vm_x64_t *x64, vm_value_t *locals, vm_value_t len, size_t fsize) {
+    vm_gc_run(&x64->state->gc, locals + fsize);
+    x64->limit = x64->state->gc.limit;
+    return vm_gc_arr(&x64->state->gc, (vm_int_t)vm_value_to_float(len)).as_int64;
+}
+
+static uint64_t vm_x64_tab(vm_x64_t *x64, vm_value_t *locals, size_t fsize) {
+    vm_gc_run(&x64->state->gc, locals + fsize);
+    x64->limit = x64->state->gc.limit;
+    return vm_gc_tab(&x64->state->gc).as_int64;
+}
+
+static vm_x64_pair_t vm_x64_get(vm_value_t obj, vm_value_t key) {
+    vm_value_t ret = vm_gc_get_v(obj, key);
+    return (vm_x64_pair_t){ret.as_int64, vm_typeof(ret)};
+}
+
+static vm_x64_pair_t vm_x64_tget(vm_value_t obj, vm_value_t key) {
+    vm_value_t ret = vm_gc_table_get(vm_value_to_table(obj), key);
+    return (vm_x64_pair_t){ret.as_int64, vm_typeof(ret)};
+}
+
+static void vm_x64_tset(vm_gc_t *gc, vm_value_t obj, vm_value_t key, vm_value_t val) {
+    vm_gc_table_set(gc, vm_value_to_table(obj), key, val);
+}
+
+static uint64_t vm_x64_in(void) {
+    return vm_value_from_int((int)fgetc(stdin)).as_int64;
+}
+
+static void vm_x64_out(int32_t chr) {
+    fprintf(stdout, "%c", (int)chr);
+}
+
+// stubs are placed after the block that needs them
+
+static void vm_x64_stub(vm_x64_t *x64, vm_x64_fixup_t fixup) {
+    uint8_t *code = x64->code;
+    uint8_t *stub = &code[x64->len];
+    switch (fixup.kind) {
+        case VM_X64_FIXUP_LINK: {
+            vm_x64_patch(&code[fixup.at], stub);
+            vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+            vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+            vm_x64_load_imm(x64, VM_X64_RDX, (uint64_t)(size_t)fixup.block);
+            vm_x64_emit(x64, 0x48, 0x8D, 0x0D);
+            vm_x64_patch(&code[x64->len], &code[fixup.at]);
+            x64->len += sizeof(int32_t);
+            vm_x64_call_c(x64, vm_x64_link);
+            vm_x64_emit(x64, 0xFF, 0xE0);
+            break;
+        }
+        case VM_X64_FIXUP_TYPED: {
+            vm_x64_patch(&code[fixup.at + 8], stub);
+            vm_x64_patch(&code[fixup.at + 13], stub);
+            vm_x64_emit(x64, 0x41, 0x89, 0xD0);
+            vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+            vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+            vm_x64_load_imm(x64, VM_X64_RDX, (uint64_t)(size_t)fixup.block);
+            vm_x64_emit(x64, 0x48, 0x8D, 0x0D);
+            vm_x64_patch(&code[x64->len], &code[fixup.at]);
+            x64->len += sizeof(int32_t);
+            vm_x64_call_c(x64, vm_x64_link_typed);
+            vm_x64_emit(x64, 0xFF, 0xE0);
+            break;
+        }
+        case VM_X64_FIXUP_CALL: {
+            vm_x64_patch(&code[fixup.at + 15], stub);
+            vm_x64_patch(&code[fixup.at + 20], stub);
+            vm_x64_mov(x64, VM_X64_RDX, VM_X64_RCX);
+            vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+            vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+            vm_x64_emit(x64, 0x48, 0x8D, 0x0D);
+            vm_x64_patch(&code[x64->len], &code[fixup.at]);
+            x64->len += sizeof(int32_t);
+            vm_x64_call_c(x64, vm_x64_link_call);
+            vm_x64_emit(x64, 0xFF, 0xD0);
+            vm_x64_byte(x64, 0xE9);
+            vm_x64_patch(&code[x64->len], &code[fixup.at + 24]);
+            x64->len += sizeof(int32_t);
+            break;
+        }
+    }
+}
+
+#define vm_x64_read() (*head++)
+
+static vm_int_wide_t *vm_x64_next_wide(vm_int_opcode_t **phead, size_t skip) {
+    vm_int_wide_t *ret = vm_int_wide(*phead);
+    *phead += (1 + skip) * VM_INT_WIDE;
+    return ret;
+}
+
+#define vm_x64_read_wide() (*vm_x64_next_wide(&head, 0))
+
+// a continuation's slot for each returned type, only the block is needed
+#define vm_x64_read_types() (vm_x64_next_wide(&head, VM_TYPE_MAX - 1)->block)
+
+static void vm_x64_copy_args(vm_x64_t *x64, vm_int_opcode_t **phead, size_t fsize, size_t first, size_t nargs) {
+    vm_int_opcode_t *head = *phead;
+    // a load and a store per arg, past what each op reserves
+    vm_x64_reserve(x64, 256 + 16 * nargs);
+    for (size_t i = 0; i < nargs; i++) {
+        vm_x64_load(x64, VM_X64_RAX, vm_x64_read().reg);
+        vm_x64_store(x64, fsize + first + i, VM_X64_RAX);
+    }
+    *phead = head;
+}
+
+// a tail call's args are staged past the frame and then moved to its start,
+// since they can read registers that the move overwrites
+static void vm_x64_tail_args(vm_x64_t *x64, vm_int_opcode_t **phead, size_t first) {
+    vm_int_opcode_t *head = *phead;
+    size_t fsize = vm_x64_read().reg;
+    size_t nargs = (size_t)vm_x64_read().ival;
+    vm_x64_copy_args(x64, &head, fsize, 1 + first, nargs);
+    for (size_t i = 0; i < nargs; i++) {
+        vm_x64_load(x64, VM_X64_RAX, fsize + 1 + first + i);
+        vm_x64_store(x64, 1 + first + i, VM_X64_RAX);
+    }
+    *phead = head;
+}
+
+static void *vm_x64_block_comp(vm_x64_t *x64, vm_ir_block_t *block) {
+    vm_int_opcode_t *ops = vm_int_block_comp(x64->state, x64->ptrs, block);
+    void *found = vm_x64_cache_get(x64, ops);
+    if (found != NULL) {
+        return found;
+    }
+    size_t framesize = x64->state->framesize;
+    uint8_t *code = &x64->code[x64->len];
+    vm_int_opcode_t *head = ops;
+    x64->nfixups = 0;
+    while (true) {
+        vm_x64_reserve(x64, 256);
+        size_t op = (size_t)((uint8_t *)vm_x64_read_wide().ptr - vm_x64_tags);
+        switch (op) {
+            case VM_INT_OP_EXIT: {
+                vm_x64_byte(x64, 0xE9);
+                vm_x64_patch(&x64->code[x64->len], x64->exit);
+                x64->len += sizeof(int32_t);
+                goto done;
+            }
+            case VM_INT_OP_MOV_V: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_store_imm(x64, out, vm_value_nil().as_int64);
+                break;
+            }
+            case VM_INT_OP_MOV_B: {
+                size_t out = vm_x64_read().reg;
+                bool val = vm_x64_read().bval;
+                vm_x64_store_imm(x64, out, vm_value_from_bool(val).as_int64);
+                break;
+            }
+            case VM_INT_OP_MOV_I: {
+                size_t out = vm_x64_read().reg;
+                int32_t val = vm_x64_read().ival;
+                vm_x64_store_imm(x64, out, vm_value_from_int(val).as_int64);
+                break;
+            }
+            case VM_INT_OP_MOV_F: {
+                size_t out = vm_x64_read().reg;
+                double val = vm_x64_read_wide().fval;
+                vm_x64_store_imm(x64, out, vm_value_from_float(val).as_int64);
+                break;
+            }
+            case VM_INT_OP_MOV_R: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_load(x64, VM_X64_RAX, vm_x64_read().reg);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_MOV_T: {
+                size_t out = vm_x64_read().reg;
+                vm_ir_block_t *func = vm_x64_read_wide().block;
+                vm_x64_store_imm(x64, out, vm_value_from_block(func).as_int64);
+                break;
+            }
+            case VM_INT_OP_FMOV_R: {
+                size_t reg = vm_x64_read().reg;
+                // cvtsi2sd xmm0, dword [reg]
+                vm_x64_sse_mem(x64, 0xF2, 0x2A, 0, reg);
+                vm_x64_store_float(x64, reg, 0);
+                break;
+            }
+            case VM_INT_OP_IMOV_R: {
+                size_t reg = vm_x64_read().reg;
+                vm_x64_load_float(x64, 0, reg);
+                // cvttsd2si eax, xmm0
+                vm_x64_sse(x64, 0xF2, 0x2C, VM_X64_RAX, 0);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, reg, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_DYNBEQ_RRTT: {
+                vm_x64_load(x64, VM_X64_RDI, vm_x64_read().reg);
+                vm_x64_load(x64, VM_X64_RSI, vm_x64_read().reg);
+                vm_ir_block_t *iffalse = vm_x64_read_wide().block;
+                vm_ir_block_t *iftrue = vm_x64_read_wide().block;
+                vm_x64_call_c(x64, vm_gc_eq);
+                vm_x64_emit(x64, 0x84, 0xC0);
+                vm_x64_jcc(x64, VM_X64_CC_NE, iftrue);
+                vm_x64_jmp(x64, iffalse);
+                goto done;
+            }
+            case VM_INT_OP_I32BOR_RR:
+            case VM_INT_OP_I32BAND_RR:
+            case VM_INT_OP_I32BXOR_RR:
+            case VM_INT_OP_I32ADD_RR:
+            case VM_INT_OP_I32SUB_RR: {
+                static const uint8_t alu[VM_INT_MAX_OP] = {
+                    [VM_INT_OP_I32BOR_RR] = 0x0B,
+                    [VM_INT_OP_I32BAND_RR] = 0x23,
+                    [VM_INT_OP_I32BXOR_RR] = 0x33,
+                    [VM_INT_OP_I32ADD_RR] = 0x03,
+                    [VM_INT_OP_I32SUB_RR] = 0x2B,
+                };
+                vm_int_opcode_t *at = head;
+                size_t out = vm_x64_read().reg;
+                size_t lhs = vm_x64_read().reg;
+                size_t rhs = vm_x64_read().reg;
+                vm_x64_load32(x64, VM_X64_RAX, lhs);
+                vm_x64_op_mem(x64, false, alu[op], VM_X64_RAX, rhs);
+                if (op == VM_INT_OP_I32ADD_RR || op == VM_INT_OP_I32SUB_RR) {
+                    vm_x64_overflow(x64, at, op == VM_INT_OP_I32ADD_RR ? 0x58 : 0x5C, out, false, lhs, false, rhs);
+                }
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32BOR_RI:
+            case VM_INT_OP_I32BAND_RI:
+            case VM_INT_OP_I32BXOR_RI:
+            case VM_INT_OP_I32ADD_RI:
+            case VM_INT_OP_I32SUB_RI: {
+                static const uint8_t ext[VM_INT_MAX_OP] = {
+                    [VM_INT_OP_I32BOR_RI] = 1,
+                    [VM_INT_OP_I32BAND_RI] = 4,
+                    [VM_INT_OP_I32BXOR_RI] = 6,
+                    [VM_INT_OP_I32ADD_RI] = 0,
+                    [VM_INT_OP_I32SUB_RI] = 5,
+                };
+                vm_int_opcode_t *at = head;
+                size_t out = vm_x64_read().reg;
+                size_t lhs = vm_x64_read().reg;
+                int32_t rhs = vm_x64_read().ival;
+                vm_x64_load32(x64, VM_X64_RAX, lhs);
+                vm_x64_alu_imm(x64, ext[op], VM_X64_RAX, rhs);
+                if (op == VM_INT_OP_I32ADD_RI || op == VM_INT_OP_I32SUB_RI) {
+                    vm_x64_overflow(x64, at, op == VM_INT_OP_I32ADD_RI ? 0x58 : 0x5C, out, false, lhs, true, rhs);
+                }
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32SUB_IR: {
+                vm_int_opcode_t *at = head;
+                size_t out = vm_x64_read().reg;
+                int32_t lhs = vm_x64_read().ival;
+                size_t rhs = vm_x64_read().reg;
+                vm_x64_load_imm(x64, VM_X64_RAX, (uint32_t)lhs);
+                vm_x64_op_mem(x64, false, 0x2B, VM_X64_RAX, rhs);
+                vm_x64_overflow(x64, at, 0x5C, out, true, lhs, false, rhs);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32MUL_RR: {
+                vm_int_opcode_t *at = head;
+                size_t out = vm_x64_read().reg;
+                size_t lhs = vm_x64_read().reg;
+                size_t rhs = vm_x64_read().reg;
+                vm_x64_load32(x64, VM_X64_RAX, lhs);
+                vm_x64_emit(x64, 0x0F, 0xAF);
+                vm_x64_modrm_mem(x64, VM_X64_RAX, rhs);
+                vm_x64_overflow(x64, at, 0x59, out, false, lhs, false, rhs);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32MUL_RI: {
+                vm_int_opcode_t *at = head;
+                size_t out = vm_x64_read().reg;
+                size_t lhs = vm_x64_read().reg;
+                int32_t rhs = vm_x64_read().ival;
+                vm_x64_byte(x64, 0x69);
+                vm_x64_modrm_mem(x64, VM_X64_RAX, lhs);
+                vm_x64_imm32(x64, rhs);
+                vm_x64_overflow(x64, at, 0x59, out, false, lhs, true, rhs);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32BSHL_RR:
+            case VM_INT_OP_I32BSHR_RR: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_load32(x64, VM_X64_RAX, vm_x64_read().reg);
+                vm_x64_load32(x64, VM_X64_RCX, vm_x64_read().reg);
+                vm_x64_emit(x64, 0xD3, op == VM_INT_OP_I32BSHL_RR ? 0xE0 : 0xF8);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32BSHL_RI:
+            case VM_INT_OP_I32BSHR_RI: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_load32(x64, VM_X64_RAX, vm_x64_read().reg);
+                uint8_t shift = (uint8_t)(vm_x64_read().ival & 31);
+                vm_x64_emit(x64, 0xC1, op == VM_INT_OP_I32BSHL_RI ? 0xE0 : 0xF8, shift);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_I32DIV_RR:
+            case VM_INT_OP_I32DIV_RI:
+            case VM_INT_OP_I32DIV_IR:
+            case VM_INT_OP_I32MOD_RR:
+            case VM_INT_OP_I32MOD_RI:
+            case VM_INT_OP_I32MOD_IR: {
+                size_t out = vm_x64_read().reg;
+                vm_int_opcode_t lhs = vm_x64_read();
+                vm_int_opcode_t rhs = vm_x64_read();
+                bool lhs_reg = op != VM_INT_OP_I32DIV_IR && op != VM_INT_OP_I32MOD_IR;
+                bool rhs_reg = op != VM_INT_OP_I32DIV_RI && op != VM_INT_OP_I32MOD_RI;
+                if (lhs_reg) {
+                    vm_x64_load32(x64, VM_X64_RAX, lhs.reg);
+                } else {
+                    vm_x64_load_imm(x64, VM_X64_RAX, (uint32_t)lhs.ival);
+                }
+                if (rhs_reg) {
+                    vm_x64_load32(x64, VM_X64_RCX, rhs.reg);
+                } else {
+                    vm_x64_load_imm(x64, VM_X64_RCX, (uint32_t)rhs.ival);
+                }
+                // cdq; idiv ecx
+                vm_x64_emit(x64, 0x99, 0xF7, 0xF9);
+                if (op == VM_INT_OP_I32MOD_RR || op == VM_INT_OP_I32MOD_RI || op == VM_INT_OP_I32MOD_IR) {
+                    vm_x64_emit(x64, 0x89, 0xD0);
+                    vm_x64_box_int(x64);
+                    vm_x64_store(x64, out, VM_X64_RAX);
+                    break;
+                }
+                vm_ir_block_t *next = vm_x64_read_wide().block;
+                head += 2 * VM_INT_WIDE;
+                // test edx, edx; jnz float
+                vm_x64_emit(x64, 0x85, 0xD2, 0x0F, 0x85);
+                size_t to_float = x64->len;
+                vm_x64_imm32(x64, 0);
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                vm_x64_jmp(x64, next);
+                vm_x64_patch(&x64->code[to_float], &x64->code[x64->len]);
+                if (lhs_reg) {
+                    vm_x64_load32(x64, VM_X64_RAX, lhs.reg);
+                } else {
+                    vm_x64_load_imm(x64, VM_X64_RAX, (uint32_t)lhs.ival);
+                }
+                // cvtsi2sd xmm0, eax; cvtsi2sd xmm1, ecx; divsd xmm0, xmm1
+                vm_x64_sse(x64, 0xF2, 0x2A, 0, VM_X64_RAX);
+                vm_x64_sse(x64, 0xF2, 0x2A, 1, VM_X64_RCX);
+                vm_x64_sse(x64, 0xF2, 0x5E, 0, 1);
+                vm_x64_store_float(x64, out, 0);
+                vm_x64_jmp(x64, next);
+                goto done;
+            }
+            case VM_INT_OP_I32BLT_RRTT:
+            case VM_INT_OP_I32BEQ_RRTT: {
+                vm_x64_load32(x64, VM_X64_RAX, vm_x64_read().reg);
+                vm_x64_op_mem(x64, false, 0x3B, VM_X64_RAX, vm_x64_read().reg);
+                vm_ir_block_t *iffalse = vm_x64_read_wide().block;
+                vm_ir_block_t *iftrue = vm_x64_read_wide().block;
+                vm_x64_jcc(x64, op == VM_INT_OP_I32BLT_RRTT ? VM_X64_CC_L : VM_X64_CC_E, iftrue);
+                vm_x64_jmp(x64, iffalse);
+                goto done;
+            }
+            case VM_INT_OP_I32BLT_RITT:
+            case VM_INT_OP_I32BEQ_RITT: {
+                vm_x64_load32(x64, VM_X64_RAX, vm_x64_read().reg);
+                vm_x64_alu_imm(x64, 7, VM_X64_RAX, vm_x64_read().ival);
+                vm_ir_block_t *iffalse = vm_x64_read_wide().block;
+                vm_ir_block_t *iftrue = vm_x64_read_wide().block;
+                vm_x64_jcc(x64, op == VM_INT_OP_I32BLT_RITT ? VM_X64_CC_L : VM_X64_CC_E, iftrue);
+                vm_x64_jmp(x64, iffalse);
+                goto done;
+            }
+            case VM_INT_OP_I32BLT_IRTT:
+            case VM_INT_OP_I32BEQ_IRTT: {
+                vm_x64_load_imm(x64, VM_X64_RAX, (uint32_t)vm_x64_read().ival);
+                vm_x64_op_mem(x64, false, 0x3B, VM_X64_RAX, vm_x64_read().reg);
+                vm_ir_block_t *iffalse = vm_x64_read_wide().block;
+                vm_ir_block_t *iftrue = vm_x64_read_wide().block;
+                vm_x64_jcc(x64, op == VM_INT_OP_I32BLT_IRTT ? VM_X64_CC_L : VM_X64_CC_E, iftrue);
+                vm_x64_jmp(x64, iffalse);
+                goto done;
+            }
+            case VM_INT_OP_FADD_RR:
+            case VM_INT_OP_FADD_RF:
+            case VM_INT_OP_FSUB_RR:
+            case VM_INT_OP_FSUB_RF:
+            case VM_INT_OP_FSUB_FR:
+            case VM_INT_OP_FMUL_RR:
+            case VM_INT_OP_FMUL_RF:
+            case VM_INT_OP_FDIV_RR:
+            case VM_INT_OP_FDIV_RF:
+            case VM_INT_OP_FDIV_FR:
+            case VM_INT_OP_FMOD_RR:
+            case VM_INT_OP_FMOD_RF:
+            case VM_INT_OP_FMOD_FR: {
+                static const uint8_t sse[VM_INT_MAX_OP] = {
+                    [VM_INT_OP_FADD_RR] = 0x58,
+                    [VM_INT_OP_FADD_RF] = 0x58,
+                    [VM_INT_OP_FSUB_RR] = 0x5C,
+                    [VM_INT_OP_FSUB_RF] = 0x5C,
+                    [VM_INT_OP_FSUB_FR] = 0x5C,
+                    [VM_INT_OP_FMUL_RR] = 0x59,
+                    [VM_INT_OP_FMUL_RF] = 0x59,
+                    [VM_INT_OP_FDIV_RR] = 0x5E,
+                    [VM_INT_OP_FDIV_RF] = 0x5E,
+                    [VM_INT_OP_FDIV_FR] = 0x5E,
+                };
+                size_t out = vm_x64_read().reg;
+                if (op == VM_INT_OP_FSUB_FR || op == VM_INT_OP_FDIV_FR || op == VM_INT_OP_FMOD_FR) {
+                    vm_x64_const_float(x64, 0, vm_x64_read_wide().fval);
+                    vm_x64_load_float(x64, 1, vm_x64_read().reg);
+                } else if (op == VM_INT_OP_FADD_RR || op == VM_INT_OP_FSUB_RR || op == VM_INT_OP_FMUL_RR || op == VM_INT_OP_FDIV_RR || op == VM_INT_OP_FMOD_RR) {
+                    vm_x64_load_float(x64, 0, vm_x64_read().reg);
+                    vm_x64_load_float(x64, 1, vm_x64_read().reg);
+                } else {
+                    vm_x64_load_float(x64, 0, vm_x64_read().reg);
+                    vm_x64_const_float(x64, 1, vm_x64_read_wide().fval);
+                }
+                if (sse[op] != 0) {
+                    vm_x64_sse(x64, 0xF2, sse[op], 0, 1);
+                } else {
+                    vm_x64_call_c(x64, fmod);
+                }
+                vm_x64_store_float(x64, out, 0);
+                break;
+            }
+            case VM_INT_OP_FBLT_RRTT:
+            case VM_INT_OP_FBLT_RFTT:
+            case VM_INT_OP_FBLT_FRTT:
+            case VM_INT_OP_FBEQ_RRTT:
+            case VM_INT_OP_FBEQ_RFTT:
+            case VM_INT_OP_FBEQ_FRTT: {
+                if (op == VM_INT_OP_FBLT_FRTT || op == VM_INT_OP_FBEQ_FRTT) {
+                    vm_x64_const_float(x64, 0, vm_x64_read_wide().fval);
+                    vm_x64_load_float(x64, 1, vm_x64_read().reg);
+                } else if (op == VM_INT_OP_FBLT_RFTT || op == VM_INT_OP_FBEQ_RFTT) {
+                    vm_x64_load_float(x64, 0, vm_x64_read().reg);
+                    vm_x64_const_float(x64, 1, vm_x64_read_wide().fval);
+                } else {
+                    vm_x64_load_float(x64, 0, vm_x64_read().reg);
+                    vm_x64_load_float(x64, 1, vm_x64_read().reg);
+                }
+                vm_ir_block_t *iffalse = vm_x64_read_wide().block;
+                vm_ir_block_t *iftrue = vm_x64_read_wide().block;
+                if (op == VM_INT_OP_FBLT_RRTT || op == VM_INT_OP_FBLT_RFTT || op == VM_INT_OP_FBLT_FRTT) {
+                    // ucomisd xmm1, xmm0; ja
+                    vm_x64_sse(x64, 0x66, 0x2E, 1, 0);
+                    vm_x64_jcc(x64, VM_X64_CC_A, iftrue);
+                    vm_x64_jmp(x64, iffalse);
+                } else {
+                    vm_x64_sse(x64, 0x66, 0x2E, 0, 1);
+                    vm_x64_jcc(x64, VM_X64_CC_NE, iffalse);
+                    vm_x64_jcc(x64, VM_X64_CC_P, iffalse);
+                    vm_x64_jmp(x64, iftrue);
+                }
+                goto done;
+            }
+            case VM_INT_OP_CALL_T0:
+            case VM_INT_OP_CALL_T1:
+            case VM_INT_OP_CALL_T2:
+            case VM_INT_OP_CALL_T3:
+            case VM_INT_OP_CALL_T4:
+            case VM_INT_OP_CALL_T5:
+            case VM_INT_OP_CALL_T6:
+            case VM_INT_OP_CALL_T7:
+            case VM_INT_OP_CALL_T8:
+            case VM_INT_OP_CALL_TN: {
+                vm_x64_call_check(x64);
+                vm_ir_block_t *func = vm_x64_read_wide().block;
+                size_t nargs = op == VM_INT_OP_CALL_TN ? (size_t)vm_x64_read().ival : op - VM_INT_OP_CALL_T0;
+                size_t fsize = head[nargs].reg;
+                vm_x64_copy_args(x64, &head, fsize, 1, nargs);
+                head += 1;
+                size_t out = vm_x64_read().reg;
+                vm_ir_block_t *next = vm_x64_read_types();
+                vm_x64_locals_add(x64, (ptrdiff_t)fsize);
+                vm_x64_byte(x64, 0xE8);
+                vm_x64_fixup(x64, VM_X64_FIXUP_LINK, x64->len, func);
+                vm_x64_imm32(x64, 0);
+                vm_x64_call_ret(x64, fsize, out, next);
+                goto done;
+            }
+            case VM_INT_OP_CALL_R0:
+            case VM_INT_OP_CALL_R1:
+            case VM_INT_OP_CALL_R2:
+            case VM_INT_OP_CALL_R3:
+            case VM_INT_OP_CALL_R4:
+            case VM_INT_OP_CALL_R5:
+            case VM_INT_OP_CALL_R6:
+            case VM_INT_OP_CALL_R7:
+            case VM_INT_OP_CALL_R8:
+            case VM_INT_OP_CALL_RN: {
+                vm_x64_call_check(x64);
+                vm_x64_load(x64, VM_X64_RCX, vm_x64_read().reg);
+                size_t nargs = op == VM_INT_OP_CALL_RN ? (size_t)vm_x64_read().ival : op - VM_INT_OP_CALL_R0;
+                size_t fsize = head[nargs].reg;
+                vm_x64_copy_args(x64, &head, fsize, 1, nargs);
+                head += 1;
+                size_t out = vm_x64_read().reg;
+                vm_ir_block_t *next = vm_x64_read_types();
+                vm_x64_locals_add(x64, (ptrdiff_t)fsize);
+                vm_x64_fixup(x64, VM_X64_FIXUP_CALL, x64->len, NULL);
+                // mov rax, block; cmp rcx, rax; jne slow; call code
+                vm_x64_emit(x64, 0x48, 0xB8);
+                vm_x64_imm64(x64, 0);
+                vm_x64_emit(x64, 0x48, 0x39, 0xC1, 0x0F, 0x85);
+                vm_x64_imm32(x64, 0);
+                vm_x64_byte(x64, 0xE8);
+                vm_x64_imm32(x64, 0);
+                vm_x64_call_ret(x64, fsize, out, next);
+                goto done;
+            }
+            case VM_INT_OP_CALL_C0:
+            case VM_INT_OP_CALL_C1:
+            case VM_INT_OP_CALL_C2:
+            case VM_INT_OP_CALL_C3:
+            case VM_INT_OP_CALL_C4:
+            case VM_INT_OP_CALL_C5:
+            case VM_INT_OP_CALL_C6:
+            case VM_INT_OP_CALL_C7:
+            case VM_INT_OP_CALL_CN: {
+                vm_x64_call_check(x64);
+                vm_x64_load(x64, VM_X64_RCX, vm_x64_read().reg);
+                size_t nargs = op == VM_INT_OP_CALL_CN ? (size_t)vm_x64_read().ival : op - VM_INT_OP_CALL_C0;
+                size_t fsize = head[nargs].reg;
+                vm_x64_store(x64, fsize + 1, VM_X64_RCX);
+                vm_x64_copy_args(x64, &head, fsize, 2, nargs);
+                head += 1;
+                size_t out = vm_x64_read().reg;
+                vm_ir_block_t *next = vm_x64_read_types();
+                vm_x64_locals_add(x64, (ptrdiff_t)fsize);
+                vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+                vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+                vm_x64_mov(x64, VM_X64_RDX, VM_X64_RCX);
+                vm_x64_call_c(x64, vm_x64_closure);
+                vm_x64_emit(x64, 0xFF, 0xD0);
+                vm_x64_call_ret(x64, fsize, out, next);
+                goto done;
+            }
+            case VM_INT_OP_TCALL_T: {
+                // the callee takes this frame over and returns to our caller
+                vm_ir_block_t *func = vm_x64_read_wide().block;
+                vm_x64_tail_args(x64, &head, 0);
+                vm_x64_jmp(x64, func);
+                goto done;
+            }
+            case VM_INT_OP_TCALL_R:
+            case VM_INT_OP_TCALL_C: {
+                // the callee waits past the frame too, a move can overwrite its register
+                size_t callee = vm_x64_read().reg;
+                size_t fsize = head[0].reg;
+                vm_x64_load(x64, VM_X64_RAX, callee);
+                vm_x64_store(x64, fsize, VM_X64_RAX);
+                vm_x64_tail_args(x64, &head, op == VM_INT_OP_TCALL_C ? 1 : 0);
+                vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+                vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+                vm_x64_load(x64, VM_X64_RDX, fsize);
+                if (op == VM_INT_OP_TCALL_C) {
+                    vm_x64_store(x64, 1, VM_X64_RDX);
+                    vm_x64_call_c(x64, vm_x64_closure);
+                } else {
+                    vm_x64_call_c(x64, vm_x64_func);
+                }
+                // jmp rax
+                vm_x64_emit(x64, 0xFF, 0xE0);
+                goto done;
+            }
+            case VM_INT_OP_CALL_X0:
+            case VM_INT_OP_CALL_X1:
+            case VM_INT_OP_CALL_X2:
+            case VM_INT_OP_CALL_X3:
+            case VM_INT_OP_CALL_X4:
+            case VM_INT_OP_CALL_X5:
+            case VM_INT_OP_CALL_X6:
+            case VM_INT_OP_CALL_X7:
+            case VM_INT_OP_CALL_X8:
+            case VM_INT_OP_CALL_XN: {
+                int32_t index = vm_x64_read().ival;
+                size_t nargs = op == VM_INT_OP_CALL_XN ? (size_t)vm_x64_read().ival : op - VM_INT_OP_CALL_X0;
+                vm_x64_copy_args(x64, &head, framesize, 1, nargs);
+                size_t out = vm_x64_read().reg;
+                vm_ir_block_t *next = vm_x64_read_types();
+                vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+                vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+                vm_x64_load_imm(x64, VM_X64_RDX, (uint32_t)index);
+                vm_x64_load_imm(x64, VM_X64_RCX, nargs);
+                vm_x64_call_c(x64, vm_x64_extern);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                vm_x64_jmp_typed(x64, next);
+                goto done;
+            }
+            case VM_INT_OP_ARR_F:
+            case VM_INT_OP_ARR_R: {
+                size_t out = vm_x64_read().reg;
+                if (op == VM_INT_OP_ARR_F) {
+                    vm_x64_load_imm(x64, VM_X64_RDX, vm_value_from_float(vm_x64_read_wide().fval).as_int64);
+                } else {
+                    vm_x64_load(x64, VM_X64_RDX, vm_x64_read().reg);
+                }
+                vm_x64_load_imm(x64, VM_X64_RCX, vm_x64_read().reg);
+                vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+                vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+                vm_x64_call_c(x64, vm_x64_arr);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_TAB: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_load_imm(x64, VM_X64_RDX, vm_x64_read().reg);
+                vm_x64_mov(x64, VM_X64_RDI, VM_X64_R12);
+                vm_x64_mov(x64, VM_X64_RSI, VM_X64_RBX);
+                vm_x64_call_c(x64, vm_x64_tab);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_SET_RRR:
+            case VM_INT_OP_SET_RRI:
+            case VM_INT_OP_SET_RIR:
+            case VM_INT_OP_SET_RII:
+            case VM_INT_OP_TSET_RRR:
+            case VM_INT_OP_TSET_RRF:
+            case VM_INT_OP_TSET_RFR:
+            case VM_INT_OP_TSET_RFF: {
+                bool key_reg = op == VM_INT_OP_SET_RRR || op == VM_INT_OP_SET_RRI || op == VM_INT_OP_TSET_RRR || op == VM_INT_OP_TSET_RRF;
+                bool val_reg = op == VM_INT_OP_SET_RRR || op == VM_INT_OP_SET_RIR || op == VM_INT_OP_TSET_RRR || op == VM_INT_OP_TSET_RFR;
+                vm_x64_load_imm(x64, VM_X64_RDI, (uint64_t)(size_t)&x64->state->gc);
+                vm_x64_load(x64, VM_X64_RSI, vm_x64_read().reg);
+                if (key_reg) {
+                    vm_x64_load(x64, VM_X64_RDX, vm_x64_read().reg);
+                } else {
+                    vm_x64_load_imm(x64, VM_X64_RDX, vm_value_from_float(vm_x64_read_wide().fval).as_int64);
+                }
+                if (val_reg) {
+                    vm_x64_load(x64, VM_X64_RCX, vm_x64_read().reg);
+                } else {
+                    vm_x64_load_imm(x64, VM_X64_RCX, vm_value_from_float(vm_x64_read_wide().fval).as_int64);
+                }
+                if (op >= VM_INT_OP_TSET_RRR) {
+                    vm_x64_call_c(x64, vm_x64_tset);
+                } else {
+                    vm_x64_call_c(x64, vm_gc_set);
+                }
+                break;
+            }
+            case VM_INT_OP_GET_RR:
+            case VM_INT_OP_GET_RI:
+            case VM_INT_OP_TGET_RR:
+            case VM_INT_OP_TGET_RF: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_load(x64, VM_X64_RDI, vm_x64_read().reg);
+                if (op == VM_INT_OP_GET_RR || op == VM_INT_OP_TGET_RR) {
+                    vm_x64_load(x64, VM_X64_RSI, vm_x64_read().reg);
+                } else {
+                    vm_x64_load_imm(x64, VM_X64_RSI, vm_value_from_float(vm_x64_read_wide().fval).as_int64);
+                }
+                vm_ir_block_t *next = vm_x64_read_types();
+                if (op == VM_INT_OP_GET_RR || op == VM_INT_OP_GET_RI) {
+                    vm_x64_call_c(x64, vm_x64_get);
+                } else {
+                    vm_x64_call_c(x64, vm_x64_tget);
+                }
+                vm_x64_store(x64, out, VM_X64_RAX);
+                vm_x64_jmp_typed(x64, next);
+                goto done;
+            }
+            case VM_INT_OP_LEN_R: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_load(x64, VM_X64_RAX, vm_x64_read().reg);
+                // mov eax, [rax + len]
+                vm_x64_emit(x64, 0x8B, 0x40, (uint8_t)offsetof(vm_value_array_t, len));
+                vm_x64_box_int(x64);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_IN_V: {
+                size_t out = vm_x64_read().reg;
+                vm_x64_call_c(x64, vm_x64_in);
+                vm_x64_store(x64, out, VM_X64_RAX);
+                break;
+            }
+            case VM_INT_OP_OUT_I: {
+                vm_x64_load_imm(x64, VM_X64_RDI, (uint32_t)vm_x64_read().ival);
+                vm_x64_call_c(x64, vm_x64_out);
+                break;
+            }
+            case VM_INT_OP_OUT_R: {
+                vm_x64_load_float(x64, 0, vm_x64_read().reg);
+                // cvttsd2si edi, xmm0
+                vm_x64_sse(x64, 0xF2, 0x2C, VM_X64_RDI, 0);
+                vm_x64_call_c(x64, vm_x64_out);
+                break;
+            }
+            case VM_INT_OP_JUMP_T: {
+                vm_x64_jmp(x64, vm_x64_read_wide().block);
+                goto done;
+            }
+            case VM_INT_OP_BB_RTT: {
+                size_t reg = vm_x64_read().reg;
+                vm_ir_block_t *iffalse = vm_x64_read_wide().block;
+                vm_ir_block_t *iftrue = vm_x64_read_wide().block;
+                // test byte [reg], 1
+                vm_x64_byte(x64, 0xF6);
+                vm_x64_modrm_mem(x64, 0, reg);
+                vm_x64_byte(x64, 0x01);
+                vm_x64_jcc(x64, VM_X64_CC_NE, iftrue);
+                vm_x64_jmp(x64, iffalse);
+                goto done;
+            }
+            case VM_INT_OP_RET_I: {
+                vm_x64_load_imm(x64, VM_X64_RAX, vm_value_from_int(vm_x64_read().ival).as_int64);
+                vm_x64_ret(x64, VM_TYPE_I32);
+                goto done;
+            }
+            case VM_INT_OP_RET_F: {
+                vm_x64_load_imm(x64, VM_X64_RAX, vm_value_from_float(vm_x64_read_wide().fval).as_int64);
+                vm_x64_ret(x64, VM_TYPE_F64);
+                goto done;
+            }
+            case VM_INT_OP_RET_RV: {
+                vm_x64_load_imm(x64, VM_X64_RAX, vm_value_nil().as_int64);
+                vm_x64_ret(x64, VM_TYPE_NIL);
+                goto done;
+            }
+            case VM_INT_OP_RET_RB:
+            case VM_INT_OP_RET_RI:
+            case VM_INT_OP_RET_RIF:
+            case VM_INT_OP_RET_RA:
+            case VM_INT_OP_RET_RT: {
+                static const uint8_t rtypes[VM_INT_MAX_OP] = {
+                    [VM_INT_OP_RET_RB] = VM_TYPE_BOOL,
+                    [VM_INT_OP_RET_RI] = VM_TYPE_I32,
+                    [VM_INT_OP_RET_RIF] = VM_TYPE_F64,
+                    [VM_INT_OP_RET_RA] = VM_TYPE_ARRAY,
+                    [VM_INT_OP_RET_RT] = VM_TYPE_TABLE,
+                };
+                vm_x64_load(x64, VM_X64_RAX, vm_x64_read().reg);
+                vm_x64_ret(x64, rtypes[op]);
+                goto done;
+            }
+            case VM_INT_OP_RET_RF: {
+                // floats and funcs share this op, tell them apart by the box tag
+                vm_x64_load(x64, VM_X64_RAX, vm_x64_read().reg);
+                vm_x64_load_imm(x64, VM_X64_RDX, VM_TYPE_F64);
+                vm_x64_mov(x64, VM_X64_RCX, VM_X64_RAX);
+                // shr rcx, 48; jnz ret; mov edx, func; ret
+                vm_x64_emit(x64, 0x48, 0xC1, 0xE9, 48, 0x75, 5);
+                vm_x64_load_imm(x64, VM_X64_RDX, VM_TYPE_FUNC);
+                vm_x64_byte(x64, 0xC3);
+                goto done;
+            }
+            default: {
+                fprintf(stderr, "x64: cannot translate op: %zu\n", op);
+                __builtin_trap();
+            }
+        }
+    }
+done:
+    for (size_t i = 0; i < x64->nfixups; i++) {
+        vm_x64_reserve(x64, 256);
+        vm_x64_stub(x64, x64->fixups[i]);
+    }
+    x64->nfixups = 0;
+    vm_x64_cache_set(x64, ops, code);
+    return code;
+}
+
+static void vm_x64_init(vm_x64_t *x64, vm_int_state_t *state, uint8_t *mem, size_t alloc, uint8_t *stack) {
+    *x64 = (vm_x64_t){0};
+    x64->state = state;
+    x64->code = mem;
+    x64->alloc = alloc;
+    // the margin is for the c helpers called from the deepest frame
+    x64->rsp_min = stack + VM_CONFIG_X64_NATIVE_MARGIN;
+    x64->limit = state->gc.limit;
+    // superinstructions stay NULL so vm_int_block_comp never emits them here
+    for (size_t i = 0; i < VM_INT_OP_DEBUG_PRINT_INSTRS; i++) {
+        x64->ptrs[i] = &vm_x64_tags[i];
+    }
+    for (size_t i = VM_INT_OP_TCALL_T; i <= VM_INT_OP_TCALL_C; i++) {
+        x64->ptrs[i] = &vm_x64_tags[i];
+    }
+    int32_t exit_rsp = (int32_t)offsetof(vm_x64_t, exit_rsp);
+    // push rbp, rbx, r12, r13, r14, r15
+    vm_x64_emit(x64, 0x55, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57);
+    vm_x64_mov(x64, VM_X64_R12, VM_X64_RDI);
+    vm_x64_mov(x64, VM_X64_RBX, VM_X64_RSI);
+    vm_x64_load_imm(x64, VM_X64_R13, 0x0007000000000000llu);
+    vm_x64_load_imm(x64, VM_X64_R14, 0x0006000000000000llu);
+    // mov [r12 + exit_rsp], rsp; mov rsp, rcx; call rdx
+    vm_x64_emit(x64, 0x49, 0x89, 0xA4, 0x24);
+    vm_x64_imm32(x64, exit_rsp);
+    vm_x64_mov(x64, VM_X64_RSP, VM_X64_RCX);
+    vm_x64_emit(x64, 0xFF, 0xD2);
+    x64->exit = &x64->code[x64->len];
+    // mov rsp, [r12 + exit_rsp]
+    vm_x64_emit(x64, 0x49, 0x8B, 0xA4, 0x24);
+    vm_x64_imm32(x64, exit_rsp);
+    // pop r15, r14, r13, r12, rbx, rbp; ret
+    vm_x64_emit(x64, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D, 0xC3);
+    x64->stack_overflow = &x64->code[x64->len];
+    vm_x64_call_c(x64, vm_x64_stack_overflow);
+}
+
+vm_value_t vm_x64_run(vm_int_state_t *state, vm_ir_block_t *block) {
+    // instruction tracing only exists in the interpreter
+    if (state->debug_print_instrs != NULL || state->use_spall || state->pair_counts != NULL || state->block_counts != NULL || state->sample != NULL) {
+        return vm_int_run(state, block);
+    }
+    size_t alloc = VM_CONFIG_X64_CODE_SIZE;
+    void *mem = mmap(NULL, alloc, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (mem == MAP_FAILED) {
+        return vm_int_run(state, block);
+    }
+    // vm calls are native calls, so the code runs on a stack sized like the
+    // interpreter's instead of whatever the process was given
+    size_t nstack = VM_CONFIG_X64_NATIVE_STACK;
+    void *stack = mmap(NULL, nstack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+    if (stack == MAP_FAILED) {
+        munmap(mem, alloc);
+        return vm_int_run(state, block);
+    }
+    vm_int_stack_limit(state);
+    vm_x64_t x64;
+    vm_x64_init(&x64, state, mem, alloc, stack);
+    // the stack can move while running, so the frame is restored by index
+    size_t locals_at = (size_t)(state->locals - state->stack);
+    void *code = vm_x64_block_comp(&x64, block);
+    // iso c has no cast from data to code pointers
+    vm_x64_enter_t enter;
+    memcpy(&enter, &x64.code, sizeof(enter));
+    enter(&x64, state->stack + locals_at, code, (uint8_t *)stack + nstack);
+    state->locals = state->stack + locals_at;
+    munmap(stack, nstack);
+    munmap(mem, alloc);
+    vm_free(x64.cache_keys);
+    vm_free(x64.cache_values);
+    vm_free(x64.fixups);
+    return vm_value_nil();
+}
+
+#else
+
+vm_value_t vm_x64_run(vm_int_state_t *state, vm_ir_block_t *block) {
+    return vm_int_run(state, block);
+}
+
+#endif
+
+vm_value_t vm_ir_be_x64(size_t nblocks, vm_ir_block_t *blocks, vm_int_func_t *funcs) {
+    vm_ir_block_t *cur = &blocks[0];
+    vm_int_state_t state = (vm_int_state_t){0};
+    state.funcs = funcs;
+    state.inline_budget = VM_INT_INLINE_BUDGET;
+    vm_int_stack_init(&state, nblocks, blocks);
+    vm_gc_init(&state.gc, state.framesize * state.stack_frames, state.stack);
+    vm_value_t ret = vm_x64_run(&state, cur);
+    vm_gc_deinit(&state.gc);
+    vm_int_stack_deinit(&state);
+    return ret;
+}
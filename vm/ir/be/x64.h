@@ -0,0 +1,12 @@
+#if !defined(VM_HEADER_IR_BE_X64)
+#define VM_HEADER_IR_BE_X64
+
+#include "int3.h"
+
+/// native x86-64 template jit built on top of the int3 block versions
+/// falls back to vm_int_run on hosts that cannot map executable memory
+
+vm_value_t vm_x64_run(vm_int_state_t *state, vm_ir_block_t *block);
+vm_value_t vm_ir_be_x64(size_t nblocks, vm_ir_block_t *blocks, vm_int_func_t *funcs);
+
+#endif
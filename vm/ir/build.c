@@ -9,6 +9,15 @@ void vm_ir_block_realloc(vm_ir_block_t *block, vm_ir_instr_t *instr) {
     block->instrs[block->len++] = instr;
 }
 
+// every instr has room for at least 8 args, calls for all of theirs, and
+// there is always a none after the last
+vm_ir_instr_t *vm_ir_instr_new(size_t nargs) {
+    if (nargs < 8) {
+        nargs = 8;
+    }
+    return vm_alloc0(sizeof(vm_ir_instr_t) + sizeof(vm_ir_arg_t) * (nargs + 1));
+}
+
 vm_ir_arg_t vm_ir_arg_nil(void) { return (vm_ir_arg_t){.type = VM_IR_ARG_NIL}; }
 vm_ir_arg_t vm_ir_arg_bool(bool t) { return (vm_ir_arg_t){.type = VM_IR_ARG_BOOL, .logic = t}; }
 vm_ir_arg_t vm_ir_arg_reg(size_t reg) { return (vm_ir_arg_t){.type = VM_IR_ARG_REG, .reg = reg}; }
@@ -22,7 +31,7 @@ vm_ir_arg_t vm_ir_arg_num(double num) { return (vm_ir_arg_t){.type = VM_IR_ARG_N
 vm_ir_arg_t vm_ir_arg_str(const char *str) { return (vm_ir_arg_t){.type = VM_IR_ARG_STR, .str = str}; }
 
 void vm_ir_block_add_move(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t arg) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_MOVE;
     instr->out = out;
     instr->args[0] = arg;
@@ -30,7 +39,7 @@ void vm_ir_block_add_move(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t arg
 }
 
 void vm_ir_block_add_add(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_ADD;
     instr->out = out;
     instr->args[0] = lhs;
@@ -38,7 +47,7 @@ void vm_ir_block_add_add(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_sub(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_SUB;
     instr->out = out;
     instr->args[0] = lhs;
@@ -46,7 +55,7 @@ void vm_ir_block_add_sub(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_mul(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_MUL;
     instr->out = out;
     instr->args[0] = lhs;
@@ -54,7 +63,7 @@ void vm_ir_block_add_mul(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_div(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_DIV;
     instr->out = out;
     instr->args[0] = lhs;
@@ -62,7 +71,7 @@ void vm_ir_block_add_div(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_mod(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_MOD;
     instr->out = out;
     instr->args[0] = lhs;
@@ -70,7 +79,7 @@ void vm_ir_block_add_mod(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_bor(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_BOR;
     instr->out = out;
     instr->args[0] = lhs;
@@ -78,7 +87,7 @@ void vm_ir_block_add_bor(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_band(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_BAND;
     instr->out = out;
     instr->args[0] = lhs;
@@ -86,7 +95,7 @@ void vm_ir_block_add_band(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_bxor(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_BXOR;
     instr->out = out;
     instr->args[0] = lhs;
@@ -94,7 +103,7 @@ void vm_ir_block_add_bxor(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_bshl(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_BSHL;
     instr->out = out;
     instr->args[0] = lhs;
@@ -102,7 +111,7 @@ void vm_ir_block_add_bshl(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_bshr(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_BSHR;
     instr->out = out;
     instr->args[0] = lhs;
@@ -110,7 +119,7 @@ void vm_ir_block_add_bshr(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_call(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t func, size_t nargs, vm_ir_arg_t *args) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(nargs + 1);
     instr->op = VM_IR_IOP_CALL;
     instr->out = out;
     instr->args[0] = func;
@@ -121,20 +130,20 @@ void vm_ir_block_add_call(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t fun
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_arr(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t num) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_ARR;
     instr->out = out;
     instr->args[0] = num;
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_tab(vm_ir_block_t *block, vm_ir_arg_t out) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_TAB;
     instr->out = out;
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_get(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t obj, vm_ir_arg_t index) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_GET;
     instr->out = out;
     instr->args[0] = obj;
@@ -142,21 +151,21 @@ void vm_ir_block_add_get(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t obj,
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_len(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t obj) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_LEN;
     instr->out = out;
     instr->args[0] = obj;
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_type(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t obj) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_TYPE;
     instr->out = out;
     instr->args[0] = obj;
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_set(vm_ir_block_t *block, vm_ir_arg_t obj, vm_ir_arg_t index, vm_ir_arg_t value) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_SET;
     instr->args[0] = obj;
     instr->args[1] = index;
@@ -164,13 +173,13 @@ void vm_ir_block_add_set(vm_ir_block_t *block, vm_ir_arg_t obj, vm_ir_arg_t inde
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_out(vm_ir_block_t *block, vm_ir_arg_t arg) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_OUT;
     instr->args[0] = arg;
     vm_ir_block_realloc(block, instr);
 }
 void vm_ir_block_add_in(vm_ir_block_t *block, vm_ir_arg_t arg) {
-    vm_ir_instr_t *instr = vm_alloc0(sizeof(vm_ir_instr_t));
+    vm_ir_instr_t *instr = vm_ir_instr_new(0);
     instr->op = VM_IR_IOP_IN;
     instr->out = arg;
     vm_ir_block_realloc(block, instr);
@@ -228,6 +237,7 @@ void vm_ir_block_free(vm_ir_block_t *block) {
     }
     vm_free(block->instrs);
     vm_free(block->args);
+    vm_free(block->body);
 }
 
 void vm_ir_blocks_free(size_t nblocks, vm_ir_block_t *blocks) {
@@ -365,6 +375,10 @@ void vm_ir_print_instr(FILE *out, vm_ir_instr_t *val) {
             fprintf(out, "call");
             break;
         }
+        case VM_IR_IOP_TCALL: {
+            fprintf(out, "tcall");
+            break;
+        }
         case VM_IR_IOP_ARR: {
             fprintf(out, "arr");
             break;
@@ -18,6 +18,7 @@ vm_ir_arg_t vm_ir_arg_str(const char *str);
 vm_ir_arg_t vm_ir_arg_func(vm_ir_block_t *func);
 
 void vm_ir_block_realloc(vm_ir_block_t *block, vm_ir_instr_t *instr);
+vm_ir_instr_t *vm_ir_instr_new(size_t nargs);
 
 void vm_ir_block_add_move(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t arg);
 void vm_ir_block_add_add(vm_ir_block_t *block, vm_ir_arg_t out, vm_ir_arg_t lhs, vm_ir_arg_t rhs);
@@ -33,7 +33,7 @@ void vm_ir_opt_const(size_t nops, vm_ir_block_t *blocks) {
                             named[arg.reg] = VM_IR_OPT_CONST_REG_NEEDED;
                         }
                     }
-                    if (instr->op != VM_IR_IOP_CALL) {
+                    if (instr->op != VM_IR_IOP_CALL && instr->op != VM_IR_IOP_TCALL) {
                         instr->args[k] = arg;
                     }
                 }
@@ -143,13 +143,13 @@ void vm_ir_opt_dead(size_t nops, vm_ir_block_t *blocks) {
             uint8_t outp = 1;
             if (instr->out.type == VM_IR_ARG_REG) {
                 outp = ptrs[instr->out.reg];
-                if (outp == 0 && instr->op != VM_IR_IOP_CALL) {
+                if (outp == 0 && instr->op != VM_IR_IOP_CALL && instr->op != VM_IR_IOP_TCALL) {
                     // block->instrs[j] = vm_ir_new(vm_ir_instr_t, .op = VM_IR_IOP_NOP);
                     block->instrs[j]->op = VM_IR_IOP_NOP;
                 }
                 ptrs[instr->out.reg] = 0;
-            } else if (instr->op != VM_IR_IOP_CALL && instr->op != VM_IR_IOP_SET &&
-                       instr->op != VM_IR_IOP_OUT) {
+            } else if (instr->op != VM_IR_IOP_CALL && instr->op != VM_IR_IOP_TCALL &&
+                       instr->op != VM_IR_IOP_SET && instr->op != VM_IR_IOP_OUT) {
                 instr->op = VM_IR_IOP_NOP;
             }
             if (instr->op == VM_IR_IOP_NOP) {
@@ -44,6 +44,7 @@ enum {
     VM_IR_IOP_DIV,
     VM_IR_IOP_MOD,
     VM_IR_IOP_CALL,
+    VM_IR_IOP_TCALL,
     VM_IR_IOP_ARR,
     VM_IR_IOP_TAB,
     VM_IR_IOP_GET,
@@ -87,9 +88,10 @@ struct vm_ir_branch_t {
 };
 
 struct vm_ir_instr_t {
-    vm_ir_arg_t args[9];
     vm_ir_arg_t out;
     uint8_t op;
+    // none terminated, see vm_ir_instr_new for how many there is room for
+    vm_ir_arg_t args[];
 };
 
 struct vm_ir_block_t {
@@ -110,6 +112,12 @@ struct vm_ir_block_t {
 
     void *data;
 
+    // innermost loop head this block is in, see loop.c
+    vm_ir_block_t *loop;
+    // for loop heads, every block in the loop
+    vm_ir_block_t **body;
+    size_t nbody;
+
     bool isfunc : 1;
 };
 
@@ -0,0 +1,152 @@
+#include "loop.h"
+
+#include "build.h"
+
+enum {
+    VM_IR_LOOP_NEW,
+    VM_IR_LOOP_OPEN,
+    VM_IR_LOOP_DONE,
+};
+
+// the loop of a head is the head plus every block that can reach one of
+// its back edges without going through the head again
+static void vm_ir_loops_body(vm_ir_block_t *blocks, size_t *starts, size_t *preds, size_t *mark, size_t *work,
+                             vm_ir_block_t *head, size_t nsrcs, size_t *srcs) {
+    size_t gen = (size_t)head->id + 1;
+    size_t alloc = 8;
+    head->body = vm_malloc(sizeof(vm_ir_block_t *) * alloc);
+    head->body[head->nbody++] = head;
+    mark[head->id] = gen;
+    size_t nwork = 0;
+    for (size_t i = 0; i < nsrcs; i++) {
+        if (mark[srcs[i]] != gen) {
+            mark[srcs[i]] = gen;
+            work[nwork++] = srcs[i];
+        }
+    }
+    while (nwork != 0) {
+        size_t cur = work[--nwork];
+        if (head->nbody + 1 >= alloc) {
+            alloc *= 2;
+            head->body = vm_realloc(head->body, sizeof(vm_ir_block_t *) * alloc);
+        }
+        head->body[head->nbody++] = &blocks[cur];
+        for (size_t i = starts[cur]; i < starts[cur + 1]; i++) {
+            if (mark[preds[i]] != gen) {
+                mark[preds[i]] = gen;
+                work[nwork++] = preds[i];
+            }
+        }
+    }
+}
+
+void vm_ir_loops(size_t nops, vm_ir_block_t *blocks) {
+    // predecessors of every block, packed by target
+    size_t *starts = vm_alloc0(sizeof(size_t) * (nops + 1));
+    for (size_t i = 0; i < nops; i++) {
+        vm_ir_block_t *block = &blocks[i];
+        if (block->id < 0) {
+            continue;
+        }
+        for (size_t t = 0; t < 2; t++) {
+            if (block->branch->targets[t] != NULL) {
+                starts[block->branch->targets[t]->id + 1] += 1;
+            }
+        }
+    }
+    for (size_t i = 0; i < nops; i++) {
+        starts[i + 1] += starts[i];
+    }
+    size_t *preds = vm_malloc(sizeof(size_t) * (starts[nops] + 1));
+    size_t *fill = vm_malloc(sizeof(size_t) * (nops + 1));
+    memcpy(fill, starts, sizeof(size_t) * (nops + 1));
+    for (size_t i = 0; i < nops; i++) {
+        vm_ir_block_t *block = &blocks[i];
+        if (block->id < 0) {
+            continue;
+        }
+        for (size_t t = 0; t < 2; t++) {
+            if (block->branch->targets[t] != NULL) {
+                preds[fill[block->branch->targets[t]->id]++] = i;
+            }
+        }
+    }
+    vm_free(fill);
+    // depth first, an edge back to a block still open is a back edge
+    uint8_t *state = vm_alloc0(sizeof(uint8_t) * nops);
+    uint8_t *next = vm_alloc0(sizeof(uint8_t) * nops);
+    size_t *stack = vm_malloc(sizeof(size_t) * (nops + 1));
+    size_t *backs = vm_malloc(sizeof(size_t) * (starts[nops] + 1) * 2);
+    size_t nbacks = 0;
+    for (size_t root = 0; root < nops; root++) {
+        if (blocks[root].id < 0 || state[root] != VM_IR_LOOP_NEW) {
+            continue;
+        }
+        size_t depth = 0;
+        stack[depth++] = root;
+        state[root] = VM_IR_LOOP_OPEN;
+        while (depth != 0) {
+            size_t cur = stack[depth - 1];
+            if (next[cur] == 2) {
+                state[cur] = VM_IR_LOOP_DONE;
+                depth -= 1;
+                continue;
+            }
+            vm_ir_block_t *target = blocks[cur].branch->targets[next[cur]++];
+            if (target == NULL) {
+                continue;
+            }
+            size_t tid = (size_t)target->id;
+            if (state[tid] == VM_IR_LOOP_NEW) {
+                state[tid] = VM_IR_LOOP_OPEN;
+                stack[depth++] = tid;
+            } else if (state[tid] == VM_IR_LOOP_OPEN) {
+                backs[nbacks++] = tid;
+                backs[nbacks++] = cur;
+            }
+        }
+    }
+    vm_free(next);
+    vm_free(state);
+    // one loop per head, no matter how many back edges it has
+    size_t *mark = vm_alloc0(sizeof(size_t) * nops);
+    size_t *srcs = vm_malloc(sizeof(size_t) * (nbacks / 2 + 1));
+    for (size_t i = 0; i < nbacks; i += 2) {
+        vm_ir_block_t *head = &blocks[backs[i]];
+        if (head->body != NULL) {
+            continue;
+        }
+        size_t nsrcs = 0;
+        for (size_t j = i; j < nbacks; j += 2) {
+            if (backs[j] == backs[i]) {
+                srcs[nsrcs++] = backs[j + 1];
+            }
+        }
+        vm_ir_loops_body(blocks, starts, preds, mark, stack, head, nsrcs, srcs);
+    }
+    vm_free(srcs);
+    vm_free(mark);
+    vm_free(stack);
+    vm_free(preds);
+    vm_free(starts);
+    // loops either nest or are disjoint, so the smallest one is innermost
+    for (size_t i = 0; i < nbacks; i += 2) {
+        vm_ir_block_t *head = &blocks[backs[i]];
+        for (size_t j = 0; j < head->nbody; j++) {
+            vm_ir_block_t *block = head->body[j];
+            if (block->loop == NULL || block->loop->nbody > head->nbody) {
+                block->loop = head;
+            }
+        }
+    }
+    vm_free(backs);
+}
+
+bool vm_ir_in_loop(vm_ir_block_t *head, vm_ir_block_t *block) {
+    for (size_t i = 0; i < head->nbody; i++) {
+        if (head->body[i]->id == block->id) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,9 @@
+#if !defined(VM_HEADER_IR_LOOP)
+#define VM_HEADER_IR_LOOP
+
+#include "ir.h"
+
+void vm_ir_loops(size_t nops, vm_ir_block_t *blocks);
+bool vm_ir_in_loop(vm_ir_block_t *head, vm_ir_block_t *block);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "build.h"
 #include "const.h"
+#include "loop.h"
 
 enum {
     VM_BREAK = 1,
@@ -412,6 +413,37 @@ vm_break:
     goto redo;
 }
 
+#if VM_IR_TAIL_CALLS
+// a call whose block jumps straight to a ret of its result becomes a tcall;
+// the jump stays, so a backend can treat tcall as a plain call
+static void vm_ir_tail_calls(size_t nops, vm_ir_block_t *blocks) {
+    for (size_t i = 0; i < nops; i++) {
+        vm_ir_block_t *block = &blocks[i];
+        if (block->id < 0 || block->len == 0 || block->branch->op != VM_IR_BOP_JUMP) {
+            continue;
+        }
+        vm_ir_instr_t *call = block->instrs[block->len - 1];
+        if (call->op != VM_IR_IOP_CALL || call->args[0].type == VM_IR_ARG_EXTERN || call->out.type != VM_IR_ARG_REG) {
+            continue;
+        }
+        vm_ir_block_t *next = block->branch->targets[0];
+        if (next->branch->op != VM_IR_BOP_RET || next->branch->args[0].type != VM_IR_ARG_REG || next->branch->args[0].reg != call->out.reg) {
+            continue;
+        }
+        bool empty = true;
+        for (size_t j = 0; j < next->len; j++) {
+            if (next->instrs[j]->op != VM_IR_IOP_NOP) {
+                empty = false;
+                break;
+            }
+        }
+        if (empty) {
+            call->op = VM_IR_IOP_TCALL;
+        }
+    }
+}
+#endif
+
 vm_ir_block_t *vm_ir_parse(size_t nops, const vm_opcode_t *ops) {
     size_t index = 0;
     vm_ir_block_t *blocks = vm_malloc(sizeof(vm_ir_block_t) * nops);
@@ -444,5 +476,9 @@ vm_ir_block_t *vm_ir_parse(size_t nops, const vm_opcode_t *ops) {
     }
     vm_ir_opt_const(nops, blocks);
     vm_ir_opt_dead(nops, blocks);
+#if VM_IR_TAIL_CALLS
+    vm_ir_tail_calls(nops, blocks);
+#endif
+    vm_ir_loops(nops, blocks);
     return &blocks[0];
 }